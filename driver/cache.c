@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2026 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * The output cache saves the output of the compiler so that a later
+ * compile of exactly the same design does not need to run the
+ * compiler at all. It works on the whole compile: there is one key
+ * for all the source files together, so a change to any one of them
+ * runs the whole compile again. Nothing is cached per source file.
+ * The key of a compile is a hash of the preprocessed source, the
+ * iconfig file that holds the flags for the compiler, and the files
+ * that the iconfig file names (the system function tables and the
+ * library files) and the target configuration file.
+ *
+ * Library directories (-y) and dependency files (-M) are not
+ * supported, since the compiler reads files from those that the key
+ * does not know about. In that case the key cannot be made, and the
+ * compile runs as usual.
+ */
+
+# include  <string.h>
+# include  <stdlib.h>
+# include  <stdio.h>
+# include  <unistd.h>
+# include  <sys/types.h>
+# include  <sys/stat.h>
+# include  "ivl_alloc.h"
+# include  "globals.h"
+
+/* This is the 64 bit FNV-1a hash. */
+static void cache_hash(unsigned long long*hash, const void*buf, size_t len)
+{
+      const unsigned char*cp = (const unsigned char*)buf;
+      unsigned long long val = *hash;
+
+      while (len > 0) {
+	    val ^= *cp;
+	    val *= 0x100000001b3ULL;
+	    cp += 1;
+	    len -= 1;
+      }
+
+      *hash = val;
+}
+
+static int cache_hash_file(unsigned long long*hash, const char*path)
+{
+      char buf[64*1024];
+      size_t cnt;
+      FILE*fd = fopen(path, "rb");
+      if (fd == 0)
+	    return -1;
+
+      while ((cnt = fread(buf, 1, sizeof buf, fd)) > 0)
+	    cache_hash(hash, buf, cnt);
+
+      fclose(fd);
+      return 0;
+}
+
+/*
+ * The iconfig file is hashed line by line. The lines that name other
+ * files also hash the contents of those files. Some lines refer to
+ * temporary files or to the output, so they are left out.
+ */
+static int cache_hash_iconfig(unsigned long long*hash, const char*path)
+{
+      char line[8192];
+      FILE*fd = fopen(path, "r");
+      if (fd == 0)
+	    return -1;
+
+      while (fgets(line, sizeof line, fd)) {
+	    char*eol = strchr(line, '\n');
+	    if (eol) *eol = 0;
+
+	    if (strncmp(line, "-y:", 3) == 0
+		|| strncmp(line, "-yl:", 4) == 0
+		|| strncmp(line, "depfile:", 8) == 0) {
+		  fclose(fd);
+		  return -1;
+	    }
+
+	    if (strncmp(line, "ivlpp:", 6) == 0
+		|| strncmp(line, "out:", 4) == 0)
+		  continue;
+
+	    cache_hash(hash, line, strlen(line)+1);
+
+	    if (strncmp(line, "sys_func:", 9) == 0) {
+		  if (cache_hash_file(hash, line+9) < 0) {
+			fclose(fd);
+			return -1;
+		  }
+	    } else if (strncmp(line, "library_file:", 13) == 0) {
+		  if (cache_hash_file(hash, line+13) < 0) {
+			fclose(fd);
+			return -1;
+		  }
+	    }
+      }
+
+      fclose(fd);
+      return 0;
+}
+
+int output_cache_key(char key[17], const char*version, const char*pp_path,
+		      const char*iconfig_path, const char*conf_path)
+{
+      unsigned long long hash = 0xcbf29ce484222325ULL;
+
+      cache_hash(&hash, version, strlen(version)+1);
+      if (cache_hash_file(&hash, conf_path) < 0)
+	    return -1;
+      if (cache_hash_iconfig(&hash, iconfig_path) < 0)
+	    return -1;
+      if (cache_hash_file(&hash, pp_path) < 0)
+	    return -1;
+
+      snprintf(key, 17, "%016llx", hash);
+      return 0;
+}
+
+static int cache_copy(const char*src, const char*dst)
+{
+      char buf[64*1024];
+      size_t cnt;
+      struct stat sb;
+      FILE*ifd, *ofd;
+      int rc = 0;
+
+      ifd = fopen(src, "rb");
+      if (ifd == 0)
+	    return -1;
+      ofd = fopen(dst, "wb");
+      if (ofd == 0) {
+	    fclose(ifd);
+	    return -1;
+      }
+
+      while ((cnt = fread(buf, 1, sizeof buf, ifd)) > 0) {
+	    if (fwrite(buf, 1, cnt, ofd) != cnt) {
+		  rc = -1;
+		  break;
+	    }
+      }
+
+      fclose(ifd);
+      if (fclose(ofd) != 0)
+	    rc = -1;
+
+	/* The vvp output is executable, so keep the mode. */
+      if (rc == 0 && stat(src, &sb) == 0)
+	    chmod(dst, sb.st_mode & 0777);
+
+      return rc;
+}
+
+static char*cache_path(const char*dir, const char*key, const char*suffix)
+{
+      size_t len = strlen(dir) + strlen(key) + strlen(suffix) + 2;
+      char*path = malloc(len);
+      snprintf(path, len, "%s/%s%s", dir, key, suffix);
+      return path;
+}
+
+int output_cache_fetch(const char*dir, const char*key, const char*opath)
+{
+      char*path = cache_path(dir, key, ".out");
+      int rc = -1;
+
+      if (access(path, R_OK) == 0)
+	    rc = cache_copy(path, opath);
+
+      free(path);
+      return rc;
+}
+
+void output_cache_store(const char*dir, const char*key, const char*opath)
+{
+      char*path = cache_path(dir, key, ".out");
+      char suffix[32];
+      char*tmp_path;
+
+#ifdef __MINGW32__
+      mkdir(dir);
+#else
+      mkdir(dir, 0777);
+#endif
+
+	/* Copy to a temporary name and rename it, so that a compile
+	   that runs at the same time never sees a partial file. */
+      snprintf(suffix, sizeof suffix, ".%d.tmp", (int)getpid());
+      tmp_path = cache_path(dir, key, suffix);
+      if (cache_copy(opath, tmp_path) == 0) {
+#ifdef __MINGW32__
+	    remove(path);
+#endif
+	    if (rename(tmp_path, path) != 0)
+		  remove(tmp_path);
+      } else {
+	    remove(tmp_path);
+      }
+
+      free(tmp_path);
+      free(path);
+}
@@ -54,4 +54,20 @@ extern void process_parameter(const char*name);
   /* Set the default timescale for the simulator. */
 extern void process_timescale(const char*ts_string);
 
+  /* Make the output cache key for the preprocessed source of the
+     whole design and the compiler configuration. Return -1 if the
+     compile cannot be cached. */
+extern int output_cache_key(char key[17], const char*version,
+			     const char*pp_path, const char*iconfig_path,
+			     const char*conf_path);
+
+  /* Copy the cached output for the key to the output path. Return -1
+     if there is no cached output. */
+extern int output_cache_fetch(const char*dir, const char*key,
+			       const char*opath);
+
+  /* Save the output of a successful compile in the cache. */
+extern void output_cache_store(const char*dir, const char*key,
+				const char*opath);
+
 #endif /* IVL_globals_H */
@@ -398,6 +398,70 @@ static int t_preprocess_only(void)
       return 0;
 }
 
+/*
+ * If the IVERILOG_CACHE environment variable names a directory, then
+ * the preprocessed source is written to a temporary file so that the
+ * output cache can look it up. If the cache has the output for this
+ * whole design and these flags, then the compiler does not need to
+ * run.
+ * Return 1 for a cache hit, 0 if the compiler needs to run (with
+ * pp_path set if the source was preprocessed) and -1 if the
+ * preprocessor failed.
+ */
+static int t_output_cache(char**pp_path, char cache_key[17])
+{
+      const char*cache_dir = getenv("IVERILOG_CACHE");
+      FILE*pp_file;
+      char*cmd;
+      int rc;
+
+      *pp_path = 0;
+      if (cache_dir == 0 || *cache_dir == 0)
+	    return 0;
+	/* Only the vvp target writes all its output to the one file. */
+      if (strcmp(targ, "vvp") != 0 || strcmp(opath, "-") == 0 || npath != 0)
+	    return 0;
+
+      *pp_path = strdup(my_tempfile("ivrlp", &pp_file));
+      if (pp_file == 0) {
+	    free(*pp_path);
+	    *pp_path = 0;
+	    return 0;
+      }
+      fclose(pp_file);
+
+      build_preprocess_command(0);
+      cmd = malloc(strlen(tmp) + strlen(*pp_path) + 5);
+      sprintf(cmd, "%s > \"%s\"", tmp, *pp_path);
+
+      if (verbose_flag)
+	    printf("preprocess: %s\n", cmd);
+
+      rc = system(cmd);
+      free(cmd);
+      if (rc != 0) {
+	    fprintf(stderr, "errors preprocessing Verilog program.\n");
+	    return -1;
+      }
+
+      snprintf(tmp, sizeof tmp, "%s (%s)", VERSION, VERSION_TAG);
+      if (output_cache_key(cache_key, tmp, *pp_path, iconfig_path,
+			    iconfig_common_path) < 0) {
+	    cache_key[0] = 0;
+	    return 0;
+      }
+
+      if (output_cache_fetch(cache_dir, cache_key, opath) < 0) {
+	    if (verbose_flag)
+		  printf("cache: miss %s\n", cache_key);
+	    return 0;
+      }
+
+      if (verbose_flag)
+	    printf("cache: hit %s\n", cache_key);
+      return 1;
+}
+
 /*
  * This is the default target type. It looks up the bits that are
  * needed to run the command from the configuration file (which is
@@ -406,24 +470,59 @@ static int t_preprocess_only(void)
 static int t_compile(void)
 {
       unsigned rc;
+      size_t ncmd;
+      char*cmd;
+      char*pp_path;
+      char cache_key[17];
 
-	/* Start by building the preprocess command line. */
-      build_preprocess_command(0);
-
-      size_t ncmd = strlen(tmp);
-      char*cmd = malloc(ncmd + 1);
-      strcpy(cmd, tmp);
+	/* See if the output cache already has the output. */
+      cache_key[0] = 0;
+      int cache_rc = t_output_cache(&pp_path, cache_key);
 
 #ifndef __MINGW32__
       int rtn;
 #endif
 
-	/* Build the ivl command and pipe it to the preprocessor. */
-      snprintf(tmp, sizeof tmp, " | %s%civl", base, sep);
-      rc = strlen(tmp);
-      cmd = realloc(cmd, ncmd+rc+1);
-      strcpy(cmd+ncmd, tmp);
-      ncmd += rc;
+      if (cache_rc != 0) {
+	    if (pp_path) {
+		  remove(pp_path);
+		  free(pp_path);
+	    }
+	    if ( ! getenv("IVERILOG_ICONFIG")) {
+		  remove(source_path);
+		  free(source_path);
+		  remove(iconfig_path);
+		  free(iconfig_path);
+		  remove(defines_path);
+		  free(defines_path);
+		  remove(compiled_defines_path);
+		  free(compiled_defines_path);
+	    }
+	    return cache_rc > 0? 0 : 1;
+      }
+
+      if (pp_path) {
+	      /* The source is already preprocessed, so just run ivl. */
+	    snprintf(tmp, sizeof tmp, "%s%civl", base, sep);
+	    ncmd = strlen(tmp);
+	    cmd = malloc(ncmd + 1);
+	    strcpy(cmd, tmp);
+
+      } else {
+	      /* Start by building the preprocess command line. */
+	    build_preprocess_command(0);
+
+	    ncmd = strlen(tmp);
+	    cmd = malloc(ncmd + 1);
+	    strcpy(cmd, tmp);
+
+	      /* Build the ivl command and pipe it to the preprocessor. */
+	    snprintf(tmp, sizeof tmp, " | %s%civl", base, sep);
+	    rc = strlen(tmp);
+	    cmd = realloc(cmd, ncmd+rc+1);
+	    strcpy(cmd+ncmd, tmp);
+	    ncmd += rc;
+      }
 
       if (verbose_flag) {
 	    const char*vv = " -v";
@@ -447,11 +546,17 @@ static int t_compile(void)
       strcpy(cmd+ncmd, tmp);
       ncmd += rc;
 
-      snprintf(tmp, sizeof tmp, " -C\"%s\" -- -", iconfig_common_path);
-      rc = strlen(tmp);
-      cmd = realloc(cmd, ncmd+rc+1);
-      strcpy(cmd+ncmd, tmp);
-      ncmd += rc;
+      if (pp_path) {
+	    rc = strlen(iconfig_common_path) + strlen(pp_path) + 13;
+	    cmd = realloc(cmd, ncmd+rc+1);
+	    sprintf(cmd+ncmd, " -C\"%s\" -- \"%s\"",
+		    iconfig_common_path, pp_path);
+      } else {
+	    rc = strlen(iconfig_common_path) + 10;
+	    cmd = realloc(cmd, ncmd+rc+1);
+	    sprintf(cmd+ncmd, " -C\"%s\" -- -", iconfig_common_path);
+      }
+      ncmd += strlen(cmd+ncmd);
 
 
       if (verbose_flag)
@@ -459,6 +564,15 @@ static int t_compile(void)
 
 
       rc = system(cmd);
+      if (pp_path) {
+	    if (rc == 0 && cache_key[0]) {
+		  if (verbose_flag)
+			printf("cache: store %s\n", cache_key);
+		  output_cache_store(getenv("IVERILOG_CACHE"), cache_key, opath);
+	    }
+	    remove(pp_path);
+	    free(pp_path);
+      }
       if ( ! getenv("IVERILOG_ICONFIG")) {
 	    remove(source_path);
 	    free(source_path);
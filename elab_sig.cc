@@ -1307,11 +1307,12 @@ NetNet* PWire::elaborate_sig(Design*des, NetScope*scope) const
 		  }
 	    }
 
-	    netvector_t*vec = new netvector_t(packed_dimensions, use_data_type);
-	    vec->set_signed(get_signed());
-	    vec->set_isint(get_isint());
-	    if (is_implicit_scalar) vec->set_scalar(true);
-	    else vec->set_scalar(get_scalar());
+	    netvector_t*vec = netvector_t::make_shared(packed_dimensions,
+						       use_data_type,
+						       get_signed(),
+						       get_isint(),
+						       is_implicit_scalar
+						       || get_scalar());
 	    packed_dimensions.clear();
 	    sig = new NetNet(scope, name_, wtype, unpacked_dimensions, vec);
 
@@ -48,6 +48,7 @@
 # include  "util.h"
 # include  "parse_api.h"
 # include  "compiler.h"
+# include  "phase_report.h"
 # include  "ivl_assert.h"
 
 
@@ -6216,6 +6217,8 @@ Design* elaborate(list<perm_string>roots)
 	// module and elaborate what I find.
       Design*des = new Design;
 
+      phase_begin("elaborate-scopes");
+
 	// Elaborate enum sets in $root scope.
       elaborate_rootscope_enumerations(des);
 
@@ -6330,6 +6333,8 @@ Design* elaborate(list<perm_string>roots)
 	// scope) and clean them out.
       des->residual_defparams();
 
+      phase_end();
+
 	// Errors already? Probably missing root modules. Just give up
 	// now and return nothing.
       if (des->errors > 0)
@@ -6344,6 +6349,7 @@ Design* elaborate(list<perm_string>roots)
 	// what we need to elaborate signals and memories. This pass
 	// creates all the NetNet and NetMemory objects for declared
 	// objects.
+      phase_begin("elaborate-signals");
       for (i = 0; i < pack_elems.size(); i += 1) {
 	    PPackage*pack = pack_elems[i].pack;
 	    NetScope*scope= pack_elems[i].scope;
@@ -6417,9 +6423,12 @@ Design* elaborate(list<perm_string>roots)
 	    }
       }
 
+      phase_end();
+
 	// Now that the structure and parameters are taken care of,
 	// run through the pform again and generate the full netlist.
 
+      phase_begin("elaborate-netlist");
       for (i = 0; i < pack_elems.size(); i += 1) {
 	    PPackage*pkg = pack_elems[i].pack;
 	    NetScope*scope = pack_elems[i].scope;
@@ -6447,6 +6456,8 @@ Design* elaborate(list<perm_string>roots)
 	    des = 0;
       }
 
+      phase_end();
+
       if (debug_elaborate) {
                cerr << "<toplevel>" << ": debug: "
                     << " finishing with "
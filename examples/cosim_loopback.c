@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2026 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * This is an example external model for the $cosim_shm system task.
+ * It copies signal 0 to signal 1 and signal 2 to signal 3, and at the
+ * end reports the round trip latency and the throughput of the
+ * channel. Build and run it with the cosim_loopback.v design like so:
+ *
+ *    cc -O2 -I<iverilog include dir> -o cosim_loopback cosim_loopback.c -lrt
+ *    iverilog -o cosim_loopback.vvp cosim_loopback.v
+ *    ./cosim_loopback /ivl_loopback & vvp cosim_loopback.vvp
+ *
+ * The round trip is the time from the reply of the model to the next
+ * SYNC message, so it includes the simulation of the time step.
+ */
+
+# include  <cosim_shm.h>
+# include  <stdio.h>
+# include  <stdlib.h>
+# include  <sys/time.h>
+
+static double now_seconds(void)
+{
+      struct timeval tv;
+      gettimeofday(&tv, 0);
+      return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+int main(int argc, char*argv[])
+{
+      const char*name = argc > 1? argv[1] : "/ivl_loopback";
+      struct cosim_shm_chan chan;
+      struct cosim_shm_msg msg;
+      uint32_t**value, *words;
+      unsigned char*changed;
+      unsigned long syncs = 0, values = 0;
+      unsigned long long bytes = 0;
+      double start, sent = 0.0, waiting = 0.0;
+      unsigned idx, maxwords = 1;
+
+      if (cosim_shm_attach(&chan, name) < 0) {
+	    fprintf(stderr, "%s: not a valid cosim channel\n", name);
+	    return 1;
+      }
+      if (chan.hdr->nsignals < 4) {
+	    fprintf(stderr, "%s: expected 4 signals, got %u\n", name,
+		    (unsigned)chan.hdr->nsignals);
+	    return 1;
+      }
+
+      value = (uint32_t**)calloc(chan.hdr->nsignals, sizeof(uint32_t*));
+      changed = (unsigned char*)calloc(chan.hdr->nsignals, 1);
+      for (idx = 0 ; idx < chan.hdr->nsignals ; idx += 1) {
+	    value[idx] = (uint32_t*)calloc(2*cosim_shm_words(&chan, idx),
+					   sizeof(uint32_t));
+	    if (cosim_shm_words(&chan, idx) > maxwords)
+		  maxwords = cosim_shm_words(&chan, idx);
+      }
+      words = (uint32_t*)calloc(2*maxwords, sizeof(uint32_t));
+
+      start = now_seconds();
+      for (;;) {
+	    if (cosim_shm_recv(&chan, &msg, words) < 0)
+		  break;
+
+	    if (msg.type == COSIM_MSG_FINISH)
+		  break;
+
+	    if (msg.type == COSIM_MSG_VALUE) {
+		  memcpy(value[msg.index], words,
+			 8*cosim_shm_words(&chan, msg.index));
+		  changed[msg.index] = 1;
+		  values += 1;
+		  bytes += 8*cosim_shm_words(&chan, msg.index);
+		  continue;
+	    }
+
+	    if (msg.type != COSIM_MSG_SYNC)
+		  continue;
+
+	    syncs += 1;
+	    if (sent > 0.0)
+		  waiting += now_seconds() - sent;
+
+	    for (idx = 0 ; idx+1 < 4 ; idx += 2) {
+		  if (! changed[idx])
+			continue;
+		  cosim_shm_send(&chan, COSIM_MSG_PUT, idx+1, 0, value[idx]);
+		  bytes += 8*cosim_shm_words(&chan, idx+1);
+	    }
+	    for (idx = 0 ; idx < chan.hdr->nsignals ; idx += 1)
+		  changed[idx] = 0;
+
+	    cosim_shm_send(&chan, COSIM_MSG_RUN, 0, 0, 0);
+	    cosim_shm_flush(&chan);
+	    sent = now_seconds();
+      }
+
+      {
+	    double total = now_seconds() - start;
+	    printf("cosim_loopback: %lu syncs, %lu values in %.3f s\n",
+		   syncs, values, total);
+	    if (syncs > 1)
+		  printf("cosim_loopback: %.2f us average round trip\n",
+			 1e6 * waiting / (syncs - 1));
+	    if (total > 0.0)
+		  printf("cosim_loopback: %.0f syncs/s, %.2f MB/s\n",
+			 syncs / total, bytes / total / 1e6);
+      }
+
+      cosim_shm_close(&chan, 0);
+      return 0;
+}
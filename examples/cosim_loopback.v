@@ -0,0 +1,41 @@
+/*
+ * This is the Verilog half of the $cosim_shm loopback example. See
+ * cosim_loopback.c for how to build and run it.
+ *
+ * Every other time step the design changes req and wide_req. The
+ * external model copies them to rsp and wide_rsp one time step later,
+ * and the design checks that the copies arrived before it changes
+ * req again.
+ */
+module main;
+
+   parameter STEPS = 100000;
+
+   reg [63:0]   req, rsp;
+   reg [1023:0] wide_req, wide_rsp;
+   integer      step, errors;
+
+   initial begin
+      req = 0;
+      wide_req = 0;
+      errors = 0;
+      $cosim_shm("/ivl_loopback", req, rsp, wide_req, wide_rsp);
+
+      for (step = 1 ; step <= STEPS ; step = step + 1) begin
+	 #2 if (rsp !== req || wide_rsp !== wide_req) begin
+	    if (errors < 10)
+	      $display("step %0d: rsp=%0d req=%0d", step, rsp, req);
+	    errors = errors + 1;
+	 end
+	 req = step;
+	 wide_req = {16{req}};
+      end
+
+      #2 if (errors == 0)
+	$display("PASSED %0d steps", STEPS);
+      else
+	$display("FAILED %0d of %0d steps", errors, STEPS);
+      $finish;
+   end
+
+endmodule
@@ -82,12 +82,16 @@ StringHeapLex::StringHeapLex()
       hit_count_ = 0;
       add_count_ = 0;
 
-      for (unsigned idx = 0 ;  idx < HASH_SIZE ;  idx += 1)
+      hash_size_ = HASH_SIZE;
+      hash_table_ = new const char*[hash_size_];
+      for (unsigned idx = 0 ;  idx < hash_size_ ;  idx += 1)
 	    hash_table_[idx] = 0;
 }
 
 StringHeapLex::~StringHeapLex()
 {
+	// The hash table is left in place along with the strings, in
+	// case a static destructor still looks up a string.
 }
 
 void StringHeapLex::cleanup()
@@ -100,9 +104,10 @@ void StringHeapLex::cleanup()
       string_pool = NULL;
       string_pool_count = 0;
 
-      for (unsigned idx = 0 ;  idx < HASH_SIZE ;  idx += 1) {
+      for (unsigned idx = 0 ;  idx < hash_size_ ;  idx += 1) {
 	    hash_table_[idx] = 0;
       }
+      add_count_ = 0;
 #endif
 }
 
@@ -118,34 +123,68 @@ unsigned StringHeapLex::add_count() const
 
 static unsigned hash_string(const char*text)
 {
-      unsigned h = 0;
+      unsigned h = 2166136261U;
 
       while (*text) {
-	    h = (h << 4) ^ (h >> 28) ^ *text;
+	    h ^= (unsigned char)*text;
+	    h *= 16777619U;
 	    text += 1;
       }
       return h;
 }
 
+/*
+ * The hash table uses open addressing with linear probing. The table
+ * size is always a power of 2, and the table is doubled before it
+ * gets more than half full, so there is always an empty slot to end
+ * a probe.
+ */
+void StringHeapLex::rehash_(unsigned new_size)
+{
+      const char**old_table = hash_table_;
+      unsigned old_size = hash_size_;
+
+      hash_size_ = new_size;
+      hash_table_ = new const char*[hash_size_];
+      for (unsigned idx = 0 ;  idx < hash_size_ ;  idx += 1)
+	    hash_table_[idx] = 0;
+
+      for (unsigned idx = 0 ;  idx < old_size ;  idx += 1) {
+	    if (old_table[idx] == 0)
+		  continue;
+
+	    unsigned hash_value = hash_string(old_table[idx]) & (hash_size_-1);
+	    while (hash_table_[hash_value])
+		  hash_value = (hash_value+1) & (hash_size_-1);
+	    hash_table_[hash_value] = old_table[idx];
+      }
+
+      delete[]old_table;
+}
+
 const char* StringHeapLex::add(const char*text)
 {
-      unsigned hash_value = hash_string(text) % HASH_SIZE;
+      unsigned hash_value = hash_string(text) & (hash_size_-1);
 
-	/* If we easily find the string in the hash table, then return
-	   that and be done. */
-      if (hash_table_[hash_value]
-	  && (strcmp(hash_table_[hash_value], text) == 0)) {
-	    hit_count_ += 1;
-	    return hash_table_[hash_value];
+	/* If we find the string in the hash table, then return that
+	   and be done. */
+      while (hash_table_[hash_value]) {
+	    if (strcmp(hash_table_[hash_value], text) == 0) {
+		  hit_count_ += 1;
+		  return hash_table_[hash_value];
+	    }
+	    hash_value = (hash_value+1) & (hash_size_-1);
       }
 
-	/* The existing hash entry is not a match. Replace it with the
-	   newly allocated value, and return the new pointer as the
-	   result to the add. */
+	/* This is a new string, so allocate it and put it in the
+	   empty slot that ended the search. */
       const char*res = StringHeap::add(text);
       hash_table_[hash_value] = res;
       add_count_ += 1;
 
+      if (2*add_count_ > hash_size_)
+	    rehash_(2*hash_size_);
+
       return res;
 }
 
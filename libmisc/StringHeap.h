@@ -90,10 +90,12 @@ class StringHeap {
 };
 
 /*
- * A lexical string heap is a string heap that makes an effort to
- * return the same pointer for identical strings. This saves further
- * space by not allocating duplicate strings, so in a system with lots
- * of identifiers, this can theoretically save more space.
+ * A lexical string heap is a string heap that returns the same
+ * pointer for identical strings. This saves further space by not
+ * allocating duplicate strings, and makes comparisons of perm_strings
+ * from the same heap quick, since identical strings compare equal by
+ * pointer. The hash table grows with the number of strings, so that
+ * this stays true for designs with very many identifiers.
  */
 class StringHeapLex  : private StringHeap {
 
@@ -110,8 +112,11 @@ class StringHeapLex  : private StringHeap {
       void cleanup();
 
     private:
+      void rehash_(unsigned new_size);
+
       enum { HASH_SIZE = 4096 };
-      const char*hash_table_[HASH_SIZE];
+      const char**hash_table_;
+      unsigned hash_size_;
 
       unsigned add_count_;
       unsigned hit_count_;
@@ -21,8 +21,13 @@
 # include  "util.h"
 # include  "parse_api.h"
 # include  "compiler.h"
+# include  "phase_report.h"
+# include  "Module.h"
+# include  "PGate.h"
+# include  "PGenerate.h"
 # include  <iostream>
 # include  <map>
+# include  <set>
 # include  <cstdlib>
 # include  <cstring>
 # include  <string>
@@ -52,12 +57,13 @@ extern FILE *depend_file;
 
 /*
  * Use the type name as a key, and search the module library for a
- * file name that has that key.
+ * file name that has that key. Return false if there is no such file
+ * in the library directories.
  */
-bool load_module(const char*type)
+static bool find_library_file(const char*type, char path[4096])
 {
-      char path[4096];
       char*ltype = strdup(type);
+      bool found = false;
 
       for (char*tmp = ltype ; *tmp ;  tmp += 1)
 	    *tmp = tolower(*tmp);
@@ -72,55 +78,199 @@ bool load_module(const char*type)
 		  continue;
 
 	    sprintf(path, "%s%c%s", lcur->dir, dir_character, (*cur).second);
+	    found = true;
+	    break;
+      }
 
-	    if(depend_file) {
-                  if (depfile_mode == 'p') {
-		        fprintf(depend_file, "M %s\n", path);
-                  } else if (depfile_mode != 'i') {
-		        fprintf(depend_file, "%s\n", path);
-                  }
-		  fflush(depend_file);
-	    }
+      free(ltype);
+      return found;
+}
+
+static FILE*open_preprocessed(const char*path)
+{
+      char*cmdline = (char*)malloc(strlen(ivlpp_string) +
+				   strlen(path) + 4);
+      strcpy(cmdline, ivlpp_string);
+      strcat(cmdline, " \"");
+      strcat(cmdline, path);
+      strcat(cmdline, "\"");
+
+      if (verbose_flag)
+	    cerr << "Executing: " << cmdline << endl<< flush;
+
+      FILE*file = popen(cmdline, "r");
+      free(cmdline);
+      return file;
+}
+
+/*
+ * Library files are preprocessed ahead of time, while the compiler is
+ * busy with other work. The preprocessor for each file that is likely
+ * to be needed is started right away, so that several of them run at
+ * once, and the output waits in the pipe until load_module parses it.
+ * The parse itself still happens one file at a time, as the parser
+ * is not reentrant.
+ *
+ * A prefetched file that is not parsed after all (because its module
+ * came from some other file, or was never needed) is closed as soon
+ * as that is known, so that it does not hold one of the prefetch_max
+ * running slots.
+ */
+struct prefetch_file_s {
+      perm_string type;
+      FILE*file;
+};
+static map<string,prefetch_file_s> prefetch_files;
+static set<const Module*> prefetch_scanned;
+static size_t prefetch_running = 0;
+static const size_t prefetch_max = 32;
 
-	    if (ivlpp_string) {
-		  char*cmdline = (char*)malloc(strlen(ivlpp_string) +
-					       strlen(path) + 4);
-		  strcpy(cmdline, ivlpp_string);
-		  strcat(cmdline, " \"");
-		  strcat(cmdline, path);
-		  strcat(cmdline, "\"");
+static void prefetch_reap(void)
+{
+      map<string,prefetch_file_s>::iterator cur = prefetch_files.begin();
+      while (cur != prefetch_files.end()) {
+	    map<string,prefetch_file_s>::iterator tmp = cur++;
+	    if (pform_modules.find(tmp->second.type) == pform_modules.end())
+		  continue;
 
-		  if (verbose_flag)
-			cerr << "Executing: " << cmdline << endl<< flush;
+	    pclose(tmp->second.file);
+	    prefetch_files.erase(tmp);
+	    prefetch_running -= 1;
+      }
+}
 
-		  FILE*file = popen(cmdline, "r");
+static void prefetch_type(perm_string type)
+{
+      char path[4096];
 
-		  if (verbose_flag)
-			cerr << "...parsing output from preprocessor..." << endl << flush;
+      if (prefetch_running >= prefetch_max)
+	    return;
+      if (pform_modules.find(type) != pform_modules.end())
+	    return;
+      if (pform_primitives.find(type) != pform_primitives.end())
+	    return;
+      if (! find_library_file(type.str(), path))
+	    return;
+      if (prefetch_files.find(path) != prefetch_files.end())
+	    return;
+
+      FILE*file = open_preprocessed(path);
+      if (file == 0)
+	    return;
+
+      prefetch_file_s&cur = prefetch_files[path];
+      cur.type = type;
+      cur.file = file;
+      prefetch_running += 1;
+}
 
-		  pform_parse(path, file);
-		  pclose(file);
-		  free(cmdline);
+static void prefetch_gates(const list<PGate*>&gates)
+{
+      for (list<PGate*>::const_iterator gate = gates.begin()
+		 ; gate != gates.end() ; ++ gate ) {
+	    if (PGModule*tmp = dynamic_cast<PGModule*>(*gate))
+		  prefetch_type(tmp->get_type());
+      }
+}
 
+static void prefetch_schemes(const list<PGenerate*>&schemes)
+{
+      for (list<PGenerate*>::const_iterator cur = schemes.begin()
+		 ; cur != schemes.end() ; ++ cur ) {
+	    prefetch_gates((*cur)->gates);
+	    prefetch_schemes((*cur)->generate_schemes);
+      }
+}
+
+void prefetch_library_modules(void)
+{
+	/* Without a preprocessor the files are read directly, and
+	   with a dependency file the preprocessor would list files
+	   that may never be used. */
+      if (ivlpp_string == 0 || depend_file != 0)
+	    return;
+
+      prefetch_reap();
+
+      for (map<perm_string,Module*>::const_iterator mod = pform_modules.begin()
+		 ; mod != pform_modules.end() ; ++ mod ) {
+	    if (prefetch_scanned.find(mod->second) != prefetch_scanned.end())
+		  continue;
+	    if (prefetch_running >= prefetch_max)
+		  return;
+
+	    prefetch_scanned.insert(mod->second);
+	    prefetch_gates(mod->second->get_gates());
+	    prefetch_schemes(mod->second->generate_schemes);
+      }
+}
+
+void prefetch_library_close(void)
+{
+      for (map<string,prefetch_file_s>::iterator cur = prefetch_files.begin()
+		 ; cur != prefetch_files.end() ; ++ cur ) {
+	    pclose(cur->second.file);
+      }
+      prefetch_files.clear();
+      prefetch_running = 0;
+}
+
+bool load_module(const char*type)
+{
+      char path[4096];
+
+      if (! find_library_file(type, path))
+	    return false;
+
+      if(depend_file) {
+	    if (depfile_mode == 'p') {
+		  fprintf(depend_file, "M %s\n", path);
+	    } else if (depfile_mode != 'i') {
+		  fprintf(depend_file, "%s\n", path);
+	    }
+	    fflush(depend_file);
+      }
+
+      if (ivlpp_string) {
+	    FILE*file;
+	    map<string,prefetch_file_s>::iterator pre = prefetch_files.find(path);
+	    if (pre != prefetch_files.end()) {
+		  file = pre->second.file;
+		  prefetch_files.erase(pre);
+		  prefetch_running -= 1;
 	    } else {
-		  if (verbose_flag)
-			cerr << "Loading library file "
-			     << path << "." << endl;
-
-		  FILE*file = fopen(path, "r");
-		  assert(file);
-		  pform_parse(path, file);
-		  fclose(file);
+		  file = open_preprocessed(path);
 	    }
 
 	    if (verbose_flag)
-		  cerr << "... Load module complete." << endl << flush;
+		  cerr << "...parsing output from preprocessor..." << endl << flush;
+
+	    phase_begin("parse-library", path);
+	    pform_parse(path, file);
+	    pclose(file);
+	    phase_end();
 
-	    return true;
+	      /* The new modules may need more library modules, so
+		 start preprocessing those now. */
+	    prefetch_library_modules();
+
+      } else {
+	    if (verbose_flag)
+		  cerr << "Loading library file "
+		       << path << "." << endl;
+
+	    FILE*file = fopen(path, "r");
+	    assert(file);
+	    phase_begin("parse-library", path);
+	    pform_parse(path, file);
+	    fclose(file);
+	    phase_end();
       }
 
+      if (verbose_flag)
+	    cerr << "... Load module complete." << endl << flush;
 
-      return false;
+      return true;
 }
 
 /*
@@ -60,6 +60,8 @@ const char NOTICE[] =
 # include  "target.h"
 # include  "compiler.h"
 # include  "discipline.h"
+# include  "util.h"
+# include  "phase_report.h"
 # include  "t-dll.h"
 
 #if defined(__MINGW32__) && !defined(HAVE_GETOPT_H)
@@ -173,6 +175,7 @@ bool debug_elaborate = false;
 bool debug_emit = false;
 bool debug_synth2 = false;
 bool debug_optimizer = false;
+bool debug_timing = false;
 
 /*
  * Optimization control flags.
@@ -628,6 +631,9 @@ static void read_iconfig_file(const char*ipath)
 		  } else if (strcmp(cp,"optimizer") == 0) {
 			debug_optimizer = true;
 			cerr << "debug: Enable optimizer debug" << endl;
+		  } else if (strcmp(cp,"timing") == 0) {
+			debug_timing = true;
+			cerr << "debug: Enable timing report" << endl;
 		  } else {
 		  }
 
@@ -936,6 +942,11 @@ int main(int argc, char*argv[])
 	      }
       }
 
+	/* The timing report goes to stderr, unless the TIMING_REPORT
+	   flag names a file. */
+      if (debug_timing)
+	    phase_report_open(flags["TIMING_REPORT"]);
+
       lexor_keyword_mask = 0;
       switch (generation_flag) {
         case GN_VER2012:
@@ -1024,7 +1035,9 @@ int main(int argc, char*argv[])
 
 	/* Parse the input. Make the pform. */
       pform_set_timescale(def_ts_units, def_ts_prec, 0, 0);
+      phase_begin("parse", argv[optind]);
       int rc = pform_parse(argv[optind]);
+      phase_end();
 
       if (pf_path) {
 	    ofstream out (pf_path);
@@ -1129,8 +1142,13 @@ int main(int argc, char*argv[])
 	    def_sfunc_as_task = IVL_SFUNC_AS_TASK_WARNING;
       }
 
+	/* Get the preprocessor going on the library modules that
+	   elaboration is going to need. */
+      prefetch_library_modules();
+
 	/* On with the process of elaborating the module. */
       Design*des = elaborate(roots);
+      prefetch_library_close();
 
       if ((des == 0) || (des->errors > 0)) {
 	    if (des != 0) {
@@ -1191,13 +1209,17 @@ int main(int argc, char*argv[])
 	    net_func_queue.pop();
 	    if (verbose_flag)
 		  cerr<<" -F "<<net_func_to_name(func)<< " ..." <<endl;
+	    phase_begin("functor", net_func_to_name(func));
 	    func(des);
+	    phase_end();
       }
 
       if (verbose_flag) {
 	    cout << "CALCULATING ISLANDS" << endl;
       }
+      phase_begin("islands");
       des->join_islands();
+      phase_end();
 
       if (net_path) {
 	    if (verbose_flag)
@@ -1226,7 +1248,9 @@ int main(int argc, char*argv[])
 	    cout << "CODE GENERATION" << endl;
       }
 
+      phase_begin("emit", flags["DLL"]);
       if (int emit_rc = des->emit(&dll_target_obj)) {
+	    phase_end();
 	    if (emit_rc > 0) {
 		  cerr << "error: Code generation had "
 		       << emit_rc << " error(s)."
@@ -1239,6 +1263,7 @@ int main(int argc, char*argv[])
 	    }
 	    assert(emit_rc);
       }
+      phase_end();
 
       if (verbose_flag) {
 	    if (times_flag) {
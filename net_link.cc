@@ -246,8 +246,11 @@ bool Link::is_linked(const Link&that) const
       return false;
 }
 
+unsigned long Nexus::live_count = 0;
+
 Nexus::Nexus(Link&that)
 {
+      live_count += 1;
       name_ = 0;
       driven_ = NO_GUESS;
       t_cookie_ = 0;
@@ -273,6 +276,7 @@ Nexus::Nexus(Link&that)
 
 Nexus::~Nexus()
 {
+      live_count -= 1;
       assert(list_ == 0);
       delete[] name_;
 }
@@ -260,13 +260,17 @@ const NetScope* NetObj::scope() const
       return scope_;
 }
 
+unsigned long NetNode::live_count = 0;
+
 NetNode::NetNode(NetScope*s, perm_string n, unsigned npins)
 : NetObj(s, n, npins), node_next_(0), node_prev_(0), design_(0)
 {
+      live_count += 1;
 }
 
 NetNode::~NetNode()
 {
+      live_count -= 1;
       if (design_)
 	    design_->del_node(this);
 }
@@ -564,6 +568,7 @@ void NetNet::calculate_slice_widths_from_packed_dims_(void)
 }
 
 const list<netrange_t> NetNet::not_an_array;
+unsigned long NetNet::live_count = 0;
 
 NetNet::NetNet(NetScope*s, perm_string n, Type t,
 	       const list<netrange_t>&unpacked, ivl_type_t use_net_type)
@@ -573,6 +578,7 @@ NetNet::NetNet(NetScope*s, perm_string n, Type t,
     discipline_(0), unpacked_dims_(unpacked.size()),
     eref_count_(0), lref_count_(0)
 {
+      live_count += 1;
       calculate_slice_widths_from_packed_dims_();
       size_t idx = 0;
       for (list<netrange_t>::const_iterator cur = unpacked.begin()
@@ -604,6 +610,7 @@ NetNet::NetNet(NetScope*s, perm_string n, Type t, netstruct_t*ty)
     discipline_(0),
     eref_count_(0), lref_count_(0)
 {
+      live_count += 1;
 	//XXXX packed_dims_.push_back(netrange_t(calculate_count(ty)-1, 0));
       calculate_slice_widths_from_packed_dims_();
 
@@ -619,6 +626,7 @@ NetNet::NetNet(NetScope*s, perm_string n, Type t, netdarray_t*ty)
     discipline_(0),
     eref_count_(0), lref_count_(0)
 {
+      live_count += 1;
       initialize_dir_();
 
       s->add_signal(this);
@@ -631,6 +639,7 @@ NetNet::NetNet(NetScope*s, perm_string n, Type t, netvector_t*ty)
     discipline_(0),
     eref_count_(0), lref_count_(0)
 {
+      live_count += 1;
       calculate_slice_widths_from_packed_dims_();
 
       initialize_dir_();
@@ -640,6 +649,7 @@ NetNet::NetNet(NetScope*s, perm_string n, Type t, netvector_t*ty)
 
 NetNet::~NetNet()
 {
+      live_count -= 1;
       if (eref_count_ > 0) {
 	    cerr << get_fileline() << ": internal error: attempt to delete "
 		 << "signal ``" << name() << "'' which has "
@@ -362,6 +362,8 @@ class Nexus {
       ~Nexus();
 
     public:
+	// The number of Nexus objects that exist.
+      static unsigned long live_count;
 
       void connect(Link&r);
 
@@ -531,6 +533,9 @@ class NetNode  : public NetObj {
 
       virtual ~NetNode();
 
+	// The number of NetNode objects that exist.
+      static unsigned long live_count;
+
       virtual bool emit_node(struct target_t*) const;
       virtual void dump_node(ostream&, unsigned) const;
 
@@ -682,6 +687,9 @@ class NetNet  : public NetObj, public PortType {
 
       virtual ~NetNet();
 
+	// The number of NetNet objects that exist.
+      static unsigned long live_count;
+
       Type type() const;
       void type(Type t);
 
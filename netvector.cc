@@ -19,6 +19,8 @@
 
 # include  "netvector.h"
 # include  <iostream>
+# include  <map>
+# include  <climits>
 
 using namespace std;
 
@@ -49,6 +51,37 @@ netvector_t::~netvector_t()
 {
 }
 
+netvector_t* netvector_t::make_shared(const vector<netrange_t>&packed,
+				      ivl_variable_type_t type,
+				      bool signed_flag, bool isint_flag,
+				      bool scalar_flag)
+{
+      static map<vector<long>,netvector_t*> shared_types;
+
+      vector<long> key (2 + 2*packed.size());
+      key[0] = type;
+      key[1] = (signed_flag? 1 : 0) | (isint_flag? 2 : 0) | (scalar_flag? 4 : 0);
+      for (size_t idx = 0 ; idx < packed.size() ; idx += 1) {
+	    if (packed[idx].defined()) {
+		  key[2+2*idx+0] = packed[idx].get_msb();
+		  key[2+2*idx+1] = packed[idx].get_lsb();
+	    } else {
+		  key[2+2*idx+0] = LONG_MAX;
+		  key[2+2*idx+1] = LONG_MAX;
+	    }
+      }
+
+      netvector_t*&res = shared_types[key];
+      if (res == 0) {
+	    res = new netvector_t(packed, type);
+	    res->set_signed(signed_flag);
+	    res->set_isint(isint_flag);
+	    res->set_scalar(scalar_flag);
+      }
+
+      return res;
+}
+
 ivl_variable_type_t netvector_t::base_type() const
 {
       return type_;
@@ -46,6 +46,16 @@ class netvector_t : public ivl_type_s {
 
       ~netvector_t();
 
+	// Return a vector type with these properties that is shared
+	// with every other user of the same type. Elaboration makes a
+	// type for every declared signal of every instance, and most
+	// of them are the same, so this saves making them over and
+	// over. The returned type must not be changed.
+      static netvector_t* make_shared(const std::vector<netrange_t>&packed,
+				      ivl_variable_type_t type,
+				      bool signed_flag, bool isint_flag,
+				      bool scalar_flag);
+
 	// Vectors can be interpreted as signed or unsigned when
 	// handled as vectors.
       inline void set_signed(bool flag) { signed_ = flag; }
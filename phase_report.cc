@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2026 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+# include  "config.h"
+# include  "phase_report.h"
+# include  "netlist.h"
+# include  <cstdio>
+# include  <cstdlib>
+# include  <ctime>
+# include  <string>
+# include  <vector>
+# include  <sys/time.h>
+#ifdef HAVE_GETRUSAGE
+# include  <sys/resource.h>
+#endif
+
+using namespace std;
+
+struct phase_stamp_s {
+      double wall;
+      double cpu;
+      double child_cpu;
+};
+
+struct phase_record_s {
+      string name;
+      string detail;
+      unsigned depth;
+      phase_stamp_s start;
+      double wall, cpu, child_cpu;
+      long max_rss;
+      unsigned long nets, nodes, nexus;
+};
+
+static vector<phase_record_s> phase_records;
+static vector<size_t> phase_stack;
+static FILE*phase_file = 0;
+static const char*phase_path = 0;
+
+static double timeval_seconds_(const struct timeval&tv)
+{
+      return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+static void phase_stamp_(phase_stamp_s&stamp, long*max_rss)
+{
+      struct timeval tv;
+      gettimeofday(&tv, 0);
+      stamp.wall = timeval_seconds_(tv);
+
+#ifdef HAVE_GETRUSAGE
+      struct rusage ru;
+      getrusage(RUSAGE_SELF, &ru);
+      stamp.cpu = timeval_seconds_(ru.ru_utime) + timeval_seconds_(ru.ru_stime);
+      if (max_rss) *max_rss = ru.ru_maxrss;
+
+	/* The library preprocessors are children of the compiler, and
+	   are counted here once they are waited for. */
+      getrusage(RUSAGE_CHILDREN, &ru);
+      stamp.child_cpu = timeval_seconds_(ru.ru_utime) + timeval_seconds_(ru.ru_stime);
+#else
+      stamp.cpu = clock() / (double)CLOCKS_PER_SEC;
+      stamp.child_cpu = 0.0;
+      if (max_rss) *max_rss = 0;
+#endif
+}
+
+void phase_begin(const char*name, const char*detail)
+{
+      if (! debug_timing)
+	    return;
+
+      phase_record_s cur;
+      cur.name = name;
+      if (detail) cur.detail = detail;
+      cur.depth = phase_stack.size();
+      cur.wall = cur.cpu = cur.child_cpu = 0.0;
+      cur.max_rss = 0;
+      cur.nets = cur.nodes = cur.nexus = 0;
+      phase_stamp_(cur.start, 0);
+
+      phase_stack.push_back(phase_records.size());
+      phase_records.push_back(cur);
+}
+
+void phase_end(void)
+{
+      if (! debug_timing || phase_stack.empty())
+	    return;
+
+      phase_record_s&cur = phase_records[phase_stack.back()];
+      phase_stack.pop_back();
+
+      phase_stamp_s stop;
+      phase_stamp_(stop, &cur.max_rss);
+      cur.wall = stop.wall - cur.start.wall;
+      cur.cpu = stop.cpu - cur.start.cpu;
+      cur.child_cpu = stop.child_cpu - cur.start.child_cpu;
+      cur.nets = NetNet::live_count;
+      cur.nodes = NetNode::live_count;
+      cur.nexus = Nexus::live_count;
+}
+
+/*
+ * The report has one record per line. The first word is the kind of
+ * record and the numbers follow, so that the report can be read by
+ * tools and compared between runs. The phases are listed in the order
+ * that they started, and the depth gives the nesting.
+ */
+static void phase_report_write_(void)
+{
+	/* Phases that did not end (because of an error exit) end now. */
+      while (! phase_stack.empty())
+	    phase_end();
+
+      FILE*out = stderr;
+      if (phase_path) {
+	    phase_file = fopen(phase_path, "w");
+	    if (phase_file == 0) {
+		  perror(phase_path);
+		  return;
+	    }
+	    out = phase_file;
+      }
+
+      fprintf(out, "# ivl timing\n");
+      fprintf(out, "# phase <depth> <wall-s> <cpu-s> <child-cpu-s> "
+	      "<max-rss-kb> <NetNet> <NetNode> <Nexus> <name> [<detail>]\n");
+      for (size_t idx = 0 ; idx < phase_records.size() ; idx += 1) {
+	    const phase_record_s&cur = phase_records[idx];
+	    fprintf(out, "phase %u %.6f %.6f %.6f %ld %lu %lu %lu %s",
+		    cur.depth, cur.wall, cur.cpu, cur.child_cpu,
+		    cur.max_rss, cur.nets, cur.nodes, cur.nexus,
+		    cur.name.c_str());
+	    if (! cur.detail.empty())
+		  fprintf(out, " %s", cur.detail.c_str());
+	    fprintf(out, "\n");
+      }
+
+      if (phase_file) {
+	    fclose(phase_file);
+	    phase_file = 0;
+      }
+}
+
+void phase_report_open(const char*path)
+{
+      phase_path = path;
+      atexit(phase_report_write_);
+}
@@ -0,0 +1,46 @@
+#ifndef IVL_phase_report_H
+#define IVL_phase_report_H
+/*
+ * Copyright (c) 2026 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * The phase report records the wall time, CPU time and peak memory of
+ * each phase of the compile, and the number of netlist objects at the
+ * end of each phase. It is turned on by the "-d timing" debug flag,
+ * and is written when the compiler exits.
+ *
+ * Phases nest. A phase that starts while another is running (for
+ * example the parse of a library file during scope elaboration) is
+ * also counted in the time of the outer phase.
+ */
+
+extern bool debug_timing;
+
+  /* Start a phase. The detail, if present, is written after the name
+     of the phase in the report, for example the name of a file. */
+extern void phase_begin(const char*name, const char*detail =0);
+
+  /* End the phase that was started last. */
+extern void phase_end(void);
+
+  /* Set the file for the report. The default is stderr. This also
+     arranges for the report to be written at exit. */
+extern void phase_report_open(const char*path);
+
+#endif /* IVL_phase_report_H */
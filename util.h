@@ -36,6 +36,19 @@ class NetScope;
  */
 extern bool load_module(const char*type);
 
+/*
+ * Start preprocessing the library files for the modules that the
+ * design instantiates but does not define, so that they are ready
+ * when load_module needs them.
+ */
+extern void prefetch_library_modules(void);
+
+/*
+ * Close the preprocessors for library files that were prefetched but
+ * never loaded. Call this when elaboration is done.
+ */
+extern void prefetch_library_close(void);
+
 
 
 struct attrib_list_t {
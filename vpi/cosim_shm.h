@@ -0,0 +1,407 @@
+#ifndef IVL_cosim_shm_H
+#define IVL_cosim_shm_H
+/*
+ * Copyright (c) 2026 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * This header describes the shared memory channel that the
+ * $cosim_shm system task uses to talk to an external model, and has
+ * the functions that both sides use to send and receive messages. An
+ * external model only needs this header (and -lrt on some systems).
+ *
+ *    $cosim_shm("/name", sig0, sig1, ...);
+ *
+ * creates the POSIX shared memory object "/name" (the model attaches
+ * with the same name) and watches the listed signals. The signals are
+ * numbered in the order they are listed. It is an error if "/name"
+ * already exists, since another simulation may be using it. A name
+ * left behind by a simulation that crashed is removed first if the
+ * +cosim_shm_replace argument is given to vvp. The simulation and the
+ * model then take turns:
+ *
+ *  - At the end of every time step where a signal changed (and at the
+ *    time of the $cosim_shm call), the simulation sends a VALUE
+ *    message for each signal that changed, followed by one SYNC
+ *    message that carries the simulation time. Every signal is sent
+ *    once per time step, no matter how often it changed.
+ *
+ *  - The simulation then waits for the model to reply with any number
+ *    of PUT messages, followed by one RUN message. The RUN argument D
+ *    is a delay in simulation ticks. The PUT values are written D
+ *    ticks later (D is taken as 1 if it is 0 and there are PUT
+ *    messages), and a SYNC is always sent at that time. A D of 0 with
+ *    no PUT messages lets the simulation run until a watched signal
+ *    changes.
+ *
+ *  - A FINISH message from the model ends the simulation. The
+ *    simulation sends FINISH to the model when it ends.
+ *
+ * The values in VALUE and PUT messages are words of (aval, bval)
+ * pairs, 32 bits each, in the encoding of a s_vpi_vecval.
+ *
+ * Each direction has its own single producer, single consumer ring
+ * buffer. The producer makes the messages of a batch visible with a
+ * single update of the ring head, so that a whole time step is handed
+ * over at once.
+ *
+ * Each side writes its process id into the header, and a side that is
+ * waiting for the other gives up with an error if that process no
+ * longer exists.
+ */
+
+# include  <stdint.h>
+# include  <string.h>
+# include  <errno.h>
+# include  <sched.h>
+# include  <signal.h>
+# include  <fcntl.h>
+# include  <unistd.h>
+# include  <sys/mman.h>
+# include  <sys/stat.h>
+
+#define COSIM_SHM_MAGIC   0x49564c43
+#define COSIM_SHM_VERSION 1
+  /* The size of each ring buffer. This must be a power of 2. */
+#define COSIM_SHM_RING_BYTES (1024*1024)
+
+#define COSIM_MSG_VALUE  1
+#define COSIM_MSG_SYNC   2
+#define COSIM_MSG_PUT    3
+#define COSIM_MSG_RUN    4
+#define COSIM_MSG_FINISH 5
+
+struct cosim_shm_msg {
+      uint32_t type;
+      uint32_t index;
+      uint64_t arg;
+};
+
+struct cosim_shm_ring {
+	/* The head and tail count bytes, and are kept in separate
+	   cache lines since each is written by only one side. */
+      volatile uint32_t head;
+      uint32_t pad0[15];
+      volatile uint32_t tail;
+      uint32_t pad1[15];
+      unsigned char data[COSIM_SHM_RING_BYTES];
+};
+
+struct cosim_shm_header {
+      volatile uint32_t magic;
+      uint32_t version;
+      uint32_t nsignals;
+      uint32_t pad0;
+	/* The width of each signal follows the header, and then the
+	   ring to the model and the ring to the simulation. */
+      uint64_t ring_off[2];
+      uint64_t size;
+	/* The process id of the simulation and of the model. The
+	   model id is 0 until it attaches. */
+      volatile uint32_t pid[2];
+};
+
+struct cosim_shm_chan {
+      struct cosim_shm_header*hdr;
+      const uint32_t*width;
+      struct cosim_shm_ring*tx;
+      struct cosim_shm_ring*rx;
+      int sim_side;
+	/* Local copies of the ring positions this side owns. */
+      uint32_t tx_head;
+      uint32_t rx_tail;
+};
+
+static inline void cosim_shm_barrier(void)
+{
+      __sync_synchronize();
+}
+
+static inline unsigned cosim_shm_words(const struct cosim_shm_chan*chan,
+				       uint32_t index)
+{
+      return (chan->width[index] + 31) / 32;
+}
+
+static inline uint64_t cosim_shm_layout(uint32_t nsignals, uint64_t ring_off[2])
+{
+      uint64_t off = sizeof(struct cosim_shm_header) + 4*(uint64_t)nsignals;
+      off = (off + 63) & ~(uint64_t)63;
+      ring_off[0] = off;
+      ring_off[1] = off + sizeof(struct cosim_shm_ring);
+      return off + 2*sizeof(struct cosim_shm_ring);
+}
+
+static inline void cosim_shm_setup(struct cosim_shm_chan*chan, void*base, int sim_side)
+{
+      struct cosim_shm_ring*to_model, *to_sim;
+
+      chan->hdr = (struct cosim_shm_header*)base;
+      chan->width = (const uint32_t*)(chan->hdr + 1);
+      to_model = (struct cosim_shm_ring*)((char*)base + chan->hdr->ring_off[0]);
+      to_sim   = (struct cosim_shm_ring*)((char*)base + chan->hdr->ring_off[1]);
+      chan->tx = sim_side? to_model : to_sim;
+      chan->rx = sim_side? to_sim : to_model;
+      chan->sim_side = sim_side;
+      chan->tx_head = chan->tx->head;
+      chan->rx_tail = chan->rx->tail;
+}
+
+/*
+ * Return true if the process on the other side of the channel has
+ * gone away. A model that has not attached yet is not gone.
+ */
+static inline int cosim_shm_peer_gone(const struct cosim_shm_chan*chan)
+{
+      pid_t pid = (pid_t)chan->hdr->pid[chan->sim_side? 1 : 0];
+      return pid != 0 && kill(pid, 0) < 0 && errno == ESRCH;
+}
+
+/*
+ * The simulation creates the channel. If replace is true, an existing
+ * object with the same name is removed first. Return 0 on success or
+ * -1 with errno set if the shared memory object cannot be created. An
+ * errno of EEXIST means that the name is already in use.
+ */
+static inline int cosim_shm_create(struct cosim_shm_chan*chan, const char*name,
+				   uint32_t nsignals, const uint32_t*width,
+				   int replace)
+{
+      uint64_t ring_off[2];
+      uint64_t size = cosim_shm_layout(nsignals, ring_off);
+      struct cosim_shm_header*hdr;
+      void*base;
+      int fd;
+
+      if (replace)
+	    shm_unlink(name);
+      fd = shm_open(name, O_RDWR|O_CREAT|O_EXCL, 0600);
+      if (fd < 0)
+	    return -1;
+      if (ftruncate(fd, (off_t)size) < 0) {
+	    int err = errno;
+	    close(fd);
+	    shm_unlink(name);
+	    errno = err;
+	    return -1;
+      }
+      base = mmap(0, size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+      if (base == MAP_FAILED) {
+	    int err = errno;
+	    close(fd);
+	    shm_unlink(name);
+	    errno = err;
+	    return -1;
+      }
+      close(fd);
+
+      hdr = (struct cosim_shm_header*)base;
+      hdr->version = COSIM_SHM_VERSION;
+      hdr->nsignals = nsignals;
+      hdr->ring_off[0] = ring_off[0];
+      hdr->ring_off[1] = ring_off[1];
+      hdr->size = size;
+      hdr->pid[0] = (uint32_t)getpid();
+      hdr->pid[1] = 0;
+      memcpy(hdr + 1, width, 4*(size_t)nsignals);
+      cosim_shm_setup(chan, base, 1);
+
+	/* The magic number is written last. It tells the model that
+	   the channel is ready. */
+      cosim_shm_barrier();
+      hdr->magic = COSIM_SHM_MAGIC;
+      return 0;
+}
+
+/*
+ * The model attaches to a channel that the simulation created. This
+ * waits for the simulation to create the channel. Return 0 on success
+ * or -1 if the channel is not valid.
+ */
+static inline int cosim_shm_attach(struct cosim_shm_chan*chan, const char*name)
+{
+      struct cosim_shm_header*hdr;
+      struct stat st;
+      void*base;
+      int fd;
+
+      for (;;) {
+	    fd = shm_open(name, O_RDWR, 0);
+	    if (fd >= 0 && fstat(fd, &st) == 0
+		&& (uint64_t)st.st_size >= sizeof(struct cosim_shm_header)) {
+		  base = mmap(0, st.st_size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+		  close(fd);
+		  if (base == MAP_FAILED)
+			return -1;
+		  hdr = (struct cosim_shm_header*)base;
+		  while (hdr->magic != COSIM_SHM_MAGIC)
+			sched_yield();
+		  cosim_shm_barrier();
+		  if (hdr->version != COSIM_SHM_VERSION
+		      || hdr->size != (uint64_t)st.st_size) {
+			munmap(base, st.st_size);
+			return -1;
+		  }
+		  cosim_shm_setup(chan, base, 0);
+		  hdr->pid[1] = (uint32_t)getpid();
+		  return 0;
+	    }
+	    if (fd >= 0)
+		  close(fd);
+	    usleep(1000);
+      }
+}
+
+static inline void cosim_shm_close(struct cosim_shm_chan*chan, const char*name)
+{
+      munmap(chan->hdr, chan->hdr->size);
+      chan->hdr = 0;
+      if (name)
+	    shm_unlink(name);
+}
+
+/*
+ * Make the messages sent so far visible to the other side.
+ */
+static inline void cosim_shm_flush(struct cosim_shm_chan*chan)
+{
+      cosim_shm_barrier();
+      chan->tx->head = chan->tx_head;
+}
+
+/*
+ * Wait a little for the other side. Spin for a while before giving up
+ * the processor, so that a quick reply is seen with little latency,
+ * and check now and then that the other side is still there. Return
+ * -1 if it is gone.
+ */
+static inline int cosim_shm_wait_(const struct cosim_shm_chan*chan,
+				  unsigned*spin)
+{
+      *spin += 1;
+      if (*spin <= 1000)
+	    return 0;
+      if (*spin % 1024 == 0 && cosim_shm_peer_gone(chan))
+	    return -1;
+      sched_yield();
+      return 0;
+}
+
+static inline int cosim_shm_put_bytes_(struct cosim_shm_chan*chan,
+				       const void*src, uint32_t len)
+{
+      const unsigned char*bytes = (const unsigned char*)src;
+      unsigned spin = 0;
+
+      while (len > 0) {
+	    uint32_t pos = chan->tx_head & (COSIM_SHM_RING_BYTES-1);
+	    uint32_t cnt = COSIM_SHM_RING_BYTES - pos;
+	    uint32_t room = COSIM_SHM_RING_BYTES - (chan->tx_head - chan->tx->tail);
+	    if (cnt > len) cnt = len;
+	    if (cnt > room) cnt = room;
+
+	      /* The ring is full, so publish what we have and wait
+		 for the other side to drain it. */
+	    if (cnt == 0) {
+		  cosim_shm_flush(chan);
+		  if (cosim_shm_wait_(chan, &spin) < 0)
+			return -1;
+		  continue;
+	    }
+
+	    memcpy(chan->tx->data + pos, bytes, cnt);
+	    chan->tx_head += cnt;
+	    bytes += cnt;
+	    len -= cnt;
+      }
+      return 0;
+}
+
+static inline int cosim_shm_get_bytes_(struct cosim_shm_chan*chan,
+				       void*dst, uint32_t len)
+{
+      unsigned char*bytes = (unsigned char*)dst;
+      unsigned spin = 0;
+
+      while (len > 0) {
+	    uint32_t pos = chan->rx_tail & (COSIM_SHM_RING_BYTES-1);
+	    uint32_t cnt = COSIM_SHM_RING_BYTES - pos;
+	    uint32_t avail = chan->rx->head - chan->rx_tail;
+	    if (cnt > len) cnt = len;
+	    if (cnt > avail) cnt = avail;
+
+	    if (cnt == 0) {
+		  if (cosim_shm_wait_(chan, &spin) < 0)
+			return -1;
+		  continue;
+	    }
+
+	    cosim_shm_barrier();
+	    memcpy(bytes, chan->rx->data + pos, cnt);
+	    chan->rx_tail += cnt;
+	    bytes += cnt;
+	    len -= cnt;
+      }
+      cosim_shm_barrier();
+      chan->rx->tail = chan->rx_tail;
+      return 0;
+}
+
+/*
+ * Send a message. The words are only sent for VALUE and PUT messages,
+ * and there must be 2*cosim_shm_words(chan,index) of them. Return -1
+ * if the other side has gone away, and 0 otherwise.
+ */
+static inline int cosim_shm_send(struct cosim_shm_chan*chan, uint32_t type,
+				  uint32_t index, uint64_t arg,
+				  const uint32_t*words)
+{
+      struct cosim_shm_msg msg;
+      msg.type = type;
+      msg.index = index;
+      msg.arg = arg;
+      if (cosim_shm_put_bytes_(chan, &msg, sizeof msg) < 0)
+	    return -1;
+      if (type == COSIM_MSG_VALUE || type == COSIM_MSG_PUT)
+	    return cosim_shm_put_bytes_(chan, words,
+					8*cosim_shm_words(chan, index));
+      return 0;
+}
+
+/*
+ * Wait for and receive a message. For VALUE and PUT messages, the
+ * value is written into the words, which must have room for
+ * 2*cosim_shm_words(chan,msg->index) words. Return -1 if the other
+ * side has gone away, -2 if the message refers to a signal that does
+ * not exist, and 0 otherwise.
+ */
+static inline int cosim_shm_recv(struct cosim_shm_chan*chan,
+				 struct cosim_shm_msg*msg, uint32_t*words)
+{
+      if (cosim_shm_get_bytes_(chan, msg, sizeof *msg) < 0)
+	    return -1;
+      if (msg->type == COSIM_MSG_VALUE || msg->type == COSIM_MSG_PUT) {
+	    if (msg->index >= chan->hdr->nsignals)
+		  return -2;
+	    return cosim_shm_get_bytes_(chan, words,
+					8*cosim_shm_words(chan, msg->index));
+      }
+      return 0;
+}
+
+#endif /* IVL_cosim_shm_H */
@@ -47,7 +47,7 @@
 #undef FST_WRITER_PARALLEL
 #endif
 
-#ifdef FST_WRITER_PARALLEL
+#if defined(FST_WRITER_PARALLEL) || defined(HAVE_LIBPTHREAD)
 #include <pthread.h>
 #endif
 
@@ -704,6 +704,10 @@ unsigned active : 1;
 };
 
 
+#ifdef HAVE_LIBPTHREAD
+struct fstPackPool;
+#endif
+
 struct fstWriterContext
 {
 FILE *handle;
@@ -762,6 +766,11 @@ unsigned flush_context_pending : 1;
 unsigned parallel_enabled : 1;
 unsigned parallel_was_enabled : 1;
 
+unsigned int compress_threads; /* number of workers packing value change chains */
+#ifdef HAVE_LIBPTHREAD
+struct fstPackPool *pack_pool;  /* the workers, kept from flush to flush */
+#endif
+
 /* should really be semaphores, but are bytes to cut down on read-modify-write window size */
 unsigned char already_in_flush; /* in case control-c handlers interrupt */
 unsigned char already_in_close; /* in case control-c handlers interrupt */
@@ -1218,6 +1227,465 @@ if(xc)
 }
 
 
+/*
+ * value change chains are packed (and compressed) one handle at a time,
+ * this is split out so that worker threads can pack several at once
+ */
+struct fstPackScratch
+{
+unsigned char *scratchpad;
+uint32_t scratchlen;
+unsigned char *packmem;
+unsigned int packmemlen;
+};
+
+struct fstPackedChain
+{
+unsigned char *mem;     /* bytes to write for this chain */
+uint32_t len;           /* length of mem */
+uint32_t wrlen;         /* uncompressed length, zero if mem is not compressed */
+uint32_t unclen;        /* uncompressed length for reader memory requirements */
+};
+
+
+static void fstWriterPackChain(struct fstWriterContext *xc, uint32_t *vm4ip, struct fstPackScratch *ps, struct fstPackedChain *pc)
+{
+unsigned char *vchg_mem = xc->vchg_mem;
+uint32_t offs = vm4ip[2];
+uint32_t next_offs;
+unsigned int wrlen;
+unsigned char *scratchpnt = ps->scratchpad + ps->scratchlen;    /* build this buffer backwards */
+
+if(vm4ip[1] <= 1)
+        {
+        if(vm4ip[1] == 1)
+                {
+                wrlen = fstGetVarint32Length(vchg_mem + offs + 4); /* used to advance and determine wrlen */
+#ifndef FST_REMOVE_DUPLICATE_VC
+                xc->curval_mem[vm4ip[0]] = vchg_mem[offs + 4 + wrlen]; /* checkpoint variable */
+#endif
+                while(offs)
+                        {
+                        unsigned char val;
+                        uint32_t time_delta, rcv;
+                        next_offs = fstGetUint32(vchg_mem + offs);
+                        offs += 4;
+
+                        time_delta = fstGetVarint32(vchg_mem + offs, (int *)&wrlen);
+                        val = vchg_mem[offs+wrlen];
+                        offs = next_offs;
+
+                        switch(val)
+                                {
+                                case '0':
+                                case '1':               rcv = ((val&1)<<1) | (time_delta<<2);
+                                                        break; /* pack more delta bits in for 0/1 vchs */
+
+                                case 'x': case 'X':     rcv = FST_RCV_X | (time_delta<<4); break;
+                                case 'z': case 'Z':     rcv = FST_RCV_Z | (time_delta<<4); break;
+                                case 'h': case 'H':     rcv = FST_RCV_H | (time_delta<<4); break;
+                                case 'u': case 'U':     rcv = FST_RCV_U | (time_delta<<4); break;
+                                case 'w': case 'W':     rcv = FST_RCV_W | (time_delta<<4); break;
+                                case 'l': case 'L':     rcv = FST_RCV_L | (time_delta<<4); break;
+                                default:                rcv = FST_RCV_D | (time_delta<<4); break;
+                                }
+
+                        scratchpnt = fstCopyVarint32ToLeft(scratchpnt, rcv);
+                        }
+                }
+                else
+                {
+                /* variable length */
+                /* fstGetUint32 (next_offs) + fstGetVarint32 (time_delta) + fstGetVarint32 (len) + payload */
+                unsigned char *pnt;
+                uint32_t record_len;
+                uint32_t time_delta;
+
+                while(offs)
+                        {
+                        next_offs = fstGetUint32(vchg_mem + offs);
+                        offs += 4;
+                        pnt = vchg_mem + offs;
+                        offs = next_offs;
+                        time_delta = fstGetVarint32(pnt, (int *)&wrlen);
+                        pnt += wrlen;
+                        record_len = fstGetVarint32(pnt, (int *)&wrlen);
+                        pnt += wrlen;
+
+                        scratchpnt -= record_len;
+                        memcpy(scratchpnt, pnt, record_len);
+
+                        scratchpnt = fstCopyVarint32ToLeft(scratchpnt, record_len);
+                        scratchpnt = fstCopyVarint32ToLeft(scratchpnt, (time_delta << 1)); /* reserve | 1 case for future expansion */
+                        }
+                }
+        }
+        else
+        {
+        wrlen = fstGetVarint32Length(vchg_mem + offs + 4); /* used to advance and determine wrlen */
+#ifndef FST_REMOVE_DUPLICATE_VC
+        memcpy(xc->curval_mem + vm4ip[0], vchg_mem + offs + 4 + wrlen, vm4ip[1]); /* checkpoint variable */
+#endif
+        while(offs)
+                {
+                unsigned int idx;
+                char is_binary = 1;
+                unsigned char *pnt;
+                uint32_t time_delta;
+
+                next_offs = fstGetUint32(vchg_mem + offs);
+                offs += 4;
+
+                time_delta = fstGetVarint32(vchg_mem + offs, (int *)&wrlen);
+
+                pnt = vchg_mem+offs+wrlen;
+                offs = next_offs;
+
+                for(idx=0;idx<vm4ip[1];idx++)
+                        {
+                        if((pnt[idx] == '0') || (pnt[idx] == '1'))
+                                {
+                                continue;
+                                }
+                                else
+                                {
+                                is_binary = 0;
+                                break;
+                                }
+                        }
+
+                if(is_binary)
+                        {
+                        unsigned char acc = 0;
+                        /* new algorithm */
+                        idx = ((vm4ip[1]+7) & ~7);
+                        switch(vm4ip[1] & 7)
+                                {
+                                case 0: do {    acc  = (pnt[idx+7-8] & 1) << 0;
+                                case 7:         acc |= (pnt[idx+6-8] & 1) << 1;
+                                case 6:         acc |= (pnt[idx+5-8] & 1) << 2;
+                                case 5:         acc |= (pnt[idx+4-8] & 1) << 3;
+                                case 4:         acc |= (pnt[idx+3-8] & 1) << 4;
+                                case 3:         acc |= (pnt[idx+2-8] & 1) << 5;
+                                case 2:         acc |= (pnt[idx+1-8] & 1) << 6;
+                                case 1:         acc |= (pnt[idx+0-8] & 1) << 7;
+                                                *(--scratchpnt) = acc;
+                                                idx -= 8;
+                                        } while(idx);
+                                }
+
+                        scratchpnt = fstCopyVarint32ToLeft(scratchpnt, (time_delta << 1));
+                        }
+                        else
+                        {
+                        scratchpnt -= vm4ip[1];
+                        memcpy(scratchpnt, pnt, vm4ip[1]);
+
+                        scratchpnt = fstCopyVarint32ToLeft(scratchpnt, (time_delta << 1) | 1);
+                        }
+                }
+        }
+
+
+wrlen = ps->scratchpad + ps->scratchlen - scratchpnt;
+pc->mem = scratchpnt;
+pc->len = wrlen;
+pc->wrlen = 0;
+pc->unclen = wrlen;
+
+if(wrlen > 32)
+        {
+        unsigned long destlen = wrlen;
+        unsigned char *dmem;
+        unsigned int rc;
+
+        if(!xc->fastpack)
+                {
+                if(wrlen <= ps->packmemlen)
+                        {
+                        dmem = ps->packmem;
+                        }
+                        else
+                        {
+                        free(ps->packmem);
+                        dmem = ps->packmem = malloc(compressBound(ps->packmemlen = wrlen));
+                        }
+
+                rc = compress2(dmem, &destlen, scratchpnt, wrlen, 4);
+                if(rc == Z_OK)
+                        {
+                        pc->mem = dmem;
+                        pc->len = destlen;
+                        pc->wrlen = wrlen;
+                        }
+                }
+                else
+                {
+                /* this is extremely conservative: fastlz needs +5% for worst case, lz4 needs siz+(siz/255)+16 */
+                if(((wrlen * 2) + 2) <= ps->packmemlen)
+                        {
+                        dmem = ps->packmem;
+                        }
+                        else
+                        {
+                        free(ps->packmem);
+                        dmem = ps->packmem = malloc(ps->packmemlen = (wrlen * 2) + 2);
+                        }
+
+                rc = (xc->fourpack) ? LZ4_compress((char *)scratchpnt, (char *)dmem, wrlen) : fastlz_compress(scratchpnt, wrlen, dmem);
+                if(rc < destlen)
+                        {
+                        pc->mem = dmem;
+                        pc->len = rc;
+                        pc->wrlen = wrlen;
+                        }
+                }
+        }
+}
+
+
+#ifdef HAVE_LIBPTHREAD
+/*
+ * the compress_threads workers are started once and wait for the
+ * flushes, each packs the handles first, first+stride, ... of a flush
+ */
+struct fstPackWorker
+{
+struct fstPackPool *pool;
+uint32_t first;
+struct fstPackScratch ps;
+pthread_t thread;
+int started;
+};
+
+struct fstPackPool
+{
+pthread_mutex_t mutex;
+pthread_cond_t work_cond;       /* a new flush is ready */
+pthread_cond_t done_cond;       /* the last busy worker is done */
+unsigned int nthreads;
+unsigned int generation;        /* counts flushes */
+unsigned int busy;
+int quit;
+struct fstWriterContext *xc;    /* the flush being packed */
+struct fstPackedChain *packed;
+struct fstPackWorker *workers;
+};
+
+
+/*
+ * an upper bound of the packed size of a chain, each record packs into
+ * no more than a 5 byte varint plus its value (and its length varint)
+ */
+static uint32_t fstWriterChainBound(struct fstWriterContext *xc, uint32_t *vm4ip)
+{
+unsigned char *vchg_mem = xc->vchg_mem;
+uint32_t offs = vm4ip[2];
+uint32_t bound = 0;
+
+while(offs)
+        {
+        uint32_t next_offs = fstGetUint32(vchg_mem + offs);
+
+        if(vm4ip[1])
+                {
+                bound += 5 + vm4ip[1];
+                }
+                else
+                {
+                unsigned char *pnt = vchg_mem + offs + 4;
+                int wrlen;
+
+                pnt += fstGetVarint32Length(pnt);
+                bound += 10 + fstGetVarint32(pnt, &wrlen);
+                }
+
+        offs = next_offs;
+        }
+
+return(bound);
+}
+
+
+static void fstWriterPackSlice(struct fstPackWorker *w, struct fstWriterContext *xc, struct fstPackedChain *packed)
+{
+struct fstPackScratch *ps = &w->ps;
+uint32_t stride = w->pool->nthreads;
+uint32_t i;
+
+for(i=w->first;i<xc->maxhandle;i+=stride)
+        {
+        uint32_t *vm4ip = &(xc->valpos_mem[4*i]);
+
+        if(vm4ip[2])
+                {
+                struct fstPackedChain *pc = &packed[i];
+                uint32_t bound = fstWriterChainBound(xc, vm4ip);
+                unsigned char *mem;
+
+                if(bound > ps->scratchlen)      /* grows to the longest chain of this slice */
+                        {
+                        free(ps->scratchpad);
+                        ps->scratchpad = malloc(ps->scratchlen = bound);
+                        }
+
+                fstWriterPackChain(xc, vm4ip, ps, pc);
+                mem = malloc(pc->len ? pc->len : 1);    /* scratch buffers are reused, so keep a copy */
+                memcpy(mem, pc->mem, pc->len);
+                pc->mem = mem;
+                }
+        }
+}
+
+
+static void *fstWriterPackWorker(void *ctx)
+{
+struct fstPackWorker *w = (struct fstPackWorker *)ctx;
+struct fstPackPool *pool = w->pool;
+unsigned int seen = 0;
+
+pthread_mutex_lock(&pool->mutex);
+for(;;)
+        {
+        struct fstWriterContext *xc;
+        struct fstPackedChain *packed;
+
+        while((pool->generation == seen) && !pool->quit)
+                {
+                pthread_cond_wait(&pool->work_cond, &pool->mutex);
+                }
+        if(pool->quit) break;
+
+        seen = pool->generation;
+        xc = pool->xc;
+        packed = pool->packed;
+        pthread_mutex_unlock(&pool->mutex);
+
+        fstWriterPackSlice(w, xc, packed);
+
+        pthread_mutex_lock(&pool->mutex);
+        if(--pool->busy == 0)
+                {
+                pthread_cond_signal(&pool->done_cond);
+                }
+        }
+pthread_mutex_unlock(&pool->mutex);
+
+return(NULL);
+}
+
+
+static struct fstPackPool *fstWriterPackPoolCreate(unsigned int nthreads)
+{
+struct fstPackPool *pool = calloc(1, sizeof(struct fstPackPool));
+unsigned int i;
+
+pthread_mutex_init(&pool->mutex, NULL);
+pthread_cond_init(&pool->work_cond, NULL);
+pthread_cond_init(&pool->done_cond, NULL);
+pool->nthreads = nthreads;
+pool->workers = calloc(nthreads, sizeof(struct fstPackWorker));
+
+for(i=0;i<nthreads;i++)
+        {
+        struct fstPackWorker *w = &pool->workers[i];
+
+        w->pool = pool;
+        w->first = i;
+        w->ps.packmemlen = 1024;
+        w->ps.packmem = malloc(w->ps.packmemlen);
+        }
+
+/* worker 0 runs in the flushing thread */
+for(i=1;i<nthreads;i++)
+        {
+        struct fstPackWorker *w = &pool->workers[i];
+
+        w->started = !pthread_create(&w->thread, NULL, fstWriterPackWorker, w);  /* if not, packed by the flush */
+        }
+
+return(pool);
+}
+
+
+static void fstWriterPackPoolDestroy(struct fstPackPool *pool)
+{
+unsigned int i;
+
+if(!pool) return;
+
+pthread_mutex_lock(&pool->mutex);
+pool->quit = 1;
+pthread_cond_broadcast(&pool->work_cond);
+pthread_mutex_unlock(&pool->mutex);
+
+for(i=0;i<pool->nthreads;i++)
+        {
+        struct fstPackWorker *w = &pool->workers[i];
+
+        if(w->started)
+                {
+                pthread_join(w->thread, NULL);
+                }
+        free(w->ps.packmem);
+        free(w->ps.scratchpad);
+        }
+
+pthread_cond_destroy(&pool->done_cond);
+pthread_cond_destroy(&pool->work_cond);
+pthread_mutex_destroy(&pool->mutex);
+free(pool->workers);
+free(pool);
+}
+
+
+/*
+ * pack all the value change chains of a section with the pack_pool
+ * workers, returns NULL if the chains are to be packed inline
+ */
+static struct fstPackedChain *fstWriterPackChainsParallel(struct fstWriterContext *xc)
+{
+struct fstPackPool *pool = xc->pack_pool;
+struct fstPackedChain *packed;
+unsigned int i, busy = 0;
+
+if((!pool) || (xc->maxhandle < pool->nthreads)) return(NULL);
+
+packed = calloc(xc->maxhandle, sizeof(struct fstPackedChain));
+
+for(i=1;i<pool->nthreads;i++)
+        {
+        if(pool->workers[i].started) busy++;
+        }
+
+pthread_mutex_lock(&pool->mutex);
+pool->xc = xc;
+pool->packed = packed;
+pool->busy = busy;
+pool->generation++;
+pthread_cond_broadcast(&pool->work_cond);
+pthread_mutex_unlock(&pool->mutex);
+
+for(i=0;i<pool->nthreads;i++)
+        {
+        if(!pool->workers[i].started)
+                {
+                fstWriterPackSlice(&pool->workers[i], xc, packed);
+                }
+        }
+
+pthread_mutex_lock(&pool->mutex);
+while(pool->busy)
+        {
+        pthread_cond_wait(&pool->done_cond, &pool->mutex);
+        }
+pthread_mutex_unlock(&pool->mutex);
+
+return(packed);
+}
+#endif
+
+
 /*
  * only to be called directly by fst code...otherwise must
  * be synced up with time changes
@@ -1232,18 +1700,15 @@ static void fstWriterFlushContextPrivate(void *ctx)
 int cnt = 0;
 #endif
 unsigned int i;
-unsigned char *vchg_mem;
 FILE *f;
 off_t fpos, indxpos, endpos;
 uint32_t prevpos;
 int zerocnt;
-unsigned char *scratchpad;
-unsigned char *scratchpnt;
+struct fstPackScratch ps;
+struct fstPackedChain *packed = NULL;
 unsigned char *tmem;
 off_t tlen;
 off_t unc_memreq = 0; /* for reader */
-unsigned char *packmem;
-unsigned int packmemlen;
 uint32_t *vm4ip;
 struct fstWriterContext *xc = (struct fstWriterContext *)ctx;
 #ifdef FST_WRITER_PARALLEL
@@ -1268,17 +1733,20 @@ if((xc->vchg_siz <= 1)||(xc->already_in_flush)) return;
 xc->already_in_flush = 1; /* should really do this with a semaphore */
 
 xc->section_header_only = 0;
-scratchpad = malloc(xc->vchg_siz);
-
-vchg_mem = xc->vchg_mem;
 
 f = xc->handle;
 fstWriterVarint(f, xc->maxhandle);      /* emit current number of handles */
 fputc(xc->fourpack ? '4' : (xc->fastpack ? 'F' : 'Z'), f);
 fpos = 1;
 
-packmemlen = 1024;                      /* maintain a running "longest" allocation to */
-packmem = malloc(packmemlen);           /* prevent continual malloc...free every loop iter */
+#ifdef HAVE_LIBPTHREAD
+packed = fstWriterPackChainsParallel(xc);
+#endif
+
+ps.scratchpad = packed ? NULL : malloc(xc->vchg_siz);
+ps.scratchlen = xc->vchg_siz;
+ps.packmemlen = 1024;                   /* maintain a running "longest" allocation to */
+ps.packmem = malloc(ps.packmemlen);     /* prevent continual malloc...free every loop iter */
 
 for(i=0;i<xc->maxhandle;i++)
         {
@@ -1286,265 +1754,23 @@ for(i=0;i<xc->maxhandle;i++)
 
         if(vm4ip[2])
                 {
-                uint32_t offs = vm4ip[2];
-                uint32_t next_offs;
-                unsigned int wrlen;
-
-                vm4ip[2] = fpos;
+                struct fstPackedChain pc;
 
-                scratchpnt = scratchpad + xc->vchg_siz;         /* build this buffer backwards */
-                if(vm4ip[1] <= 1)
+                if(packed)
                         {
-                        if(vm4ip[1] == 1)
-                                {
-                                wrlen = fstGetVarint32Length(vchg_mem + offs + 4); /* used to advance and determine wrlen */
-#ifndef FST_REMOVE_DUPLICATE_VC
-                                xc->curval_mem[vm4ip[0]] = vchg_mem[offs + 4 + wrlen]; /* checkpoint variable */
-#endif
-                                while(offs)
-                                        {
-                                        unsigned char val;
-                                        uint32_t time_delta, rcv;
-                                        next_offs = fstGetUint32(vchg_mem + offs);
-                                        offs += 4;
-
-                                        time_delta = fstGetVarint32(vchg_mem + offs, (int *)&wrlen);
-                                        val = vchg_mem[offs+wrlen];
-                                        offs = next_offs;
-
-                                        switch(val)
-                                                {
-                                                case '0':
-                                                case '1':               rcv = ((val&1)<<1) | (time_delta<<2);
-                                                                        break; /* pack more delta bits in for 0/1 vchs */
-
-                                                case 'x': case 'X':     rcv = FST_RCV_X | (time_delta<<4); break;
-                                                case 'z': case 'Z':     rcv = FST_RCV_Z | (time_delta<<4); break;
-                                                case 'h': case 'H':     rcv = FST_RCV_H | (time_delta<<4); break;
-                                                case 'u': case 'U':     rcv = FST_RCV_U | (time_delta<<4); break;
-                                                case 'w': case 'W':     rcv = FST_RCV_W | (time_delta<<4); break;
-                                                case 'l': case 'L':     rcv = FST_RCV_L | (time_delta<<4); break;
-                                                default:                rcv = FST_RCV_D | (time_delta<<4); break;
-                                                }
-
-                                        scratchpnt = fstCopyVarint32ToLeft(scratchpnt, rcv);
-                                        }
-                                }
-                                else
-                                {
-                                /* variable length */
-                                /* fstGetUint32 (next_offs) + fstGetVarint32 (time_delta) + fstGetVarint32 (len) + payload */
-                                unsigned char *pnt;
-                                uint32_t record_len;
-                                uint32_t time_delta;
-
-                                while(offs)
-                                        {
-                                        next_offs = fstGetUint32(vchg_mem + offs);
-                                        offs += 4;
-                                        pnt = vchg_mem + offs;
-                                        offs = next_offs;
-                                        time_delta = fstGetVarint32(pnt, (int *)&wrlen);
-                                        pnt += wrlen;
-                                        record_len = fstGetVarint32(pnt, (int *)&wrlen);
-                                        pnt += wrlen;
-
-                                        scratchpnt -= record_len;
-                                        memcpy(scratchpnt, pnt, record_len);
-
-                                        scratchpnt = fstCopyVarint32ToLeft(scratchpnt, record_len);
-                                        scratchpnt = fstCopyVarint32ToLeft(scratchpnt, (time_delta << 1)); /* reserve | 1 case for future expansion */
-                                        }
-                                }
+                        pc = packed[i];
                         }
                         else
                         {
-                        wrlen = fstGetVarint32Length(vchg_mem + offs + 4); /* used to advance and determine wrlen */
-#ifndef FST_REMOVE_DUPLICATE_VC
-                        memcpy(xc->curval_mem + vm4ip[0], vchg_mem + offs + 4 + wrlen, vm4ip[1]); /* checkpoint variable */
-#endif
-                        while(offs)
-                                {
-                                unsigned int idx;
-                                char is_binary = 1;
-                                unsigned char *pnt;
-                                uint32_t time_delta;
-
-                                next_offs = fstGetUint32(vchg_mem + offs);
-                                offs += 4;
-
-                                time_delta = fstGetVarint32(vchg_mem + offs, (int *)&wrlen);
-
-                                pnt = vchg_mem+offs+wrlen;
-                                offs = next_offs;
-
-                                for(idx=0;idx<vm4ip[1];idx++)
-                                        {
-                                        if((pnt[idx] == '0') || (pnt[idx] == '1'))
-                                                {
-                                                continue;
-                                                }
-                                                else
-                                                {
-                                                is_binary = 0;
-                                                break;
-                                                }
-                                        }
-
-                                if(is_binary)
-                                        {
-                                        unsigned char acc = 0;
-                                        /* new algorithm */
-                                        idx = ((vm4ip[1]+7) & ~7);
-                                        switch(vm4ip[1] & 7)
-                                                {
-                                                case 0: do {    acc  = (pnt[idx+7-8] & 1) << 0;
-                                                case 7:         acc |= (pnt[idx+6-8] & 1) << 1;
-                                                case 6:         acc |= (pnt[idx+5-8] & 1) << 2;
-                                                case 5:         acc |= (pnt[idx+4-8] & 1) << 3;
-                                                case 4:         acc |= (pnt[idx+3-8] & 1) << 4;
-                                                case 3:         acc |= (pnt[idx+2-8] & 1) << 5;
-                                                case 2:         acc |= (pnt[idx+1-8] & 1) << 6;
-                                                case 1:         acc |= (pnt[idx+0-8] & 1) << 7;
-                                                                *(--scratchpnt) = acc;
-                                                                idx -= 8;
-                                                        } while(idx);
-                                                }
-
-                                        scratchpnt = fstCopyVarint32ToLeft(scratchpnt, (time_delta << 1));
-                                        }
-                                        else
-                                        {
-                                        scratchpnt -= vm4ip[1];
-                                        memcpy(scratchpnt, pnt, vm4ip[1]);
-
-                                        scratchpnt = fstCopyVarint32ToLeft(scratchpnt, (time_delta << 1) | 1);
-                                        }
-                                }
+                        fstWriterPackChain(xc, vm4ip, &ps, &pc);
                         }
 
-                wrlen = scratchpad + xc->vchg_siz - scratchpnt;
-                unc_memreq += wrlen;
-                if(wrlen > 32)
-                        {
-                        unsigned long destlen = wrlen;
-                        unsigned char *dmem;
-                        unsigned int rc;
-
-                        if(!xc->fastpack)
-                                {
-                                if(wrlen <= packmemlen)
-                                        {
-                                        dmem = packmem;
-                                        }
-                                        else
-                                        {
-                                        free(packmem);
-                                        dmem = packmem = malloc(compressBound(packmemlen = wrlen));
-                                        }
-
-                                rc = compress2(dmem, &destlen, scratchpnt, wrlen, 4);
-                                if(rc == Z_OK)
-                                        {
-#ifndef FST_DYNAMIC_ALIAS_DISABLE
-                                        PPvoid_t pv = JudyHSIns(&PJHSArray, dmem, destlen, NULL);
-                                        if(*pv)
-                                                {
-                                                uint32_t pvi = (intptr_t)(*pv);
-                                                vm4ip[2] = -pvi;
-                                                }
-                                                else
-                                                {
-                                                *pv = (void *)(intptr_t)(i+1);
-#endif
-                                                fpos += fstWriterVarint(f, wrlen);
-                                                fpos += destlen;
-                                                fstFwrite(dmem, destlen, 1, f);
-#ifndef FST_DYNAMIC_ALIAS_DISABLE
-                                                }
-#endif
-                                        }
-                                        else
-                                        {
-#ifndef FST_DYNAMIC_ALIAS_DISABLE
-                                        PPvoid_t pv = JudyHSIns(&PJHSArray, scratchpnt, wrlen, NULL);
-                                        if(*pv)
-                                                {
-                                                uint32_t pvi = (intptr_t)(*pv);
-                                                vm4ip[2] = -pvi;
-                                                }
-                                                else
-                                                {
-                                                *pv = (void *)(intptr_t)(i+1);
-#endif
-                                                fpos += fstWriterVarint(f, 0);
-                                                fpos += wrlen;
-                                                fstFwrite(scratchpnt, wrlen, 1, f);
-#ifndef FST_DYNAMIC_ALIAS_DISABLE
-                                                }
-#endif
-                                        }
-                                }
-                                else
-                                {
-                                /* this is extremely conservative: fastlz needs +5% for worst case, lz4 needs siz+(siz/255)+16 */
-                                if(((wrlen * 2) + 2) <= packmemlen)
-                                        {
-                                        dmem = packmem;
-                                        }
-                                        else
-                                        {
-                                        free(packmem);
-                                        dmem = packmem = malloc(packmemlen = (wrlen * 2) + 2);
-                                        }
+                vm4ip[2] = fpos;
+                unc_memreq += pc.unclen;
 
-                                rc = (xc->fourpack) ? LZ4_compress((char *)scratchpnt, (char *)dmem, wrlen) : fastlz_compress(scratchpnt, wrlen, dmem);
-                                if(rc < destlen)
-                                        {
-#ifndef FST_DYNAMIC_ALIAS_DISABLE
-                                        PPvoid_t pv = JudyHSIns(&PJHSArray, dmem, rc, NULL);
-                                        if(*pv)
-                                                {
-                                                uint32_t pvi = (intptr_t)(*pv);
-                                                vm4ip[2] = -pvi;
-                                                }
-                                                else
-                                                {
-                                                *pv = (void *)(intptr_t)(i+1);
-#endif
-                                                fpos += fstWriterVarint(f, wrlen);
-                                                fpos += rc;
-                                                fstFwrite(dmem, rc, 1, f);
-#ifndef FST_DYNAMIC_ALIAS_DISABLE
-                                                }
-#endif
-                                        }
-                                        else
-                                        {
-#ifndef FST_DYNAMIC_ALIAS_DISABLE
-                                        PPvoid_t pv = JudyHSIns(&PJHSArray, scratchpnt, wrlen, NULL);
-                                        if(*pv)
-                                                {
-                                                uint32_t pvi = (intptr_t)(*pv);
-                                                vm4ip[2] = -pvi;
-                                                }
-                                                else
-                                                {
-                                                *pv = (void *)(intptr_t)(i+1);
-#endif
-                                                fpos += fstWriterVarint(f, 0);
-                                                fpos += wrlen;
-                                                fstFwrite(scratchpnt, wrlen, 1, f);
 #ifndef FST_DYNAMIC_ALIAS_DISABLE
-                                                }
-#endif
-                                        }
-                                }
-                        }
-                        else
                         {
-#ifndef FST_DYNAMIC_ALIAS_DISABLE
-                        PPvoid_t pv = JudyHSIns(&PJHSArray, scratchpnt, wrlen, NULL);
+                        PPvoid_t pv = JudyHSIns(&PJHSArray, pc.mem, pc.len, NULL);
                         if(*pv)
                                 {
                                 uint32_t pvi = (intptr_t)(*pv);
@@ -1554,12 +1780,17 @@ for(i=0;i<xc->maxhandle;i++)
                                 {
                                 *pv = (void *)(intptr_t)(i+1);
 #endif
-                                fpos += fstWriterVarint(f, 0);
-                                fpos += wrlen;
-                                fstFwrite(scratchpnt, wrlen, 1, f);
+                                fpos += fstWriterVarint(f, pc.wrlen);
+                                fpos += pc.len;
+                                fstFwrite(pc.mem, pc.len, 1, f);
 #ifndef FST_DYNAMIC_ALIAS_DISABLE
                                 }
+                        }
 #endif
+
+                if(packed)
+                        {
+                        free(pc.mem);
                         }
 
                 /* vm4ip[3] = 0; ...redundant with clearing below */
@@ -1573,10 +1804,11 @@ for(i=0;i<xc->maxhandle;i++)
 JudyHSFreeArray(&PJHSArray, NULL);
 #endif
 
-free(packmem); packmem = NULL; /* packmemlen = 0; */ /* scan-build */
+free(packed); packed = NULL;
+free(ps.packmem); ps.packmem = NULL; /* packmemlen = 0; */ /* scan-build */
 
 prevpos = 0; zerocnt = 0;
-free(scratchpad); scratchpad = NULL;
+free(ps.scratchpad); ps.scratchpad = NULL;
 
 indxpos = ftello(f);
 xc->secnum++;
@@ -2172,6 +2404,10 @@ if(xc && !xc->already_in_close && !xc->already_in_flush)
         }
 #endif
 
+#ifdef HAVE_LIBPTHREAD
+        fstWriterPackPoolDestroy(xc->pack_pool);
+#endif
+
 #ifdef FST_WRITER_PARALLEL
         pthread_mutex_destroy(&xc->mutex);
         pthread_attr_destroy(&xc->thread_attr);
@@ -2486,6 +2722,20 @@ if(xc)
 }
 
 
+void fstWriterSetCompressThreads(void *ctx, int nthreads)
+{
+struct fstWriterContext *xc = (struct fstWriterContext *)ctx;
+if(xc)
+        {
+        xc->compress_threads = (nthreads > 0) ? nthreads : 1;
+#ifdef HAVE_LIBPTHREAD
+        fstWriterPackPoolDestroy(xc->pack_pool);
+        xc->pack_pool = (xc->compress_threads > 1) ? fstWriterPackPoolCreate(xc->compress_threads) : NULL;
+#endif
+        }
+}
+
+
 void fstWriterSetDumpSizeLimit(void *ctx, uint64_t numbytes)
 {
 struct fstWriterContext *xc = (struct fstWriterContext *)ctx;
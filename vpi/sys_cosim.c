@@ -0,0 +1,446 @@
+/*
+ * Copyright (c) 2026 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+# include  "sys_priv.h"
+# include  <assert.h>
+# include  <errno.h>
+# include  <stdlib.h>
+# include  <string.h>
+# include  "ivl_alloc.h"
+
+/*
+ * This file implements the $cosim_shm system task, which connects a
+ * set of signals to an external model through a shared memory
+ * channel. The channel and the protocol are described in cosim_shm.h.
+ */
+
+#ifdef HAVE_SHM_OPEN
+# include  "cosim_shm.h"
+
+struct cosim_signal {
+      struct cosim_info*info;
+      unsigned index;
+      unsigned changed;
+};
+
+struct cosim_info {
+      char*name;
+      struct cosim_shm_chan chan;
+      unsigned nsignals;
+      vpiHandle*handles;
+      struct cosim_signal*signals;
+	/* The signals that changed in this time step. */
+      unsigned*changed;
+      unsigned nchanged;
+      unsigned sync_scheduled;
+      unsigned finished;
+	/* Space for the value of the widest signal. */
+      uint32_t*words;
+      s_vpi_vecval*vecval;
+};
+
+/*
+ * The PUT messages of a reply are kept until the time they are to be
+ * written. The puts array holds the index and then the words of each
+ * value.
+ */
+struct cosim_wakeup {
+      struct cosim_info*info;
+      uint32_t*puts;
+      unsigned nputs;
+};
+
+static PLI_INT32 cosim_sync_cb(p_cb_data cause);
+
+static void schedule_sync(struct cosim_info*info)
+{
+      struct t_cb_data cb;
+      struct t_vpi_time zero_delay;
+
+      if (info->sync_scheduled || info->finished)
+	    return;
+
+      zero_delay.type = vpiSimTime;
+      zero_delay.high = 0;
+      zero_delay.low  = 0;
+      zero_delay.real = 0.0;
+
+      cb.reason = cbReadOnlySynch;
+      cb.cb_rtn = cosim_sync_cb;
+      cb.time = &zero_delay;
+      cb.obj = 0;
+      cb.value = 0;
+      cb.user_data = (char*)info;
+      vpi_free_object(vpi_register_cb(&cb));
+      info->sync_scheduled = 1;
+}
+
+static PLI_INT32 cosim_change_cb(p_cb_data cause)
+{
+      struct cosim_signal*sig = (struct cosim_signal*)cause->user_data;
+      struct cosim_info*info = sig->info;
+
+      if (sig->changed)
+	    return 0;
+
+      sig->changed = 1;
+      info->changed[info->nchanged++] = sig->index;
+      schedule_sync(info);
+      return 0;
+}
+
+static void get_words(struct cosim_info*info, unsigned idx)
+{
+      s_vpi_value val;
+      unsigned nwords = cosim_shm_words(&info->chan, idx);
+      unsigned wdx;
+
+      val.format = vpiVectorVal;
+      vpi_get_value(info->handles[idx], &val);
+      for (wdx = 0 ; wdx < nwords ; wdx += 1) {
+	    info->words[2*wdx+0] = val.value.vector[wdx].aval;
+	    info->words[2*wdx+1] = val.value.vector[wdx].bval;
+      }
+}
+
+static PLI_INT32 cosim_apply_cb(p_cb_data cause)
+{
+      struct cosim_wakeup*wake = (struct cosim_wakeup*)cause->user_data;
+      struct cosim_info*info = wake->info;
+      const uint32_t*cur = wake->puts;
+      unsigned idx;
+
+      for (idx = 0 ; idx < wake->nputs && !info->finished ; idx += 1) {
+	    unsigned sdx = *cur++;
+	    unsigned nwords = cosim_shm_words(&info->chan, sdx);
+	    unsigned wdx;
+	    s_vpi_value val;
+
+	    for (wdx = 0 ; wdx < nwords ; wdx += 1) {
+		  info->vecval[wdx].aval = cur[2*wdx+0];
+		  info->vecval[wdx].bval = cur[2*wdx+1];
+	    }
+	    cur += 2*nwords;
+
+	    val.format = vpiVectorVal;
+	    val.value.vector = info->vecval;
+	    vpi_put_value(info->handles[sdx], &val, 0, vpiNoDelay);
+      }
+
+      schedule_sync(info);
+      free(wake->puts);
+      free(wake);
+      return 0;
+}
+
+static void schedule_apply(struct cosim_wakeup*wake, PLI_UINT64 delay)
+{
+      struct t_cb_data cb;
+      struct t_vpi_time when;
+
+      when.type = vpiSimTime;
+      when.high = (PLI_UINT32)(delay >> 32);
+      when.low  = (PLI_UINT32)delay;
+      when.real = 0.0;
+
+      cb.reason = cbAfterDelay;
+      cb.cb_rtn = cosim_apply_cb;
+      cb.time = &when;
+      cb.obj = 0;
+      cb.value = 0;
+      cb.user_data = (char*)wake;
+      vpi_free_object(vpi_register_cb(&cb));
+}
+
+/*
+ * At the end of a time step, send the signals that changed and the
+ * time to the model, then wait for its reply.
+ */
+static PLI_INT32 cosim_sync_cb(p_cb_data cause)
+{
+      struct cosim_info*info = (struct cosim_info*)cause->user_data;
+      struct cosim_wakeup*wake;
+      struct cosim_shm_msg msg;
+      s_vpi_time now;
+      unsigned puts_size = 0;
+      unsigned idx;
+
+      info->sync_scheduled = 0;
+      if (info->finished)
+	    return 0;
+
+      for (idx = 0 ; idx < info->nchanged ; idx += 1) {
+	    unsigned sdx = info->changed[idx];
+	    get_words(info, sdx);
+	    cosim_shm_send(&info->chan, COSIM_MSG_VALUE, sdx, 0, info->words);
+	    info->signals[sdx].changed = 0;
+      }
+      info->nchanged = 0;
+
+      now.type = vpiSimTime;
+      vpi_get_time(0, &now);
+      cosim_shm_send(&info->chan, COSIM_MSG_SYNC, 0,
+                     timerec_to_time64(&now), 0);
+      cosim_shm_flush(&info->chan);
+
+      wake = (struct cosim_wakeup*)malloc(sizeof(struct cosim_wakeup));
+      wake->info = info;
+      wake->puts = 0;
+      wake->nputs = 0;
+
+      for (;;) {
+	    unsigned nwords;
+	    int rc = cosim_shm_recv(&info->chan, &msg, info->words);
+	    if (rc == -1) {
+		  vpi_printf("ERROR: $cosim_shm(%s): the model has gone "
+		             "away.\n", info->name);
+		  info->finished = 1;
+		  vpi_control(vpiFinish, 1);
+		  break;
+	    }
+	    if (rc < 0) {
+		  vpi_printf("ERROR: $cosim_shm(%s): the model sent a value "
+		             "for signal %u, which does not exist.\n",
+		             info->name, (unsigned)msg.index);
+		  info->finished = 1;
+		  vpi_control(vpiFinish, 1);
+		  break;
+	    }
+
+	    if (msg.type == COSIM_MSG_RUN)
+		  break;
+
+	    if (msg.type == COSIM_MSG_FINISH) {
+		  info->finished = 1;
+		  vpi_control(vpiFinish, 0);
+		  break;
+	    }
+
+	    if (msg.type != COSIM_MSG_PUT)
+		  continue;
+
+	    nwords = cosim_shm_words(&info->chan, msg.index);
+	    wake->puts = (uint32_t*)realloc(wake->puts, (puts_size + 1 + 2*nwords)
+	                                                * sizeof(uint32_t));
+	    wake->puts[puts_size] = msg.index;
+	    memcpy(wake->puts + puts_size + 1, info->words,
+	           2*nwords*sizeof(uint32_t));
+	    puts_size += 1 + 2*nwords;
+	    wake->nputs += 1;
+      }
+
+      if (info->finished || (msg.arg == 0 && wake->nputs == 0)) {
+	    free(wake->puts);
+	    free(wake);
+	    return 0;
+      }
+
+      schedule_apply(wake, msg.arg? msg.arg : 1);
+      return 0;
+}
+
+static PLI_INT32 cosim_finish_cb(p_cb_data cause)
+{
+      struct cosim_info*info = (struct cosim_info*)cause->user_data;
+
+      if (!info->finished) {
+	    cosim_shm_send(&info->chan, COSIM_MSG_FINISH, 0, 0, 0);
+	    cosim_shm_flush(&info->chan);
+      }
+	/* The model may still be reading the channel, so only remove
+	   the name. The memory goes away when both sides unmap it. */
+      cosim_shm_close(&info->chan, info->name);
+
+      free(info->name);
+      free(info->handles);
+      free(info->signals);
+      free(info->changed);
+      free(info->words);
+      free(info->vecval);
+      free(info);
+      return 0;
+}
+#endif
+
+static PLI_INT32 sys_cosim_shm_compiletf(ICARUS_VPI_CONST PLI_BYTE8 *name)
+{
+      vpiHandle callh = vpi_handle(vpiSysTfCall, 0);
+      vpiHandle argv = vpi_iterate(vpiArgument, callh);
+      vpiHandle arg;
+
+      if (argv == 0 || (arg = vpi_scan(argv)) == 0 || !is_string_obj(arg)) {
+	    vpi_printf("ERROR: %s:%d: ", vpi_get_str(vpiFile, callh),
+	               (int)vpi_get(vpiLineNo, callh));
+	    vpi_printf("%s requires a channel name as its first argument.\n",
+	               name);
+	    vpi_control(vpiFinish, 1);
+	    if (argv) vpi_free_object(argv);
+	    return 0;
+      }
+
+      while ((arg = vpi_scan(argv))) {
+	    switch (vpi_get(vpiType, arg)) {
+		case vpiNet:
+		case vpiReg:
+		case vpiIntegerVar:
+		case vpiBitVar:
+		case vpiByteVar:
+		case vpiShortIntVar:
+		case vpiIntVar:
+		case vpiLongIntVar:
+		  break;
+		default:
+		  vpi_printf("ERROR: %s:%d: ", vpi_get_str(vpiFile, callh),
+		             (int)vpi_get(vpiLineNo, callh));
+		  vpi_printf("%s cannot connect a %s.\n", name,
+		             vpi_get_str(vpiType, arg));
+		  vpi_control(vpiFinish, 1);
+		  break;
+	    }
+      }
+
+      return 0;
+}
+
+static PLI_INT32 sys_cosim_shm_calltf(ICARUS_VPI_CONST PLI_BYTE8 *name)
+{
+      vpiHandle callh = vpi_handle(vpiSysTfCall, 0);
+#ifdef HAVE_SHM_OPEN
+      vpiHandle argv = vpi_iterate(vpiArgument, callh);
+      vpiHandle arg;
+      struct cosim_info*info;
+      struct t_cb_data cb;
+      s_vpi_value val;
+      struct t_vpi_vlog_info vlog_info;
+      uint32_t*width;
+      unsigned nsignals = 0, maxwords = 1;
+      int replace = 0;
+      unsigned idx;
+
+      info = (struct cosim_info*)calloc(1, sizeof(struct cosim_info));
+
+      val.format = vpiStringVal;
+      vpi_get_value(vpi_scan(argv), &val);
+      info->name = strdup(val.value.str);
+
+      while ((arg = vpi_scan(argv))) {
+	    info->handles = (vpiHandle*)realloc(info->handles,
+	                                       (nsignals+1)*sizeof(vpiHandle));
+	    info->handles[nsignals++] = arg;
+      }
+
+      info->nsignals = nsignals;
+      info->signals = (struct cosim_signal*)
+	    calloc(nsignals? nsignals : 1, sizeof(struct cosim_signal));
+      info->changed = (unsigned*)calloc(nsignals? nsignals : 1, sizeof(unsigned));
+      width = (uint32_t*)calloc(nsignals? nsignals : 1, sizeof(uint32_t));
+      for (idx = 0 ; idx < nsignals ; idx += 1) {
+	    unsigned nwords;
+	    width[idx] = vpi_get(vpiSize, info->handles[idx]);
+	    nwords = (width[idx] + 31) / 32;
+	    if (nwords > maxwords) maxwords = nwords;
+      }
+      info->words = (uint32_t*)malloc(2*maxwords*sizeof(uint32_t));
+      info->vecval = (s_vpi_vecval*)malloc(maxwords*sizeof(s_vpi_vecval));
+
+	/* An existing object of the same name is only removed when
+	   asked for, since another simulation may be using it. */
+      vpi_get_vlog_info(&vlog_info);
+      for (idx = 0 ; idx < (unsigned)vlog_info.argc ; idx += 1) {
+	    if (strcmp(vlog_info.argv[idx], "+cosim_shm_replace") == 0)
+		  replace = 1;
+      }
+
+      if (cosim_shm_create(&info->chan, info->name, nsignals, width,
+                           replace) < 0) {
+	    int err = errno;
+	    vpi_printf("ERROR: %s:%d: ", vpi_get_str(vpiFile, callh),
+	               (int)vpi_get(vpiLineNo, callh));
+	    if (err == EEXIST)
+		  vpi_printf("%s shared memory \"%s\" already exists. "
+		             "Use +cosim_shm_replace to remove it.\n",
+		             name, info->name);
+	    else
+		  vpi_printf("%s could not create shared memory \"%s\": "
+		             "%s.\n", name, info->name, strerror(err));
+	    vpi_control(vpiFinish, 1);
+	    free(width);
+	    free(info->name);
+	    free(info->handles);
+	    free(info->signals);
+	    free(info->changed);
+	    free(info->words);
+	    free(info->vecval);
+	    free(info);
+	    return 0;
+      }
+      free(width);
+
+	/* Watch the signals. The first sync sends all of them, so
+	   the model starts with the current values. */
+      for (idx = 0 ; idx < nsignals ; idx += 1) {
+	    struct cosim_signal*sig = info->signals + idx;
+	    sig->info = info;
+	    sig->index = idx;
+	    sig->changed = 1;
+	    info->changed[idx] = idx;
+
+	    cb.reason = cbValueChange;
+	    cb.cb_rtn = cosim_change_cb;
+	    cb.time = 0;
+	    cb.obj = info->handles[idx];
+	    cb.value = 0;
+	    cb.user_data = (char*)sig;
+	    vpi_free_object(vpi_register_cb(&cb));
+      }
+      info->nchanged = nsignals;
+
+      schedule_sync(info);
+
+      cb.reason = cbEndOfSimulation;
+      cb.cb_rtn = cosim_finish_cb;
+      cb.time = 0;
+      cb.obj = 0;
+      cb.value = 0;
+      cb.user_data = (char*)info;
+      vpi_free_object(vpi_register_cb(&cb));
+#else
+      vpi_printf("ERROR: %s:%d: ", vpi_get_str(vpiFile, callh),
+                 (int)vpi_get(vpiLineNo, callh));
+      vpi_printf("%s is not supported, since shared memory is not "
+                 "available.\n", name);
+      vpi_control(vpiFinish, 1);
+#endif
+      return 0;
+}
+
+void sys_cosim_register(void)
+{
+      s_vpi_systf_data tf_data;
+      vpiHandle res;
+
+      tf_data.type      = vpiSysTask;
+      tf_data.tfname    = "$cosim_shm";
+      tf_data.calltf    = sys_cosim_shm_calltf;
+      tf_data.compiletf = sys_cosim_shm_compiletf;
+      tf_data.sizetf    = 0;
+      tf_data.user_data = "$cosim_shm";
+      res = vpi_register_systf(&tf_data);
+      vpip_make_systf_system_defined(res);
+}
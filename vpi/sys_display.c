@@ -84,6 +84,32 @@ static void my_mcd_rawwrite(PLI_UINT32 mcd, const char*buf, size_t count)
 
 struct timeformat_info_s timeformat_info = { 0, 0, 0, 20 };
 
+/*
+ * A format string is parsed into a list of tokens. A token is either
+ * literal text, or a conversion with its flags.
+ */
+struct format_token {
+      const char*text;  /* The literal text, or 0 for a conversion. */
+      unsigned len;
+      int ljust, plus, ld_zero, width, prec;
+      char fmt;
+};
+
+/*
+ * The display cache holds the information about each argument that
+ * does not change from call to call: the type of the argument, the
+ * decimal width of numeric arguments, and the parsed format of
+ * string constants.
+ */
+struct display_item {
+      int type;
+      int const_type;
+      int dec_size;
+      char*fmt_str;
+      struct format_token*tokens;
+      unsigned ntokens;
+};
+
 struct strobe_cb_info {
       const char*name;
       char*filename;
@@ -93,6 +119,7 @@ struct strobe_cb_info {
       vpiHandle*items;
       unsigned nitems;
       unsigned fd_mcd;
+      struct display_item*cache;
 };
 
 /*
@@ -135,6 +162,18 @@ static int vpi_get_dec_size(vpiHandle item)
 	);
 }
 
+/*
+ * Make sure the result buffer has room for need characters. The
+ * buffer grows by doubling, so building a long line does not
+ * reallocate it for every fragment.
+ */
+static char *display_grow(char *buf, unsigned int *cap, unsigned int need)
+{
+      if (need <= *cap) return buf;
+      while (*cap < need) *cap = *cap < 64 ? 64 : 2 * *cap;
+      return realloc(buf, *cap*sizeof(char));
+}
+
 static void array_from_iterator(struct strobe_cb_info*info, vpiHandle argv)
 {
       if (argv) {
@@ -486,7 +525,10 @@ static unsigned int get_format_char(char **rtn, int ljust, int plus,
            * Icarus is 1 the string length will set the width of a real
            * displayed using %d. */
           if (width == -1) {
-            width = (ld_zero == 1) ? 0 : vpi_get_dec_size(info->items[*idx]);
+            if (ld_zero == 1) width = 0;
+            else if (info->cache && info->cache[*idx].dec_size >= 0)
+              width = info->cache[*idx].dec_size;
+            else width = vpi_get_dec_size(info->items[*idx]);
           }
 
           /* If the default buffer is too small make it big enough. */
@@ -880,58 +922,104 @@ static unsigned int get_format_char(char **rtn, int ljust, int plus,
   return size - 1;
 }
 
-/* We can't use the normal str functions on the return value since
- * %u and %z can insert NULL characters into the stream. */
-static unsigned int get_format(char **rtn, char *fmt,
-                               const struct strobe_cb_info *info, unsigned int *idx)
+/* Parse the format string into tokens. The literal text of the tokens
+ * points into the format string, so it must be kept as long as the
+ * tokens are used. */
+static unsigned parse_format(char *fmt, struct format_token **tokens)
 {
   char *cp = fmt;
-  unsigned int size;
+  unsigned ntokens = 0;
 
-  *rtn = strdup("");
-  size = 1;
+  *tokens = 0;
   while (*cp) {
     size_t cnt = strcspn(cp, "%");
+    struct format_token *tok;
+
+    *tokens = realloc(*tokens, (ntokens+1)*sizeof(struct format_token));
+    tok = *tokens + ntokens;
+    ntokens += 1;
 
     if (cnt > 0) {
-      *rtn = realloc(*rtn, (size+cnt)*sizeof(char));
-      memcpy(*rtn+size-1, cp, cnt);
-      size += cnt;
+      tok->text = cp;
+      tok->len = cnt;
       cp += cnt;
     } else {
-      int ljust = 0, plus = 0, ld_zero = 0, width = -1, prec = -1;
-      char *result;
+      tok->text = 0;
+      tok->len = 0;
+      tok->ljust = 0;
+      tok->plus = 0;
+      tok->ld_zero = 0;
+      tok->width = -1;
+      tok->prec = -1;
 
       cp += 1;
       while ((*cp == '-') || (*cp == '+')) {
-        if (*cp == '-') ljust = 1;
-        else plus = 1;
+        if (*cp == '-') tok->ljust = 1;
+        else tok->plus = 1;
         cp += 1;
       }
       if (*cp == '0') {
-        ld_zero = 1;
+        tok->ld_zero = 1;
         cp += 1;
       }
-      if (isdigit((int)*cp)) width = strtoul(cp, &cp, 10);
+      if (isdigit((int)*cp)) tok->width = strtoul(cp, &cp, 10);
       if (*cp == '.') {
         cp += 1;
-        prec = strtoul(cp, &cp, 10);
+        tok->prec = strtoul(cp, &cp, 10);
       }
-      cnt = get_format_char(&result, ljust, plus, ld_zero, width, prec, *cp,
-                            info, idx);
-      *rtn = realloc(*rtn, (size+cnt)*sizeof(char));
+      tok->fmt = *cp;
+      if (*cp) cp += 1;
+    }
+  }
+  return ntokens;
+}
+
+/* We can't use the normal str functions on the return value since
+ * %u and %z can insert NULL characters into the stream. */
+static unsigned int render_format(char **rtn, const struct format_token *tokens,
+                                  unsigned ntokens,
+                                  const struct strobe_cb_info *info,
+                                  unsigned int *idx)
+{
+  unsigned int size, cap = 0;
+  unsigned tdx;
+
+  *rtn = display_grow(0, &cap, 1);
+  size = 1;
+  for (tdx = 0 ; tdx < ntokens ; tdx += 1) {
+    const struct format_token *tok = tokens + tdx;
+
+    if (tok->text) {
+      *rtn = display_grow(*rtn, &cap, size+tok->len);
+      memcpy(*rtn+size-1, tok->text, tok->len);
+      size += tok->len;
+    } else {
+      char *result;
+      unsigned int cnt;
+      cnt = get_format_char(&result, tok->ljust, tok->plus, tok->ld_zero,
+                            tok->width, tok->prec, tok->fmt, info, idx);
+      *rtn = display_grow(*rtn, &cap, size+cnt);
       memcpy(*rtn+size-1, result, cnt);
       free(result);
       size += cnt;
-      if (*cp) cp += 1;
     }
   }
   *(*rtn+size-1) = '\0';
   return size - 1;
 }
 
+static unsigned int get_format(char **rtn, char *fmt,
+                               const struct strobe_cb_info *info, unsigned int *idx)
+{
+  struct format_token *tokens;
+  unsigned ntokens = parse_format(fmt, &tokens);
+  unsigned int size = render_format(rtn, tokens, ntokens, info, idx);
+  free(tokens);
+  return size;
+}
+
 static unsigned int get_numeric(char **rtn, const struct strobe_cb_info *info,
-                                vpiHandle item)
+                                vpiHandle item, int dec_size)
 {
   int size, min;
   s_vpi_value val;
@@ -941,7 +1029,7 @@ static unsigned int get_numeric(char **rtn, const struct strobe_cb_info *info,
 
   switch(info->default_format){
     case vpiDecStrVal:
-      size = vpi_get_dec_size(item);
+      size = dec_size >= 0 ? dec_size : vpi_get_dec_size(item);
 	/* -1 can be represented as a one bit signed value. This returns
 	 * a size of 1 which is too small for the -1 string value so make
 	 * the string width the minimum display width. */
@@ -964,25 +1052,35 @@ static char *get_display(unsigned int *rtnsz, const struct strobe_cb_info *info)
   char *result, *fmt, *rtn, *func_name;
   const char *cresult;
   s_vpi_value value;
-  unsigned int idx, size, width;
+  unsigned int idx, size, width, cap = 0;
   char buf[256];
+  const struct display_item *cache;
+  int type, const_type;
 
-  rtn = strdup("");
+  rtn = display_grow(0, &cap, 1);
   size = 1;
   for  (idx = 0; idx < info->nitems; idx += 1) {
     vpiHandle item = info->items[idx];
 
-    switch (vpi_get(vpiType, item)) {
+    /* The cache, if there is one, already knows the type of the item. */
+    cache = info->cache ? info->cache + idx : 0;
+    type = cache ? cache->type : vpi_get(vpiType, item);
+
+    switch (type) {
 
       case vpiConstant:
       case vpiParameter:
-        if (vpi_get(vpiConstType, item) == vpiStringConst) {
+        const_type = cache ? cache->const_type : vpi_get(vpiConstType, item);
+        if (const_type == vpiStringConst && cache) {
+          width = render_format(&result, cache->tokens, cache->ntokens,
+                                info, &idx);
+        } else if (const_type == vpiStringConst) {
           value.format = vpiStringVal;
           vpi_get_value(item, &value);
           fmt = strdup(value.value.str);
           width = get_format(&result, fmt, info, &idx);
           free(fmt);
-        } else if (vpi_get(vpiConstType, item) == vpiRealConst) {
+        } else if (const_type == vpiRealConst) {
           value.format = vpiRealVal;
           vpi_get_value(item, &value);
 #if !defined(__GNUC__)
@@ -1000,9 +1098,9 @@ static char *get_display(unsigned int *rtnsz, const struct strobe_cb_info *info)
           result = strdup(buf);
           width = strlen(result);
         } else {
-          width = get_numeric(&result, info, item);
+          width = get_numeric(&result, info, item, cache ? cache->dec_size : -1);
         }
-        rtn = realloc(rtn, (size+width)*sizeof(char));
+        rtn = display_grow(rtn, &cap, size+width);
         memcpy(rtn+size-1, result, width);
         free(result);
         break;
@@ -1017,8 +1115,8 @@ static char *get_display(unsigned int *rtnsz, const struct strobe_cb_info *info)
       case vpiIntegerVar:
       case vpiMemoryWord:
       case vpiPartSelect:
-        width = get_numeric(&result, info, item);
-        rtn = realloc(rtn, (size+width)*sizeof(char));
+        width = get_numeric(&result, info, item, cache ? cache->dec_size : -1);
+        rtn = display_grow(rtn, &cap, size+width);
         memcpy(rtn+size-1, result, width);
         free(result);
         break;
@@ -1033,7 +1131,7 @@ static char *get_display(unsigned int *rtnsz, const struct strobe_cb_info *info)
                  vpi_get(vpiTimeUnit, info->scope));
         width = strlen(buf);
         if (width  < timeformat_info.width) width = timeformat_info.width;
-        rtn = realloc(rtn, (size+width)*sizeof(char));
+        rtn = display_grow(rtn, &cap, size+width);
         sprintf(rtn+size-1, "%*s", width, buf);
         break;
 
@@ -1054,7 +1152,7 @@ static char *get_display(unsigned int *rtnsz, const struct strobe_cb_info *info)
         sprintf(buf, compatible_flag ? "%g" : "%#g", value.value.real);
 #endif
         width = strlen(buf);
-        rtn = realloc(rtn, (size+width)*sizeof(char));
+        rtn = display_grow(rtn, &cap, size+width);
         memcpy(rtn+size-1, buf, width);
         break;
 
@@ -1066,7 +1164,7 @@ static char *get_display(unsigned int *rtnsz, const struct strobe_cb_info *info)
 	fmt = strdup(value.value.str);
 	width = get_format(&result, fmt, info, &idx);
 	free(fmt);
-        rtn = realloc(rtn, (size+width)*sizeof(char));
+        rtn = display_grow(rtn, &cap, size+width);
         memcpy(rtn+size-1, result, width);
         free(result);
 	break;
@@ -1078,7 +1176,7 @@ static char *get_display(unsigned int *rtnsz, const struct strobe_cb_info *info)
           vpi_get_value(item, &value);
           width = strlen(value.value.str);
           if (width  < 20) width = 20;
-          rtn = realloc(rtn, (size+width)*sizeof(char));
+          rtn = display_grow(rtn, &cap, size+width);
           sprintf(rtn+size-1, "%*s", width, value.value.str);
 
         } else if (strcmp(func_name, "$stime") == 0) {
@@ -1086,7 +1184,7 @@ static char *get_display(unsigned int *rtnsz, const struct strobe_cb_info *info)
           vpi_get_value(item, &value);
           width = strlen(value.value.str);
           if (width  < 10) width = 10;
-          rtn = realloc(rtn, (size+width)*sizeof(char));
+          rtn = display_grow(rtn, &cap, size+width);
           sprintf(rtn+size-1, "%*s", width, value.value.str);
 
         } else if (strcmp(func_name, "$simtime") == 0) {
@@ -1094,7 +1192,7 @@ static char *get_display(unsigned int *rtnsz, const struct strobe_cb_info *info)
           vpi_get_value(item, &value);
           width = strlen(value.value.str);
           if (width  < 20) width = 20;
-          rtn = realloc(rtn, (size+width)*sizeof(char));
+          rtn = display_grow(rtn, &cap, size+width);
           sprintf(rtn+size-1, "%*s", width, value.value.str);
 
         } else if (strcmp(func_name, "$realtime") == 0) {
@@ -1106,7 +1204,7 @@ static char *get_display(unsigned int *rtnsz, const struct strobe_cb_info *info)
           vpi_get_value(item, &value);
           sprintf(buf, "%.*f", use_prec, value.value.real);
           width = strlen(buf);
-          rtn = realloc(rtn, (size+width)*sizeof(char));
+          rtn = display_grow(rtn, &cap, size+width);
           sprintf(rtn+size-1, "%*s", width, buf);
 
         } else {
@@ -1114,7 +1212,7 @@ static char *get_display(unsigned int *rtnsz, const struct strobe_cb_info *info)
                      info->filename, info->lineno, info->name, func_name);
           strcpy(buf, "<?>");
           width = strlen(buf);
-          rtn = realloc(rtn, (size+width)*sizeof(char));
+          rtn = display_grow(rtn, &cap, size+width);
           memcpy(rtn+size-1, buf, width);
         }
         break;
@@ -1125,7 +1223,7 @@ static char *get_display(unsigned int *rtnsz, const struct strobe_cb_info *info)
                    info->name);
         cresult = "<?>";
         width = strlen(cresult);
-        rtn = realloc(rtn, (size+width)*sizeof(char));
+        rtn = display_grow(rtn, &cap, size+width);
         memcpy(rtn+size-1, cresult, width);
         break;
     }
@@ -1136,6 +1234,72 @@ static char *get_display(unsigned int *rtnsz, const struct strobe_cb_info *info)
   return rtn;
 }
 
+/*
+ * Build the display cache for the items of the info. This collects
+ * everything about the arguments that does not change from one call
+ * to the next, so that get_display does not need to ask for it again.
+ */
+static struct display_item *make_display_cache(const struct strobe_cb_info *info)
+{
+  struct display_item *cache;
+  s_vpi_value value;
+  unsigned int idx;
+
+  if (info->nitems == 0) return 0;
+
+  cache = calloc(info->nitems, sizeof(struct display_item));
+  for (idx = 0; idx < info->nitems; idx += 1) {
+    vpiHandle item = info->items[idx];
+
+    cache[idx].type = vpi_get(vpiType, item);
+    cache[idx].dec_size = -1;
+    switch (cache[idx].type) {
+      case vpiConstant:
+      case vpiParameter:
+        cache[idx].const_type = vpi_get(vpiConstType, item);
+        if (cache[idx].const_type == vpiStringConst) {
+          value.format = vpiStringVal;
+          vpi_get_value(item, &value);
+          cache[idx].fmt_str = strdup(value.value.str);
+          cache[idx].ntokens = parse_format(cache[idx].fmt_str,
+                                            &cache[idx].tokens);
+        } else if (cache[idx].const_type != vpiRealConst) {
+          cache[idx].dec_size = vpi_get_dec_size(item);
+        }
+        break;
+
+      case vpiNet:
+      case vpiReg:
+      case vpiBitVar:
+      case vpiByteVar:
+      case vpiShortIntVar:
+      case vpiIntVar:
+      case vpiLongIntVar:
+      case vpiIntegerVar:
+      case vpiMemoryWord:
+      case vpiPartSelect:
+        cache[idx].dec_size = vpi_get_dec_size(item);
+        break;
+
+      default:
+        break;
+    }
+  }
+  return cache;
+}
+
+static void free_display_cache(struct display_item *cache, unsigned int nitems)
+{
+  unsigned int idx;
+
+  if (cache == 0) return;
+  for (idx = 0; idx < nitems; idx += 1) {
+    free(cache[idx].fmt_str);
+    free(cache[idx].tokens);
+  }
+  free(cache);
+}
+
 #ifdef BR916_STOPGAP_FIX
 static char br916_hint_issued = 0;
 #endif
@@ -1269,42 +1433,87 @@ static PLI_INT32 sys_display_compiletf(ICARUS_VPI_CONST PLI_BYTE8*name)
       return sys_common_compiletf(name, 0, 0);
 }
 
+/*
+ * The $display and related tasks save what they learn about their
+ * arguments with the call, the first time they are called, so that
+ * the argument list is not scanned and the format strings are not
+ * parsed again each time the task is called.
+ */
+struct display_call_info {
+      vpiHandle fd;
+      struct strobe_cb_info info;
+};
+
+/* All the saved calls, so they can be freed at the end of simulation. */
+static struct display_call_info**display_calls = 0;
+static unsigned display_call_count = 0;
+
+static struct display_call_info *get_display_call(ICARUS_VPI_CONST PLI_BYTE8*name,
+                                                  vpiHandle callh)
+{
+      struct display_call_info*call;
+      vpiHandle argv, scope;
+
+      call = (struct display_call_info*)vpi_get_userdata(callh);
+      if (call) return call;
+
+      argv = vpi_iterate(vpiArgument, callh);
+      scope = vpi_handle(vpiScope, callh);
+      assert(scope);
+
+      call = calloc(1, sizeof(struct display_call_info));
+      if (name[1] == 'f') call->fd = vpi_scan(argv);
+	/* We could use vpi_get_str(vpiName, callh) to get the task name,
+	 * but name is already defined. */
+      call->info.name = name;
+      call->info.filename = strdup(vpi_get_str(vpiFile, callh));
+      call->info.lineno = (int)vpi_get(vpiLineNo, callh);
+      call->info.default_format = get_default_format(name);
+      call->info.scope = scope;
+	/* The fd/mcd has already been taken from the iterator, so this
+	 * also frees the iterator. */
+      array_from_iterator(&call->info, argv);
+      call->info.cache = make_display_cache(&call->info);
+
+      vpi_put_userdata(callh, call);
+      display_calls = realloc(display_calls, (display_call_count+1) *
+                              sizeof(struct display_call_info*));
+      display_calls[display_call_count] = call;
+      display_call_count += 1;
+      return call;
+}
+
 /* This implements the $sformatf, $display/$fdisplay
  * and the $write/$fwrite based tasks. */
 static PLI_INT32 sys_display_calltf(ICARUS_VPI_CONST PLI_BYTE8 *name)
 {
-      vpiHandle callh, argv, scope;
-      struct strobe_cb_info info;
+      vpiHandle callh;
+      struct display_call_info*call;
       char* result;
       unsigned int size;
       PLI_UINT32 fd_mcd;
       s_vpi_value val;
 
       callh = vpi_handle(vpiSysTfCall, 0);
-      argv = vpi_iterate(vpiArgument, callh);
+      call = get_display_call(name, callh);
 
 	/* Get the file/MC descriptor and verify it is valid. */
       if(name[1] == 'f') {
 	      errno = 0;
-	      vpiHandle arg = vpi_scan(argv);
 	      val.format = vpiIntVal;
-	      vpi_get_value(arg, &val);
+	      vpi_get_value(call->fd, &val);
 	      fd_mcd = val.value.integer;
 
 		/* If the MCD is zero we have nothing to do so just return. */
-	      if (fd_mcd == 0)  {
-		    vpi_free_object(argv);
-		    return 0;
-	      }
+	      if (fd_mcd == 0) return 0;
 
 	      if ((! IS_MCD(fd_mcd) && vpi_get_file(fd_mcd) == NULL) ||
 	          ( IS_MCD(fd_mcd) && my_mcd_printf(fd_mcd, "") == EOF)) {
-		    vpi_printf("WARNING: %s:%d: ", vpi_get_str(vpiFile, callh),
-		               (int)vpi_get(vpiLineNo, callh));
+		    vpi_printf("WARNING: %s:%d: ", call->info.filename,
+		               call->info.lineno);
 		    vpi_printf("invalid file descriptor/MCD (0x%x) given "
 		               "to %s.\n", (unsigned int)fd_mcd, name);
 		    errno = EBADF;
-		    vpi_free_object(argv);
 		    return 0;
 	      }
       } else if(strncmp(name,"$sformatf",9) == 0) {
@@ -1315,25 +1524,16 @@ static PLI_INT32 sys_display_calltf(ICARUS_VPI_CONST PLI_BYTE8 *name)
 	      fd_mcd = 1;
       }
 
-      scope = vpi_handle(vpiScope, callh);
-      assert(scope);
-	/* We could use vpi_get_str(vpiName, callh) to get the task name,
-	 * but name is already defined. */
-      info.name = name;
-      info.filename = strdup(vpi_get_str(vpiFile, callh));
-      info.lineno = (int)vpi_get(vpiLineNo, callh);
-      info.default_format = get_default_format(name);
-      info.scope = scope;
-      array_from_iterator(&info, argv);
-
 	/* Because %u and %z may put embedded NULL characters into the
 	 * returned string strlen() may not match the real size! */
-      result = get_display(&size, &info);
+      result = get_display(&size, &call->info);
 
       if(fd_mcd > 0) {
-	      my_mcd_rawwrite(fd_mcd, result, size);
+		/* The newline replaces the trailing NULL, so the whole
+		 * line is written at once. */
 	      if ((strncmp(name,"$display",8) == 0) ||
-	          (strncmp(name,"$fdisplay",9) == 0)) my_mcd_rawwrite(fd_mcd, "\n", 1);
+	          (strncmp(name,"$fdisplay",9) == 0)) result[size++] = '\n';
+	      my_mcd_rawwrite(fd_mcd, result, size);
       } else {
 	      /* Return as a string ($sformatf) */
 	      val.format = vpiStringVal;
@@ -1342,8 +1542,6 @@ static PLI_INT32 sys_display_calltf(ICARUS_VPI_CONST PLI_BYTE8 *name)
       }
 
       free(result);
-      free(info.filename);
-      free(info.items);
       return 0;
 }
 
@@ -1368,8 +1566,8 @@ static PLI_INT32 strobe_cb(p_cb_data cb)
 	      /* Because %u and %z may put embedded NULL characters into the
 	       * returned string strlen() may not match the real size! */
 	    result = get_display(&size, info);
+	    result[size++] = '\n';
 	    my_mcd_rawwrite(info->fd_mcd, result, size);
-	    my_mcd_rawwrite(info->fd_mcd, "\n", 1);
 	    free(result);
       }
 
@@ -1463,7 +1661,7 @@ static PLI_INT32 sys_strobe_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
  * though that monitor may be watching many variables).
  */
 
-static struct strobe_cb_info monitor_info = { 0, 0, 0, 0, 0, 0, 0, 0 };
+static struct strobe_cb_info monitor_info = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
 static vpiHandle *monitor_callbacks = 0;
 static int monitor_scheduled = 0;
 static int monitor_enabled = 1;
@@ -1478,8 +1676,8 @@ static PLI_INT32 monitor_cb_2(p_cb_data cb)
 	/* Because %u and %z may put embedded NULL characters into the
 	 * returned string strlen() may not match the real size! */
       result = get_display(&size, &monitor_info);
+      result[size++] = '\n';
       my_mcd_rawwrite(monitor_info.fd_mcd, result, size);
-      my_mcd_rawwrite(monitor_info.fd_mcd, "\n", 1);
       monitor_scheduled = 0;
       free(result);
       return 0;
@@ -1551,6 +1749,8 @@ static PLI_INT32 sys_monitor_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 	    monitor_callbacks = 0;
 
 	    free(monitor_info.filename);
+	    free_display_cache(monitor_info.cache, monitor_info.nitems);
+	    monitor_info.cache = 0;
 	    free(monitor_info.items);
 	    monitor_info.items = 0;
 	    monitor_info.nitems = 0;
@@ -1567,6 +1767,9 @@ static PLI_INT32 sys_monitor_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       monitor_info.default_format = get_default_format(name);
       monitor_info.scope = scope;
       monitor_info.fd_mcd = 1;
+	/* The monitor displays the same arguments over and over, so
+	   work out what does not change just once. */
+      monitor_info.cache = make_display_cache(&monitor_info);
 
 	/* Attach callbacks to all the parameters that might change. */
       monitor_callbacks = calloc(monitor_info.nitems, sizeof(vpiHandle));
@@ -1680,6 +1883,7 @@ static PLI_INT32 sys_swrite_calltf(ICARUS_VPI_CONST PLI_BYTE8 *name)
   info.lineno = (int)vpi_get(vpiLineNo, callh);
   info.default_format = get_default_format(name);
   info.scope = scope;
+  info.cache = 0;
   array_from_iterator(&info, argv);
 
   /* Because %u and %z may put embedded NULL characters into the returned
@@ -1773,6 +1977,7 @@ static PLI_INT32 sys_sformat_calltf(ICARUS_VPI_CONST PLI_BYTE8 *name)
   info.lineno = (int)vpi_get(vpiLineNo, callh);
   info.default_format = get_default_format(name);
   info.scope = scope;
+  info.cache = 0;
   array_from_iterator(&info, argv);
   idx = -1;
   size = get_format(&result, fmt, &info, &idx);
@@ -2130,6 +2335,7 @@ static PLI_INT32 sys_severity_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       info.lineno = (int)vpi_get(vpiLineNo, callh);
       info.default_format = vpiDecStrVal;
       info.scope = scope;
+      info.cache = 0;
       array_from_iterator(&info, argv);
 
       vpi_printf("%s: %s:%d: ", sstr, info.filename, info.lineno);
@@ -2168,15 +2374,30 @@ static PLI_INT32 sys_severity_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 
 static PLI_INT32 sys_end_of_simulation(p_cb_data cb_data)
 {
+      unsigned idx;
+
       (void)cb_data; /* Parameter is not used. */
       free(monitor_callbacks);
       monitor_callbacks = 0;
       free(monitor_info.filename);
+      free_display_cache(monitor_info.cache, monitor_info.nitems);
+      monitor_info.cache = 0;
       free(monitor_info.items);
       monitor_info.items = 0;
       monitor_info.nitems = 0;
       monitor_info.name = 0;
 
+      for (idx = 0 ;  idx < display_call_count ;  idx += 1) {
+	    struct strobe_cb_info*info = &display_calls[idx]->info;
+	    free(info->filename);
+	    free_display_cache(info->cache, info->nitems);
+	    free(info->items);
+	    free(display_calls[idx]);
+      }
+      free(display_calls);
+      display_calls = 0;
+      display_call_count = 0;
+
       free(timeformat_info.suff);
       timeformat_info.suff = 0;
       return 0;
@@ -45,6 +45,11 @@ struct vcd_info {
       struct vcd_info *dmp_next;
       fstHandle handle;
       int scheduled;
+	/* The type and width do not change, so get them once when the
+	   item is added. The bits buffer holds the formatted value. */
+      PLI_INT32 type;
+      unsigned size;
+      char *bits;
 };
 
 
@@ -55,6 +60,8 @@ static int dump_is_off = 0;
 static long dump_limit = 0;
 static int dump_is_full = 0;
 static int finish_status = 0;
+  /* Set when the time is outside the +dumpcfg time windows. */
+static int dump_is_outside = 0;
 
 
 static enum lxm_optimum_mode_e {
@@ -64,6 +71,10 @@ static enum lxm_optimum_mode_e {
       LXM_BOTH = 3
 } lxm_optimum_mode = LXM_NONE;
 
+/* The number of threads that compress the value change blocks. This
+   is set with the +fst+threads=N plusarg. */
+static int fst_threads = 1;
+
 static const char*units_names[] = {
       "s",
       "ms",
@@ -76,36 +87,34 @@ static const char*units_names[] = {
 static void show_this_item(struct vcd_info*info)
 {
       s_vpi_value value;
-      PLI_INT32 type = vpi_get(vpiType, info->item);
 
-      if (type == vpiRealVar) {
+      if (info->type == vpiRealVar) {
 	    value.format = vpiRealVal;
 	    vpi_get_value(info->item, &value);
 	    fstWriterEmitValueChange(dump_file, info->handle, &value.value.real);
+      } else if (info->type == vpiNamedEvent) {
+	    fstWriterEmitValueChange(dump_file, info->handle, "1");
       } else {
-	    value.format = vpiBinStrVal;
+	    value.format = vpiVectorVal;
 	    vpi_get_value(info->item, &value);
-	    fstWriterEmitValueChange(dump_file, info->handle, (type != vpiNamedEvent) ? value.value.str : "1");
+	    vcd_vecval_to_bits(info->bits, value.value.vector, info->size);
+	    fstWriterEmitValueChange(dump_file, info->handle, info->bits);
       }
 }
 
 /* Dump values for a $dumpoff. */
 static void show_this_item_x(struct vcd_info*info)
 {
-      PLI_INT32 type = vpi_get(vpiType, info->item);
-
-      if (type == vpiRealVar) {
+      if (info->type == vpiRealVar) {
 	      /* Some tools dump nothing here...? */
             double mynan = strtod("NaN", NULL);
 	    fstWriterEmitValueChange(dump_file, info->handle, &mynan);
-      } else if (type == vpiNamedEvent) {
+      } else if (info->type == vpiNamedEvent) {
 	    /* Do nothing for named events. */
       } else {
-	    int siz = vpi_get(vpiSize, info->item);
-	    char *xmem = malloc(siz);
-	    memset(xmem, 'x', siz);
-	    fstWriterEmitValueChange(dump_file, info->handle, xmem);
-	    free(xmem);
+	    memset(info->bits, 'x', info->size);
+	    info->bits[info->size] = 0;
+	    fstWriterEmitValueChange(dump_file, info->handle, info->bits);
       }
 }
 
@@ -119,6 +128,7 @@ struct vcd_names_list_s fst_var = { 0, 0, 0, 0 };
 
 
 static int dumpvars_status = 0; /* 0:fresh 1:cb installed, 2:callback done */
+static int dumpcfg_scopes_done = 0;
 static PLI_UINT64 dumpvars_time;
 __inline__ static int dump_header_pending(void)
 {
@@ -150,6 +160,9 @@ static PLI_INT32 variable_cb_2(p_cb_data cause)
       struct vcd_info* info = vcd_dmp_list;
       PLI_UINT64 now = timerec_to_time64(cause->time);
 
+	/* The list is dropped if a dump window closed. */
+      if (info == 0) return 0;
+
       if (now != vcd_cur_time) {
 	    fstWriterEmitTimeChange(dump_file, now);
 	    vcd_cur_time = now;
@@ -172,6 +185,7 @@ static PLI_INT32 variable_cb_1(p_cb_data cause)
 
       if (dump_is_full) return 0;
       if (dump_is_off) return 0;
+      if (dump_is_outside) return 0;
       if (dump_header_pending()) return 0;
       if (info->scheduled) return 0;
 
@@ -197,6 +211,117 @@ static PLI_INT32 variable_cb_1(p_cb_data cause)
       return 0;
 }
 
+static void register_variable_cb(struct vcd_info*info)
+{
+      struct t_cb_data cb;
+
+      cb.time      = &info->time;
+      cb.user_data = (char*)info;
+      cb.value     = NULL;
+      cb.obj       = info->item;
+      cb.reason    = cbValueChange;
+      cb.cb_rtn    = variable_cb_1;
+
+      info->cb = vpi_register_cb(&cb);
+}
+
+/*
+ * Outside the +dumpcfg time windows the value change callbacks are
+ * removed, so the signals cost nothing until the next window opens.
+ */
+static void dump_window_close(PLI_UINT64 now)
+{
+      struct vcd_info*cur;
+
+      dump_is_outside = 1;
+
+      for (cur = vcd_list ;  cur ;  cur = cur->next) {
+	    vpi_remove_cb(cur->cb);
+	    cur->cb = 0;
+      }
+      for (cur = vcd_dmp_list ;  cur ;  cur = cur->dmp_next)
+	    cur->scheduled = 0;
+      vcd_dmp_list = 0;
+
+      if (dump_is_off || dump_is_full || dump_header_pending()) return;
+
+      if (now > vcd_cur_time) {
+	    fstWriterEmitTimeChange(dump_file, now);
+	    vcd_cur_time = now;
+      }
+
+      fstWriterEmitDumpActive(dump_file, 0); /* $dumpoff */
+      vcd_checkpoint_x();
+}
+
+static void dump_window_open(PLI_UINT64 now)
+{
+      struct vcd_info*cur;
+
+      dump_is_outside = 0;
+
+      for (cur = vcd_list ;  cur ;  cur = cur->next)
+	    register_variable_cb(cur);
+
+      if (dump_is_off || dump_is_full) return;
+
+      if (now > vcd_cur_time) {
+	    fstWriterEmitTimeChange(dump_file, now);
+	    vcd_cur_time = now;
+      }
+
+      fstWriterEmitDumpActive(dump_file, 1); /* $dumpon */
+      vcd_checkpoint();
+}
+
+static PLI_INT32 dump_window_cb(p_cb_data cause);
+
+static void schedule_dump_window(PLI_UINT64 now)
+{
+      struct t_cb_data cb;
+      struct t_vpi_time delay;
+      PLI_UINT64 next;
+
+      (void) vcd_dumpcfg_window(now, &next);
+      if (next == 0) return;
+
+      next -= now;
+      delay.type = vpiSimTime;
+      delay.high = (PLI_UINT32)(next >> 32);
+      delay.low  = (PLI_UINT32)next;
+      delay.real = 0.0;
+
+      cb.reason = cbAfterDelay;
+      cb.cb_rtn = dump_window_cb;
+      cb.time = &delay;
+      cb.obj = 0;
+      cb.value = 0;
+      cb.user_data = 0;
+      vpi_free_object(vpi_register_cb(&cb));
+}
+
+static PLI_INT32 dump_window_cb(p_cb_data cause)
+{
+      s_vpi_time now;
+      PLI_UINT64 now64, next;
+      int inside;
+
+      (void)cause; /* Parameter is not used. */
+
+      if (finish_status != 0) return 0;
+
+      now.type = vpiSimTime;
+      vpi_get_time(0, &now);
+      now64 = timerec_to_time64(&now);
+
+      inside = vcd_dumpcfg_window(now64, &next);
+      if (inside && dump_is_outside) dump_window_open(now64);
+      else if (!inside && !dump_is_outside) dump_window_close(now64);
+
+      schedule_dump_window(now64);
+      return 0;
+}
+
 static PLI_INT32 dumpvars_cb(p_cb_data cause)
 {
       if (dumpvars_status != 1) return 0;
@@ -208,7 +333,14 @@ static PLI_INT32 dumpvars_cb(p_cb_data cause)
 
       /* nothing to do for $enddefinitions $end */
 
-      if (!dump_is_off) {
+      if (vcd_dumpcfg_has_windows()) {
+	    PLI_UINT64 next;
+	    if (!vcd_dumpcfg_window(dumpvars_time, &next))
+		  dump_window_close(dumpvars_time);
+	    schedule_dump_window(dumpvars_time);
+      }
+
+      if (!dump_is_off && !dump_is_outside) {
 	    fstWriterEmitTimeChange(dump_file, dumpvars_time);
 	    /* nothing to do for  $dumpvars... */
 	    vcd_checkpoint();
@@ -236,12 +368,14 @@ static PLI_INT32 finish_cb(p_cb_data cause)
 
       for (cur = vcd_list ;  cur ;  cur = next) {
 	    next = cur->next;
+	    free(cur->bits);
 	    free(cur);
       }
       vcd_list = 0;
       vcd_names_delete(&fst_tab);
       vcd_names_delete(&fst_var);
       nexus_ident_delete();
+      vcd_dumpcfg_free();
       free(dump_path);
       dump_path = 0;
 
@@ -291,6 +425,7 @@ static PLI_INT32 sys_dumpoff_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 
       if (dump_file == 0) return 0;
       if (dump_header_pending()) return 0;
+      if (dump_is_outside) return 0;
 
       now.type = vpiSimTime;
       vpi_get_time(0, &now);
@@ -320,6 +455,7 @@ static PLI_INT32 sys_dumpon_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 
       if (dump_file == 0) return 0;
       if (dump_header_pending()) return 0;
+      if (dump_is_outside) return 0;
 
       now.type = vpiSimTime;
       vpi_get_time(0, &now);
@@ -346,6 +482,7 @@ static PLI_INT32 sys_dumpall_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       if (dump_is_off) return 0;
       if (dump_file == 0) return 0;
       if (dump_header_pending()) return 0;
+      if (dump_is_outside) return 0;
 
       now.type = vpiSimTime;
       vpi_get_time(0, &now);
@@ -412,6 +549,7 @@ static void open_dumpfile(vpiHandle callh)
 	        (lxm_optimum_mode == LXM_BOTH)) {
 		  fstWriterSetRepackOnClose(dump_file, 1);
 	    }
+	    fstWriterSetCompressThreads(dump_file, fst_threads);
       }
 }
 
@@ -478,7 +616,6 @@ static PLI_INT32 sys_dumplimit_calltf(ICARUS_VPI_CONST PLI_BYTE8 *name)
 
 static void scan_item(unsigned depth, vpiHandle item, int skip)
 {
-      struct t_cb_data cb;
       struct vcd_info* info;
 
       enum fstVarType type = FST_VT_MAX;
@@ -589,6 +726,9 @@ static void scan_item(unsigned depth, vpiHandle item, int skip)
 	       * scope then just return. */
             if (skip || vpi_get(vpiAutomatic, item)) return;
 
+	      /* Skip signals that the dump control file leaves out. */
+	    if (!vcd_dumpcfg_signal(fullname)) return;
+
 	      /* Skip this signal if it has already been included.
 	       * This can only happen for implicitly given signals. */
 	    if (vcd_names_search(&fst_var, fullname)) return;
@@ -644,19 +784,17 @@ static void scan_item(unsigned depth, vpiHandle item, int skip)
 		  info->item  = item;
 		  info->handle = new_ident;
 		  info->scheduled = 0;
-
-		  cb.time      = &info->time;
-		  cb.user_data = (char*)info;
-		  cb.value     = NULL;
-		  cb.obj       = item;
-		  cb.reason    = cbValueChange;
-		  cb.cb_rtn    = variable_cb_1;
+		  info->type  = vpi_get(vpiType, item);
+		  info->size  = vpi_get(vpiSize, item);
+		  info->bits  = 0;
+		  if (info->type != vpiRealVar && info->type != vpiNamedEvent)
+			info->bits = malloc(info->size + 1);
 
 		  info->dmp_next = 0;
 		  info->next  = vcd_list;
 		  vcd_list    = info;
 
-		  info->cb    = vpi_register_cb(&cb);
+		  register_variable_cb(info);
 	    }
 
 	    break;
@@ -791,6 +929,68 @@ static int draw_scope(vpiHandle item, vpiHandle callh)
       return depth;
 }
 
+static void dumpvars_item(unsigned depth, vpiHandle item, vpiHandle callh)
+{
+      char *scname;
+      const char *fullname;
+      int add_var = 0;
+      int dep;
+      PLI_INT32 item_type = vpi_get(vpiType, item);
+
+	/* If this is a signal make sure it has not already
+	 * been included. */
+      switch (item_type) {
+	  case vpiIntegerVar:
+	  case vpiBitVar:
+	  case vpiByteVar:
+	  case vpiShortIntVar:
+	  case vpiIntVar:
+	  case vpiLongIntVar:
+	  case vpiMemoryWord:
+	  case vpiNamedEvent:
+	  case vpiNet:
+	  case vpiParameter:
+	  case vpiRealVar:
+	  case vpiReg:
+	  case vpiTimeVar:
+	      /* Warn if the variables scope (which includes the
+	       * variable) or the variable itself was already
+	       * included. A scope does not automatically include
+	       * memory words so do not check the scope for them.  */
+	    scname = strdup(vpi_get_str(vpiFullName,
+					vpi_handle(vpiScope, item)));
+	    fullname = vpi_get_str(vpiFullName, item);
+	    if (((item_type != vpiMemoryWord) &&
+		 vcd_names_search(&fst_tab, scname)) ||
+		vcd_names_search(&fst_var, fullname)) {
+		  vpi_printf("FST warning: skipping signal %s, "
+			     "it was previously included.\n",
+			     fullname);
+		  free(scname);
+		  return;
+	    } else {
+		  add_var = 1;
+	    }
+	    free(scname);
+      }
+
+      dep = draw_scope(item, callh);
+
+      scan_item(depth, item, 0);
+	/* The scope list must be sorted after we scan an item.  */
+      vcd_names_sort(&fst_tab);
+
+      while (dep--) fstWriterSetUpscope(dump_file);
+
+	/* Add this signal to the variable list so we can verify it
+	 * is not included twice. This must be done after it has
+	 * been added */
+      if (add_var) {
+	    vcd_names_add(&fst_var, vpi_get_str(vpiFullName, item));
+	    vcd_names_sort(&fst_var);
+      }
+}
+
 static PLI_INT32 sys_dumpvars_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 {
       vpiHandle callh = vpi_handle(vpiSysTfCall, 0);
@@ -814,6 +1014,27 @@ static PLI_INT32 sys_dumpvars_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 	    return 0;
       }
 
+	/* The scopes in a dump control file replace the arguments.
+	   They are added by the first $dumpvars call, and the later
+	   calls in the same time step add nothing. */
+      if (vcd_dumpcfg_scope_count() > 0) {
+	    unsigned idx;
+	    if (argv) vpi_free_object(argv);
+	    if (dumpcfg_scopes_done) return 0;
+	    dumpcfg_scopes_done = 1;
+	    for (idx = 0 ;  idx < vcd_dumpcfg_scope_count() ;  idx += 1) {
+		  const char*scname = vcd_dumpcfg_scope(idx, &depth);
+		  item = vpi_handle_by_name(scname, 0);
+		  if (item == 0) {
+			vpi_printf("FST warning: dump control scope %s "
+			           "not found.\n", scname);
+			continue;
+		  }
+		  dumpvars_item(depth ? depth : 10000, item, callh);
+	    }
+	    return 0;
+      }
+
         /* Get the depth if it exists. */
       if (argv) {
 	    value.format = vpiIntVal;
@@ -829,66 +1050,8 @@ static PLI_INT32 sys_dumpvars_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 	    item = vpi_scan(argv);
       }
 
-      for ( ; item; item = vpi_scan(argv)) {
-	    char *scname;
-	    const char *fullname;
-	    int add_var = 0;
-	    int dep;
-	    PLI_INT32 item_type = vpi_get(vpiType, item);
-
-	      /* If this is a signal make sure it has not already
-	       * been included. */
-	    switch (item_type) {
-	        case vpiIntegerVar:
-		case vpiBitVar:
-		case vpiByteVar:
-		case vpiShortIntVar:
-		case vpiIntVar:
-		case vpiLongIntVar:
-	        case vpiMemoryWord:
-	        case vpiNamedEvent:
-	        case vpiNet:
-	        case vpiParameter:
-	        case vpiRealVar:
-	        case vpiReg:
-	        case vpiTimeVar:
-		    /* Warn if the variables scope (which includes the
-		     * variable) or the variable itself was already
-		     * included. A scope does not automatically include
-		     * memory words so do not check the scope for them.  */
-		  scname = strdup(vpi_get_str(vpiFullName,
-		                              vpi_handle(vpiScope, item)));
-		  fullname = vpi_get_str(vpiFullName, item);
-		  if (((item_type != vpiMemoryWord) &&
-		       vcd_names_search(&fst_tab, scname)) ||
-		      vcd_names_search(&fst_var, fullname)) {
-		        vpi_printf("FST warning: skipping signal %s, "
-		                   "it was previously included.\n",
-		                   fullname);
-		        free(scname);
-		        continue;
-		  } else {
-		        add_var = 1;
-		  }
-		  free(scname);
-	    }
-
-	    dep = draw_scope(item, callh);
-
-	    scan_item(depth, item, 0);
-	      /* The scope list must be sorted after we scan an item.  */
-	    vcd_names_sort(&fst_tab);
-
-	    while (dep--) fstWriterSetUpscope(dump_file);
-
-	      /* Add this signal to the variable list so we can verify it
-	       * is not included twice. This must be done after it has
-	       * been added */
-	    if (add_var) {
-		  vcd_names_add(&fst_var, vpi_get_str(vpiFullName, item));
-		  vcd_names_sort(&fst_var);
-	    }
-      }
+      for ( ; item; item = vpi_scan(argv))
+	    dumpvars_item(depth, item, callh);
 
       return 0;
 }
@@ -915,9 +1078,20 @@ void sys_fst_register(void)
 		  lxm_optimum_mode = LXM_BOTH;
 	    } else if (strcmp(vlog_info.argv[idx],"-fst-speed-space") == 0) {
 		  lxm_optimum_mode = LXM_BOTH;
+
+	    } else if (strncmp(vlog_info.argv[idx],"+fst+threads=",13) == 0) {
+		  fst_threads = atoi(vlog_info.argv[idx]+13);
+		  if (fst_threads < 1) {
+			vpi_printf("FST warning: ignoring %s, the thread "
+			           "count must be at least 1.\n",
+			           vlog_info.argv[idx]);
+			fst_threads = 1;
+		  }
 	    }
       }
 
+      vcd_dumpcfg_load("FST");
+
       /* All the compiletf routines are located in vcd_priv.c. */
 
       tf_data.type      = vpiSysTask;
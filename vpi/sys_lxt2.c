@@ -858,6 +858,10 @@ static void* lxt2_thread(void*arg)
 
 	    switch (cell->type) {
 		case WT_NONE:
+		case WT_EMIT_VCD_VECTOR:
+		case WT_EMIT_VCD_WIDE:
+		case WT_EMIT_VCD_REAL:
+		case WT_EMIT_VCD_EVENT:
 		  break;
 		case WT_FLUSH:
 		  lxt2_wr_flush(dump_file);
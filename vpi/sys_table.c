@@ -24,6 +24,7 @@
 # include <string.h>
 
 extern void sys_convert_register(void);
+extern void sys_cosim_register(void);
 extern void sys_countdrivers_register(void);
 extern void sys_darray_register(void);
 extern void sys_fileio_register(void);
@@ -140,6 +141,9 @@ static void sys_lxt_or_vcd_register(void)
 	    } else if (strcmp(vlog_info.argv[idx],"-vcd") == 0) {
 		  dumper = "vcd";
 
+	    } else if (strcmp(vlog_info.argv[idx],"-vcd-async") == 0) {
+		  dumper = "vcd";
+
 	    } else if (strcmp(vlog_info.argv[idx],"-vcd-off") == 0) {
 		  dumper = "none";
 
@@ -197,6 +201,7 @@ static void sys_lxt_or_vcd_register(void)
 
 void (*vlog_startup_routines[])(void) = {
       sys_convert_register,
+      sys_cosim_register,
       sys_countdrivers_register,
       sys_darray_register,
       sys_fileio_register,
@@ -44,6 +44,11 @@ struct vcd_info {
       struct vcd_info *next;
       struct vcd_info *dmp_next;
       int scheduled;
+	/* The type and width do not change, so get them once when the
+	   item is added. The bits buffer holds the formatted value. */
+      PLI_INT32 type;
+      unsigned size;
+      char *bits;
 };
 
 
@@ -54,6 +59,23 @@ static int dump_is_off = 0;
 static long dump_limit = 0;
 static int dump_is_full = 0;
 static int finish_status = 0;
+  /* Set when the time is outside the +dumpcfg time windows. */
+static int dump_is_outside = 0;
+
+/*
+ * With the -vcd-async extended argument the value changes are sent to
+ * a work thread that formats them and writes the file. The simulation
+ * thread only queues the raw values. Everything else is written by
+ * the simulation thread after it waits for the work thread to catch
+ * up, so the work thread and the simulation thread never write the
+ * file (or use vcd_cur_time) at the same time.
+ */
+static int vcd_async = 0;
+
+static void vcd_sync(void)
+{
+      if (vcd_async) vcd_work_sync();
+}
 
 
 static const char*units_names[] = {
@@ -101,40 +123,116 @@ static char *truncate_bitvec(char *s)
       }
 }
 
+static void write_vector(struct vcd_info*info, const s_vpi_vecval*vec)
+{
+      vcd_vecval_to_bits(info->bits, vec, info->size);
+      if (info->size == 1) {
+	    fprintf(dump_file, "%s%s\n", info->bits, info->ident);
+      } else {
+	    fprintf(dump_file, "b%s %s\n", truncate_bitvec(info->bits),
+		    info->ident);
+      }
+}
+
 static void show_this_item(struct vcd_info*info)
 {
       s_vpi_value value;
-      PLI_INT32 type = vpi_get(vpiType, info->item);
 
-      if (type == vpiRealVar) {
+      if (info->type == vpiRealVar) {
 	    value.format = vpiRealVal;
 	    vpi_get_value(info->item, &value);
 	    fprintf(dump_file, "r%.16g %s\n", value.value.real, info->ident);
-      } else if (type == vpiNamedEvent) {
+      } else if (info->type == vpiNamedEvent) {
 	    fprintf(dump_file, "1%s\n", info->ident);
-      } else if (vpi_get(vpiSize, info->item) == 1) {
-	    value.format = vpiBinStrVal;
+      } else {
+	    value.format = vpiVectorVal;
+	    vpi_get_value(info->item, &value);
+	    write_vector(info, value.value.vector);
+      }
+}
+
+/* Queue the value for the work thread instead of writing it. */
+static void queue_this_item(struct vcd_info*info)
+{
+      s_vpi_value value;
+
+      if (info->type == vpiRealVar) {
+	    value.format = vpiRealVal;
 	    vpi_get_value(info->item, &value);
-	    fprintf(dump_file, "%s%s\n", value.value.str, info->ident);
+	    vcd_work_emit_vcd_real(info, value.value.real);
+      } else if (info->type == vpiNamedEvent) {
+	    vcd_work_emit_vcd_event(info);
       } else {
-	    value.format = vpiBinStrVal;
+	    value.format = vpiVectorVal;
 	    vpi_get_value(info->item, &value);
-	    fprintf(dump_file, "b%s %s\n", truncate_bitvec(value.value.str),
-		    info->ident);
+	    vcd_work_emit_vcd_vector(info, value.value.vector, info->size);
+      }
+}
+
+static void* vcd_thread(void*arg)
+{
+      int run_flag = 1;
+
+      (void)arg; /* Parameter is not used. */
+
+      while (run_flag) {
+	    struct vcd_work_item_s*cell = vcd_work_thread_peek();
+	    struct vcd_info*info = cell->sym_.vcd;
+
+	    switch (cell->type) {
+		case WT_EMIT_VCD_VECTOR:
+		case WT_EMIT_VCD_WIDE:
+		case WT_EMIT_VCD_REAL:
+		case WT_EMIT_VCD_EVENT:
+		  if (cell->time != vcd_cur_time) {
+			fprintf(dump_file, "#%" PLI_UINT64_FMT "\n",
+			        (PLI_UINT64)cell->time);
+			vcd_cur_time = cell->time;
+		  }
+		  break;
+		default:
+		  break;
+	    }
+
+	    switch (cell->type) {
+		case WT_EMIT_VCD_VECTOR:
+		  write_vector(info, &cell->op_.val_vec);
+		  break;
+		case WT_EMIT_VCD_WIDE:
+		  write_vector(info, cell->op_.val_wide.words);
+		  break;
+		case WT_EMIT_VCD_REAL:
+		  fprintf(dump_file, "r%.16g %s\n", cell->op_.val_double,
+			  info->ident);
+		  break;
+		case WT_EMIT_VCD_EVENT:
+		  fprintf(dump_file, "1%s\n", info->ident);
+		  break;
+		case WT_FLUSH:
+		  fflush(dump_file);
+		  break;
+		case WT_TERMINATE:
+		  run_flag = 0;
+		  break;
+		default:
+		  break;
+	    }
+
+	    vcd_work_thread_pop();
       }
+
+      return 0;
 }
 
 /* Dump values for a $dumpoff. */
 static void show_this_item_x(struct vcd_info*info)
 {
-      PLI_INT32 type = vpi_get(vpiType, info->item);
-
-      if (type == vpiRealVar) {
+      if (info->type == vpiRealVar) {
 	      /* Some tools dump nothing here...? */
 	    fprintf(dump_file, "rNaN %s\n", info->ident);
-      } else if (type == vpiNamedEvent) {
+      } else if (info->type == vpiNamedEvent) {
 	    /* Do nothing for named events. */
-      } else if (vpi_get(vpiSize, info->item) == 1) {
+      } else if (info->size == 1) {
 	    fprintf(dump_file, "x%s\n", info->ident);
       } else {
 	    fprintf(dump_file, "bx %s\n", info->ident);
@@ -151,6 +249,7 @@ struct vcd_names_list_s vcd_var = { 0, 0, 0, 0 };
 
 
 static int dumpvars_status = 0; /* 0:fresh 1:cb installed, 2:callback done */
+static int dumpcfg_scopes_done = 0;
 static PLI_UINT64 dumpvars_time;
 __inline__ static int dump_header_pending(void)
 {
@@ -182,6 +281,20 @@ static PLI_INT32 variable_cb_2(p_cb_data cause)
       struct vcd_info* info = vcd_dmp_list;
       PLI_UINT64 now = timerec_to_time64(cause->time);
 
+	/* The list is dropped if a dump window closed. */
+      if (info == 0) return 0;
+
+      if (vcd_async) {
+	    vcd_work_set_time(now);
+	    do {
+		  queue_this_item(info);
+		  info->scheduled = 0;
+	    } while ((info = info->dmp_next) != 0);
+
+	    vcd_dmp_list = 0;
+	    return 0;
+      }
+
       if (now != vcd_cur_time) {
 	    fprintf(dump_file, "#%" PLI_UINT64_FMT "\n", now);
 	    vcd_cur_time = now;
@@ -204,6 +317,7 @@ static PLI_INT32 variable_cb_1(p_cb_data cause)
 
       if (dump_is_full) return 0;
       if (dump_is_off) return 0;
+      if (dump_is_outside) return 0;
       if (dump_header_pending()) return 0;
       if (info->scheduled) return 0;
 
@@ -211,6 +325,7 @@ static PLI_INT32 variable_cb_1(p_cb_data cause)
             dump_is_full = 1;
             vpi_printf("WARNING: Dump file limit (%ld bytes) "
                                "exceeded.\n", dump_limit);
+            vcd_sync();
             fprintf(dump_file, "$comment Dump file limit (%ld bytes) "
                                "exceeded. $end\n", dump_limit);
             return 0;
@@ -231,6 +346,121 @@ static PLI_INT32 variable_cb_1(p_cb_data cause)
       return 0;
 }
 
+static void register_variable_cb(struct vcd_info*info)
+{
+      struct t_cb_data cb;
+
+      cb.time      = &info->time;
+      cb.user_data = (char*)info;
+      cb.value     = NULL;
+      cb.obj       = info->item;
+      cb.reason    = cbValueChange;
+      cb.cb_rtn    = variable_cb_1;
+
+      info->cb = vpi_register_cb(&cb);
+}
+
+/*
+ * Outside the +dumpcfg time windows the value change callbacks are
+ * removed, so the signals cost nothing until the next window opens.
+ */
+static void dump_window_close(PLI_UINT64 now)
+{
+      struct vcd_info*cur;
+
+      dump_is_outside = 1;
+
+      for (cur = vcd_list ;  cur ;  cur = cur->next) {
+	    vpi_remove_cb(cur->cb);
+	    cur->cb = 0;
+      }
+      for (cur = vcd_dmp_list ;  cur ;  cur = cur->dmp_next)
+	    cur->scheduled = 0;
+      vcd_dmp_list = 0;
+
+      if (dump_is_off || dump_is_full || dump_header_pending()) return;
+
+      vcd_sync();
+      if (now > vcd_cur_time) {
+	    fprintf(dump_file, "#%" PLI_UINT64_FMT "\n", now);
+	    vcd_cur_time = now;
+      }
+
+      fprintf(dump_file, "$dumpoff\n");
+      vcd_checkpoint_x();
+      fprintf(dump_file, "$end\n");
+}
+
+static void dump_window_open(PLI_UINT64 now)
+{
+      struct vcd_info*cur;
+
+      dump_is_outside = 0;
+
+      for (cur = vcd_list ;  cur ;  cur = cur->next)
+	    register_variable_cb(cur);
+
+      if (dump_is_off || dump_is_full) return;
+
+      vcd_sync();
+      if (now > vcd_cur_time) {
+	    fprintf(dump_file, "#%" PLI_UINT64_FMT "\n", now);
+	    vcd_cur_time = now;
+      }
+
+      fprintf(dump_file, "$dumpon\n");
+      vcd_checkpoint();
+      fprintf(dump_file, "$end\n");
+}
+
+static PLI_INT32 dump_window_cb(p_cb_data cause);
+
+static void schedule_dump_window(PLI_UINT64 now)
+{
+      struct t_cb_data cb;
+      struct t_vpi_time delay;
+      PLI_UINT64 next;
+
+      (void) vcd_dumpcfg_window(now, &next);
+      if (next == 0) return;
+
+      next -= now;
+      delay.type = vpiSimTime;
+      delay.high = (PLI_UINT32)(next >> 32);
+      delay.low  = (PLI_UINT32)next;
+      delay.real = 0.0;
+
+      cb.reason = cbAfterDelay;
+      cb.cb_rtn = dump_window_cb;
+      cb.time = &delay;
+      cb.obj = 0;
+      cb.value = 0;
+      cb.user_data = 0;
+      vpi_free_object(vpi_register_cb(&cb));
+}
+
+static PLI_INT32 dump_window_cb(p_cb_data cause)
+{
+      s_vpi_time now;
+      PLI_UINT64 now64, next;
+      int inside;
+
+      (void)cause; /* Parameter is not used. */
+
+      if (finish_status != 0) return 0;
+
+      now.type = vpiSimTime;
+      vpi_get_time(0, &now);
+      now64 = timerec_to_time64(&now);
+
+      inside = vcd_dumpcfg_window(now64, &next);
+      if (inside && dump_is_outside) dump_window_open(now64);
+      else if (!inside && !dump_is_outside) dump_window_close(now64);
+
+      schedule_dump_window(now64);
+      return 0;
+}
+
 static PLI_INT32 dumpvars_cb(p_cb_data cause)
 {
       if (dumpvars_status != 1) return 0;
@@ -242,7 +472,14 @@ static PLI_INT32 dumpvars_cb(p_cb_data cause)
 
       fprintf(dump_file, "$enddefinitions $end\n");
 
-      if (!dump_is_off) {
+      if (vcd_dumpcfg_has_windows()) {
+	    PLI_UINT64 next;
+	    if (!vcd_dumpcfg_window(dumpvars_time, &next))
+		  dump_window_close(dumpvars_time);
+	    schedule_dump_window(dumpvars_time);
+      }
+
+      if (!dump_is_off && !dump_is_outside) {
 	    fprintf(dump_file, "#%" PLI_UINT64_FMT "\n", dumpvars_time);
 	    fprintf(dump_file, "$dumpvars\n");
 	    vcd_checkpoint();
@@ -262,6 +499,8 @@ static PLI_INT32 finish_cb(p_cb_data cause)
 
       dumpvars_time = timerec_to_time64(cause->time);
 
+      if (vcd_async) vcd_work_terminate();
+
       if (!dump_is_off && !dump_is_full && dumpvars_time != vcd_cur_time) {
 	    fprintf(dump_file, "#%" PLI_UINT64_FMT "\n", dumpvars_time);
       }
@@ -271,12 +510,14 @@ static PLI_INT32 finish_cb(p_cb_data cause)
       for (cur = vcd_list ;  cur ;  cur = next) {
 	    next = cur->next;
 	    free((char *)cur->ident);
+	    free(cur->bits);
 	    free(cur);
       }
       vcd_list = 0;
       vcd_names_delete(&vcd_tab);
       vcd_names_delete(&vcd_var);
       nexus_ident_delete();
+      vcd_dumpcfg_free();
       free(dump_path);
       dump_path = 0;
 
@@ -326,11 +567,13 @@ static PLI_INT32 sys_dumpoff_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 
       if (dump_file == 0) return 0;
       if (dump_header_pending()) return 0;
+      if (dump_is_outside) return 0;
 
       now.type = vpiSimTime;
       vpi_get_time(0, &now);
       now64 = timerec_to_time64(&now);
 
+      vcd_sync();
       if (now64 > vcd_cur_time) {
 	    fprintf(dump_file, "#%" PLI_UINT64_FMT "\n", now64);
 	    vcd_cur_time = now64;
@@ -356,11 +599,13 @@ static PLI_INT32 sys_dumpon_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 
       if (dump_file == 0) return 0;
       if (dump_header_pending()) return 0;
+      if (dump_is_outside) return 0;
 
       now.type = vpiSimTime;
       vpi_get_time(0, &now);
       now64 = timerec_to_time64(&now);
 
+      vcd_sync();
       if (now64 > vcd_cur_time) {
 	    fprintf(dump_file, "#%" PLI_UINT64_FMT "\n", now64);
 	    vcd_cur_time = now64;
@@ -383,11 +628,13 @@ static PLI_INT32 sys_dumpall_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       if (dump_is_off) return 0;
       if (dump_file == 0) return 0;
       if (dump_header_pending()) return 0;
+      if (dump_is_outside) return 0;
 
       now.type = vpiSimTime;
       vpi_get_time(0, &now);
       now64 = timerec_to_time64(&now);
 
+      vcd_sync();
       if (now64 > vcd_cur_time) {
 	    fprintf(dump_file, "#%" PLI_UINT64_FMT "\n", now64);
 	    vcd_cur_time = now64;
@@ -444,6 +691,8 @@ static void open_dumpfile(vpiHandle callh)
 	    fprintf(dump_file, "$timescale\n");
 	    fprintf(dump_file, "\t%u%s\n", scale, units_names[udx]);
 	    fprintf(dump_file, "$end\n");
+
+	    if (vcd_async) vcd_work_start(vcd_thread, 0);
       }
 }
 
@@ -485,7 +734,12 @@ static PLI_INT32 sys_dumpfile_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 static PLI_INT32 sys_dumpflush_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 {
       (void)name; /* Parameter is not used. */
-      if (dump_file) fflush(dump_file);
+      if (dump_file == 0) return 0;
+
+      if (vcd_async && !finish_status)
+	    vcd_work_flush();
+      else
+	    fflush(dump_file);
 
       return 0;
 }
@@ -509,7 +763,6 @@ static PLI_INT32 sys_dumplimit_calltf(ICARUS_VPI_CONST PLI_BYTE8 *name)
 
 static void scan_item(unsigned depth, vpiHandle item, int skip)
 {
-      struct t_cb_data cb;
       struct vcd_info* info;
 
       const char *type;
@@ -618,6 +871,9 @@ static void scan_item(unsigned depth, vpiHandle item, int skip)
 	       * scope then just return. */
             if (skip || vpi_get(vpiAutomatic, item)) return;
 
+	      /* Skip signals that the dump control file leaves out. */
+	    if (!vcd_dumpcfg_signal(fullname)) return;
+
 	      /* Skip this signal if it has already been included.
 	       * This can only happen for implicitly given signals. */
 	    if (vcd_names_search(&vcd_var, fullname)) return;
@@ -645,19 +901,17 @@ static void scan_item(unsigned depth, vpiHandle item, int skip)
 		  info->item  = item;
 		  info->ident = ident;
 		  info->scheduled = 0;
-
-		  cb.time      = &info->time;
-		  cb.user_data = (char*)info;
-		  cb.value     = NULL;
-		  cb.obj       = item;
-		  cb.reason    = cbValueChange;
-		  cb.cb_rtn    = variable_cb_1;
+		  info->type  = vpi_get(vpiType, item);
+		  info->size  = vpi_get(vpiSize, item);
+		  info->bits  = 0;
+		  if (info->type != vpiRealVar && info->type != vpiNamedEvent)
+			info->bits = malloc(info->size + 1);
 
 		  info->dmp_next = 0;
 		  info->next  = vcd_list;
 		  vcd_list    = info;
 
-		  info->cb    = vpi_register_cb(&cb);
+		  register_variable_cb(info);
 	    }
 
 	      /* Named events do not have a size, but other tools use
@@ -767,6 +1021,68 @@ static int draw_scope(vpiHandle item, vpiHandle callh)
       return depth;
 }
 
+static void dumpvars_item(unsigned depth, vpiHandle item, vpiHandle callh)
+{
+      char *scname;
+      const char *fullname;
+      int add_var = 0;
+      int dep;
+      PLI_INT32 item_type = vpi_get(vpiType, item);
+
+	/* If this is a signal make sure it has not already
+	 * been included. */
+      switch (item_type) {
+	  case vpiIntegerVar:
+	  case vpiBitVar:
+	  case vpiByteVar:
+	  case vpiShortIntVar:
+	  case vpiIntVar:
+	  case vpiLongIntVar:
+	  case vpiMemoryWord:
+	  case vpiNamedEvent:
+	  case vpiNet:
+	  case vpiParameter:
+	  case vpiRealVar:
+	  case vpiReg:
+	  case vpiTimeVar:
+	      /* Warn if the variables scope (which includes the
+	       * variable) or the variable itself was already
+	       * included. A scope does not automatically include
+	       * memory words so do not check the scope for them.  */
+	    scname = strdup(vpi_get_str(vpiFullName,
+					vpi_handle(vpiScope, item)));
+	    fullname = vpi_get_str(vpiFullName, item);
+	    if (((item_type != vpiMemoryWord) &&
+		 vcd_names_search(&vcd_tab, scname)) ||
+		vcd_names_search(&vcd_var, fullname)) {
+		  vpi_printf("VCD warning: skipping signal %s, "
+			     "it was previously included.\n",
+			     fullname);
+		  free(scname);
+		  return;
+	    } else {
+		  add_var = 1;
+	    }
+	    free(scname);
+      }
+
+      dep = draw_scope(item, callh);
+
+      scan_item(depth, item, 0);
+	/* The scope list must be sorted after we scan an item.  */
+      vcd_names_sort(&vcd_tab);
+
+      while (dep--) fprintf(dump_file, "$upscope $end\n");
+
+	/* Add this signal to the variable list so we can verify it
+	 * is not included twice. This must be done after it has
+	 * been added */
+      if (add_var) {
+	    vcd_names_add(&vcd_var, vpi_get_str(vpiFullName, item));
+	    vcd_names_sort(&vcd_var);
+      }
+}
+
 static PLI_INT32 sys_dumpvars_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 {
       vpiHandle callh = vpi_handle(vpiSysTfCall, 0);
@@ -790,6 +1106,27 @@ static PLI_INT32 sys_dumpvars_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 	    return 0;
       }
 
+	/* The scopes in a dump control file replace the arguments.
+	   They are added by the first $dumpvars call, and the later
+	   calls in the same time step add nothing. */
+      if (vcd_dumpcfg_scope_count() > 0) {
+	    unsigned idx;
+	    if (argv) vpi_free_object(argv);
+	    if (dumpcfg_scopes_done) return 0;
+	    dumpcfg_scopes_done = 1;
+	    for (idx = 0 ;  idx < vcd_dumpcfg_scope_count() ;  idx += 1) {
+		  const char*scname = vcd_dumpcfg_scope(idx, &depth);
+		  item = vpi_handle_by_name(scname, 0);
+		  if (item == 0) {
+			vpi_printf("VCD warning: dump control scope %s "
+			           "not found.\n", scname);
+			continue;
+		  }
+		  dumpvars_item(depth ? depth : 10000, item, callh);
+	    }
+	    return 0;
+      }
+
         /* Get the depth if it exists. */
       if (argv) {
 	    value.format = vpiIntVal;
@@ -805,75 +1142,29 @@ static PLI_INT32 sys_dumpvars_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 	    item = vpi_scan(argv);
       }
 
-      for ( ; item; item = vpi_scan(argv)) {
-	    char *scname;
-	    const char *fullname;
-	    int add_var = 0;
-	    int dep;
-	    PLI_INT32 item_type = vpi_get(vpiType, item);
-
-	      /* If this is a signal make sure it has not already
-	       * been included. */
-	    switch (item_type) {
-	        case vpiIntegerVar:
-		case vpiBitVar:
-		case vpiByteVar:
-		case vpiShortIntVar:
-		case vpiIntVar:
-		case vpiLongIntVar:
-	        case vpiMemoryWord:
-	        case vpiNamedEvent:
-	        case vpiNet:
-	        case vpiParameter:
-	        case vpiRealVar:
-	        case vpiReg:
-	        case vpiTimeVar:
-		    /* Warn if the variables scope (which includes the
-		     * variable) or the variable itself was already
-		     * included. A scope does not automatically include
-		     * memory words so do not check the scope for them.  */
-		  scname = strdup(vpi_get_str(vpiFullName,
-		                              vpi_handle(vpiScope, item)));
-		  fullname = vpi_get_str(vpiFullName, item);
-		  if (((item_type != vpiMemoryWord) &&
-		       vcd_names_search(&vcd_tab, scname)) ||
-		      vcd_names_search(&vcd_var, fullname)) {
-		        vpi_printf("VCD warning: skipping signal %s, "
-		                   "it was previously included.\n",
-		                   fullname);
-		        free(scname);
-		        continue;
-		  } else {
-		        add_var = 1;
-		  }
-		  free(scname);
-	    }
-
-	    dep = draw_scope(item, callh);
-
-	    scan_item(depth, item, 0);
-	      /* The scope list must be sorted after we scan an item.  */
-	    vcd_names_sort(&vcd_tab);
-
-	    while (dep--) fprintf(dump_file, "$upscope $end\n");
-
-	      /* Add this signal to the variable list so we can verify it
-	       * is not included twice. This must be done after it has
-	       * been added */
-	    if (add_var) {
-		  vcd_names_add(&vcd_var, vpi_get_str(vpiFullName, item));
-		  vcd_names_sort(&vcd_var);
-	    }
-      }
+      for ( ; item; item = vpi_scan(argv))
+	    dumpvars_item(depth, item, callh);
 
       return 0;
 }
 
 void sys_vcd_register(void)
 {
+      int idx;
+      struct t_vpi_vlog_info vlog_info;
       s_vpi_systf_data tf_data;
       vpiHandle res;
 
+	/* Scan the extended arguments, looking for the async flag. */
+      vpi_get_vlog_info(&vlog_info);
+
+      for (idx = 0 ;  idx < vlog_info.argc ;  idx += 1) {
+	    if (strcmp(vlog_info.argv[idx],"-vcd-async") == 0)
+		  vcd_async = 1;
+      }
+
+      vcd_dumpcfg_load("VCD");
+
       /* All the compiletf routines are located in vcd_priv.c. */
 
       tf_data.type      = vpiSysTask;
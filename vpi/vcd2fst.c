@@ -0,0 +1,745 @@
+/*
+ * Copyright (c) 2026 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * This is a stand alone program that converts a VCD file to FST (or
+ * LXT2 with -l) using the same writers as the run time dumpers. The
+ * VCD is read in a single pass, and only the identifier table is kept
+ * in memory, so any size of input can be converted. With -j each FST
+ * value change block is compressed by that many threads. The blocks
+ * are compressed when the writer flushes them, and parsing waits for
+ * that, so -j shortens the flushes but does not overlap them with the
+ * parse. LXT2 has no threaded compression, so -j is rejected with -l.
+ *
+ *    iverilog-vcd2fst [-l] [-j <threads>] [-v] <input.vcd> <output>
+ *
+ * The input may be "-" to read the standard input.
+ */
+
+# include  "fstapi.h"
+# include  "lxt2_write.h"
+# include  <stdio.h>
+# include  <stdlib.h>
+# include  <string.h>
+# include  <ctype.h>
+# include  <sys/time.h>
+
+static FILE*vcd_in = 0;
+static const char*vcd_path = 0;
+static unsigned long vcd_line = 1;
+static unsigned long long vcd_bytes = 0;
+static unsigned long long vcd_changes = 0;
+
+static void*fst_ctx = 0;
+static struct lxt2_wr_trace*lxt2_ctx = 0;
+
+/*
+ * The input is read in large blocks and split into white space
+ * separated tokens. The token buffer grows to hold the longest token.
+ */
+static unsigned char read_buf[256*1024];
+static size_t read_pos = 0;
+static size_t read_len = 0;
+
+static char*token = 0;
+static size_t token_alloc = 0;
+
+static int next_char(void)
+{
+      if (read_pos == read_len) {
+	    read_len = fread(read_buf, 1, sizeof read_buf, vcd_in);
+	    read_pos = 0;
+	    vcd_bytes += read_len;
+	    if (read_len == 0) return EOF;
+      }
+      return read_buf[read_pos++];
+}
+
+static const char*next_token(void)
+{
+      size_t len = 0;
+      int ch;
+
+      do {
+	    ch = next_char();
+	    if (ch == '\n') vcd_line += 1;
+      } while (ch != EOF && isspace(ch));
+
+      if (ch == EOF) return 0;
+
+      do {
+	    if (len+1 >= token_alloc) {
+		  token_alloc = token_alloc ? 2*token_alloc : 256;
+		  token = realloc(token, token_alloc);
+	    }
+	    token[len++] = ch;
+	    ch = next_char();
+      } while (ch != EOF && !isspace(ch));
+
+      if (ch == '\n') vcd_line += 1;
+      token[len] = 0;
+      return token;
+}
+
+static void error(const char*msg)
+{
+      fprintf(stderr, "%s:%lu: error: %s\n", vcd_path, vcd_line, msg);
+      exit(1);
+}
+
+static void warning(const char*msg)
+{
+      fprintf(stderr, "%s:%lu: warning: %s\n", vcd_path, vcd_line, msg);
+}
+
+/*
+ * Read the tokens of a $<keyword> ... $end section into a list. The
+ * strings are owned by the caller.
+ */
+struct token_list_s {
+      char**item;
+      unsigned count;
+};
+
+static void read_section(struct token_list_s*list)
+{
+      const char*tok;
+
+      list->item = 0;
+      list->count = 0;
+      while ((tok = next_token())) {
+	    if (strcmp(tok, "$end") == 0) return;
+	    list->item = realloc(list->item, (list->count+1) * sizeof(char*));
+	    list->item[list->count++] = strdup(tok);
+      }
+      error("unexpected end of file in a $ section");
+}
+
+static void free_section(struct token_list_s*list)
+{
+      unsigned idx;
+      for (idx = 0 ;  idx < list->count ;  idx += 1)
+	    free(list->item[idx]);
+      free(list->item);
+}
+
+/*
+ * The VCD identifiers are looked up in a chained hash table that
+ * doubles in size as it fills up.
+ */
+enum symbol_kind_e { SYM_BITS, SYM_REAL, SYM_EVENT, SYM_STRING };
+
+struct symbol_s {
+      char*ident;
+      char*name;
+      unsigned size;
+      enum symbol_kind_e kind;
+      fstHandle handle;
+      struct lxt2_wr_symbol*sym;
+      struct symbol_s*next;
+};
+
+static struct symbol_s**symbol_tab = 0;
+static unsigned symbol_tab_size = 0;
+static unsigned symbol_count = 0;
+
+static unsigned hash_ident(const char*ident)
+{
+      unsigned hash = 5381;
+      while (*ident) hash = hash*33 + (unsigned char)*ident++;
+      return hash;
+}
+
+static struct symbol_s*find_symbol(const char*ident)
+{
+      struct symbol_s*cur;
+
+      if (symbol_tab_size == 0) return 0;
+
+      cur = symbol_tab[hash_ident(ident) & (symbol_tab_size-1)];
+      for ( ; cur ; cur = cur->next) {
+	    if (strcmp(cur->ident, ident) == 0) return cur;
+      }
+      return 0;
+}
+
+static void add_symbol(struct symbol_s*sym)
+{
+      unsigned idx;
+
+      if (symbol_count >= symbol_tab_size) {
+	    unsigned new_size = symbol_tab_size ? 2*symbol_tab_size : 4096;
+	    struct symbol_s**new_tab = calloc(new_size, sizeof(struct symbol_s*));
+	    for (idx = 0 ;  idx < symbol_tab_size ;  idx += 1) {
+		  struct symbol_s*cur = symbol_tab[idx];
+		  while (cur) {
+			struct symbol_s*next = cur->next;
+			unsigned hash = hash_ident(cur->ident) & (new_size-1);
+			cur->next = new_tab[hash];
+			new_tab[hash] = cur;
+			cur = next;
+		  }
+	    }
+	    free(symbol_tab);
+	    symbol_tab = new_tab;
+	    symbol_tab_size = new_size;
+      }
+
+      idx = hash_ident(sym->ident) & (symbol_tab_size-1);
+      sym->next = symbol_tab[idx];
+      symbol_tab[idx] = sym;
+      symbol_count += 1;
+}
+
+/*
+ * The LXT2 writer wants full hierarchical names, so keep the current
+ * scope path.
+ */
+static char*scope_path = 0;
+static size_t scope_path_len = 0;
+
+static void push_scope(const char*name)
+{
+      size_t len = strlen(name);
+      scope_path = realloc(scope_path, scope_path_len + len + 2);
+      if (scope_path_len > 0) scope_path[scope_path_len++] = '.';
+      strcpy(scope_path + scope_path_len, name);
+      scope_path_len += len;
+}
+
+static void pop_scope(void)
+{
+      while (scope_path_len > 0 && scope_path[scope_path_len-1] != '.')
+	    scope_path_len -= 1;
+      if (scope_path_len > 0) scope_path_len -= 1;
+      if (scope_path) scope_path[scope_path_len] = 0;
+}
+
+static void do_timescale(struct token_list_s*list)
+{
+      static const char*units[] = { "s", "ms", "us", "ns", "ps", "fs" };
+      char buf[64] = "";
+      char*unit;
+      unsigned idx;
+      long num;
+      int exp = 0;
+
+      for (idx = 0 ;  idx < list->count ;  idx += 1) {
+	    if (strlen(buf) + strlen(list->item[idx]) >= sizeof buf) break;
+	    strcat(buf, list->item[idx]);
+      }
+
+      num = strtol(buf, &unit, 10);
+      while (num >= 10) {
+	    exp += 1;
+	    num /= 10;
+      }
+      for (idx = 0 ;  idx < sizeof units / sizeof units[0] ;  idx += 1) {
+	    if (strcmp(unit, units[idx]) == 0) break;
+      }
+      if (num != 1 || idx == sizeof units / sizeof units[0]) {
+	    warning("invalid $timescale, using 1s");
+	    exp = 0;
+	    idx = 0;
+      }
+      exp -= 3*idx;
+
+      if (fst_ctx) fstWriterSetTimescale(fst_ctx, exp);
+      if (lxt2_ctx) lxt2_wr_set_timescale(lxt2_ctx, exp);
+}
+
+static void do_scope(struct token_list_s*list)
+{
+      enum fstScopeType type = FST_ST_VCD_MODULE;
+
+      if (list->count < 2) {
+	    warning("invalid $scope");
+	    return;
+      }
+
+      if (strcmp(list->item[0], "task") == 0) type = FST_ST_VCD_TASK;
+      else if (strcmp(list->item[0], "function") == 0) type = FST_ST_VCD_FUNCTION;
+      else if (strcmp(list->item[0], "begin") == 0) type = FST_ST_VCD_BEGIN;
+      else if (strcmp(list->item[0], "fork") == 0) type = FST_ST_VCD_FORK;
+
+      if (fst_ctx) fstWriterSetScope(fst_ctx, type, list->item[1], 0);
+      push_scope(list->item[1]);
+}
+
+static void do_upscope(void)
+{
+      if (fst_ctx) fstWriterSetUpscope(fst_ctx);
+      pop_scope();
+}
+
+static const struct {
+      const char*name;
+      enum fstVarType type;
+} var_types[] = {
+      { "event",     FST_VT_VCD_EVENT },
+      { "integer",   FST_VT_VCD_INTEGER },
+      { "parameter", FST_VT_VCD_PARAMETER },
+      { "real",      FST_VT_VCD_REAL },
+      { "real_parameter", FST_VT_VCD_REAL_PARAMETER },
+      { "realtime",  FST_VT_VCD_REALTIME },
+      { "reg",       FST_VT_VCD_REG },
+      { "supply0",   FST_VT_VCD_SUPPLY0 },
+      { "supply1",   FST_VT_VCD_SUPPLY1 },
+      { "time",      FST_VT_VCD_TIME },
+      { "tri",       FST_VT_VCD_TRI },
+      { "triand",    FST_VT_VCD_TRIAND },
+      { "trior",     FST_VT_VCD_TRIOR },
+      { "trireg",    FST_VT_VCD_TRIREG },
+      { "tri0",      FST_VT_VCD_TRI0 },
+      { "tri1",      FST_VT_VCD_TRI1 },
+      { "wand",      FST_VT_VCD_WAND },
+      { "wire",      FST_VT_VCD_WIRE },
+      { "wor",       FST_VT_VCD_WOR },
+      { "string",    FST_VT_GEN_STRING },
+      { 0,           FST_VT_VCD_WIRE }
+};
+
+static void do_var(struct token_list_s*list)
+{
+      enum fstVarType type = FST_VT_VCD_WIRE;
+      struct symbol_s*alias;
+      struct symbol_s*sym;
+      char*name;
+      size_t len;
+      unsigned idx;
+      int msb, lsb;
+
+      if (list->count < 4) {
+	    warning("invalid $var");
+	    return;
+      }
+
+      for (idx = 0 ;  var_types[idx].name ;  idx += 1) {
+	    if (strcmp(list->item[0], var_types[idx].name) == 0) {
+		  type = var_types[idx].type;
+		  break;
+	    }
+      }
+
+	/* The reference is the name and an optional range. */
+      len = 1;
+      for (idx = 3 ;  idx < list->count ;  idx += 1)
+	    len += strlen(list->item[idx]) + 1;
+      name = malloc(len);
+      strcpy(name, list->item[3]);
+      for (idx = 4 ;  idx < list->count ;  idx += 1) {
+	    strcat(name, " ");
+	    strcat(name, list->item[idx]);
+      }
+
+      sym = calloc(1, sizeof(struct symbol_s));
+      sym->ident = strdup(list->item[2]);
+      sym->size = strtoul(list->item[1], 0, 10);
+      sym->kind = SYM_BITS;
+      if (type == FST_VT_VCD_REAL || type == FST_VT_VCD_REAL_PARAMETER
+	  || type == FST_VT_VCD_REALTIME) sym->kind = SYM_REAL;
+      else if (type == FST_VT_VCD_EVENT) sym->kind = SYM_EVENT;
+      else if (type == FST_VT_GEN_STRING) sym->kind = SYM_STRING;
+      if (sym->size == 0) sym->size = 1;
+
+      msb = sym->size - 1;
+      lsb = 0;
+      if (list->count > 4)
+	    sscanf(list->item[4], "[%d:%d]", &msb, &lsb);
+
+      alias = find_symbol(sym->ident);
+
+      if (fst_ctx) {
+	    sym->handle = fstWriterCreateVar(fst_ctx, type, FST_VD_IMPLICIT,
+					     sym->kind == SYM_REAL ? 64 : sym->size,
+					     name, alias ? alias->handle : 0);
+      }
+
+      if (lxt2_ctx) {
+	    char*full = malloc(scope_path_len + strlen(list->item[3]) + 2);
+	    sprintf(full, "%s%s%s", scope_path_len ? scope_path : "",
+		    scope_path_len ? "." : "", list->item[3]);
+	    if (alias) {
+		  lxt2_wr_symbol_alias(lxt2_ctx, alias->name, full, msb, lsb);
+		  sym->sym = alias->sym;
+	    } else {
+		  int flags = LXT2_WR_SYM_F_BITS;
+		  if (sym->kind == SYM_REAL) flags = LXT2_WR_SYM_F_DOUBLE;
+		  if (sym->kind == SYM_STRING) flags = LXT2_WR_SYM_F_STRING;
+		  sym->sym = lxt2_wr_symbol_add(lxt2_ctx, full, 0, msb, lsb, flags);
+	    }
+	    sym->name = full;
+      }
+
+      free(name);
+
+	/* Only the first definition of an identifier is looked up, the
+	   others are aliases of it. */
+      if (alias) {
+	    free(sym->ident);
+	    free(sym->name);
+	    free(sym);
+      } else {
+	    add_symbol(sym);
+      }
+}
+
+/*
+ * VCD vectors may be written with fewer bits than the width. They are
+ * extended the VCD way: with 0 if the first bit is 1, otherwise with
+ * the first bit. An empty value or one that starts with something
+ * other than a bit is not valid, and is filled with x. The FST writer
+ * wants exactly the declared width.
+ */
+static char*value_buf = 0;
+static size_t value_alloc = 0;
+
+static const char*extend_value(const char*bits, unsigned size)
+{
+      size_t len = strlen(bits);
+      size_t idx;
+      char fill;
+
+      if (size+1 > value_alloc) {
+	    value_alloc = size+1;
+	    value_buf = realloc(value_buf, value_alloc);
+      }
+
+      if (len >= size) {
+	    bits += len - size;
+	    len = size;
+      }
+
+      fill = len? tolower((unsigned char)bits[0]) : 0;
+      switch (fill) {
+	  case '0':
+	  case '1':
+	    fill = '0';
+	    break;
+	  case 'x':
+	  case 'z':
+	    break;
+	  default:
+	    warning("invalid bit value, filled with x");
+	    fill = 'x';
+	    break;
+      }
+      memset(value_buf, fill, size - len);
+      for (idx = 0 ;  idx < len ;  idx += 1)
+	    value_buf[size-len+idx] = tolower((unsigned char)bits[idx]);
+      value_buf[size] = 0;
+
+      return value_buf;
+}
+
+static void emit_bits(const char*ident, const char*bits)
+{
+      struct symbol_s*sym = find_symbol(ident);
+
+      if (sym == 0) {
+	    warning("value change for an undeclared identifier");
+	    return;
+      }
+
+      vcd_changes += 1;
+
+      if (sym->kind == SYM_REAL || sym->kind == SYM_STRING) {
+	    warning("bit value change for a real or string variable");
+	    return;
+      }
+
+      if (fst_ctx) {
+	    fstWriterEmitValueChange(fst_ctx, sym->handle,
+				     extend_value(bits, sym->size));
+      }
+      if (lxt2_ctx) {
+	    lxt2_wr_emit_value_bit_string(lxt2_ctx, sym->sym, 0, (char*)bits);
+      }
+}
+
+static void emit_real(const char*ident, double val)
+{
+      struct symbol_s*sym = find_symbol(ident);
+
+      if (sym == 0) {
+	    warning("value change for an undeclared identifier");
+	    return;
+      }
+
+      vcd_changes += 1;
+
+      if (sym->kind != SYM_REAL) {
+	    warning("real value change for a vector variable");
+	    return;
+      }
+
+      if (fst_ctx) fstWriterEmitValueChange(fst_ctx, sym->handle, &val);
+      if (lxt2_ctx) lxt2_wr_emit_value_double(lxt2_ctx, sym->sym, 0, val);
+}
+
+static void emit_string(const char*ident, const char*str)
+{
+      struct symbol_s*sym = find_symbol(ident);
+
+      if (sym == 0) {
+	    warning("value change for an undeclared identifier");
+	    return;
+      }
+
+      vcd_changes += 1;
+
+      if (sym->kind != SYM_STRING) return;
+
+      if (fst_ctx) {
+	    fstWriterEmitVariableLengthValueChange(fst_ctx, sym->handle,
+						   str, strlen(str));
+      }
+      if (lxt2_ctx) {
+	    lxt2_wr_emit_value_string(lxt2_ctx, sym->sym, 0, (char*)str);
+      }
+}
+
+static void emit_time(const char*str)
+{
+      unsigned long long val;
+      char*end;
+
+      val = strtoull(str, &end, 10);
+      if (*end != 0) {
+	    warning("invalid time");
+	    return;
+      }
+
+      if (fst_ctx) fstWriterEmitTimeChange(fst_ctx, val);
+      if (lxt2_ctx) lxt2_wr_set_time64(lxt2_ctx, val);
+}
+
+static void emit_dump_active(int flag)
+{
+      if (fst_ctx) fstWriterEmitDumpActive(fst_ctx, flag);
+      if (lxt2_ctx) {
+	    if (flag) lxt2_wr_set_dumpon(lxt2_ctx);
+	    else lxt2_wr_set_dumpoff(lxt2_ctx);
+      }
+}
+
+static void do_keyword(const char*tok)
+{
+      struct token_list_s list;
+
+      if (strcmp(tok, "$timescale") == 0) {
+	    read_section(&list);
+	    do_timescale(&list);
+	    free_section(&list);
+
+      } else if (strcmp(tok, "$scope") == 0) {
+	    read_section(&list);
+	    do_scope(&list);
+	    free_section(&list);
+
+      } else if (strcmp(tok, "$upscope") == 0) {
+	    read_section(&list);
+	    do_upscope();
+	    free_section(&list);
+
+      } else if (strcmp(tok, "$var") == 0) {
+	    read_section(&list);
+	    do_var(&list);
+	    free_section(&list);
+
+      } else if (strcmp(tok, "$dumpoff") == 0) {
+	    emit_dump_active(0);
+
+      } else if (strcmp(tok, "$dumpon") == 0) {
+	    emit_dump_active(1);
+
+      } else if (strcmp(tok, "$dumpvars") == 0 ||
+		 strcmp(tok, "$dumpall") == 0 ||
+		 strcmp(tok, "$end") == 0) {
+	      /* The values that follow are ordinary value changes. */
+
+      } else {
+	      /* $date, $version, $comment, $enddefinitions and any
+		 unknown sections are skipped. */
+	    read_section(&list);
+	    free_section(&list);
+      }
+}
+
+static void convert(void)
+{
+      const char*tok;
+      char*bits = 0;
+
+      while ((tok = next_token())) {
+	    switch (tok[0]) {
+		case '$':
+		  do_keyword(tok);
+		  break;
+
+		case '#':
+		  emit_time(tok+1);
+		  break;
+
+		case '0':
+		case '1':
+		case 'x':
+		case 'X':
+		case 'z':
+		case 'Z': {
+		      char val[2];
+		      val[0] = tok[0];
+		      val[1] = 0;
+		      emit_bits(tok+1, val);
+		      break;
+		}
+
+		case 'b':
+		case 'B':
+		  free(bits);
+		  bits = strdup(tok+1);
+		  if ((tok = next_token()) == 0)
+			error("unexpected end of file in a value change");
+		  emit_bits(tok, bits);
+		  break;
+
+		case 'r':
+		case 'R': {
+		      double val = strtod(tok+1, 0);
+		      if ((tok = next_token()) == 0)
+			    error("unexpected end of file in a value change");
+		      emit_real(tok, val);
+		      break;
+		}
+
+		case 's':
+		case 'S':
+		  free(bits);
+		  bits = strdup(tok+1);
+		  if ((tok = next_token()) == 0)
+			error("unexpected end of file in a value change");
+		  emit_string(tok, bits);
+		  break;
+
+		default:
+		  warning("unknown token skipped");
+		  break;
+	    }
+      }
+
+      free(bits);
+}
+
+static void usage(void)
+{
+      fprintf(stderr, "usage: iverilog-vcd2fst [-l] [-j <threads>] [-v] "
+	      "<input.vcd> <output>\n"
+	      "   -l           Write LXT2 instead of FST.\n"
+	      "   -j threads   Compress FST blocks with this many threads\n"
+	      "                (not with -l).\n"
+	      "   -v           Print the conversion rate when done.\n");
+      exit(1);
+}
+
+int main(int argc, char*argv[])
+{
+      int lxt2_flag = 0;
+      int verbose_flag = 0;
+      int threads = 1;
+      const char*out_path;
+      struct timeval start, stop;
+      int idx;
+
+      for (idx = 1 ;  idx < argc && argv[idx][0] == '-' && argv[idx][1] ;  idx += 1) {
+	    if (strcmp(argv[idx], "-l") == 0) {
+		  lxt2_flag = 1;
+	    } else if (strcmp(argv[idx], "-v") == 0) {
+		  verbose_flag = 1;
+	    } else if (strcmp(argv[idx], "-j") == 0 && idx+1 < argc) {
+		  threads = atoi(argv[++idx]);
+		  if (threads < 1) usage();
+	    } else {
+		  usage();
+	    }
+      }
+
+      if (argc - idx != 2) usage();
+
+      if (lxt2_flag && threads > 1) {
+	    fprintf(stderr, "iverilog-vcd2fst: -j is only supported for FST "
+		    "output, not with -l.\n");
+	    return 1;
+      }
+
+      vcd_path = argv[idx];
+      out_path = argv[idx+1];
+
+      if (strcmp(vcd_path, "-") == 0) {
+	    vcd_in = stdin;
+	    vcd_path = "<stdin>";
+      } else {
+	    vcd_in = fopen(vcd_path, "rb");
+      }
+      if (vcd_in == 0) {
+	    fprintf(stderr, "Unable to open %s for reading.\n", vcd_path);
+	    return 1;
+      }
+
+      if (lxt2_flag) {
+	    lxt2_ctx = lxt2_wr_init(out_path);
+	    if (lxt2_ctx) {
+		  lxt2_wr_set_initial_value(lxt2_ctx, 'x');
+		  lxt2_wr_set_compression_depth(lxt2_ctx, 4);
+		  lxt2_wr_set_partial_on(lxt2_ctx, 1);
+	    }
+      } else {
+	    fst_ctx = fstWriterCreate(out_path, 1);
+	    if (fst_ctx) {
+		  fstWriterSetVersion(fst_ctx, "Icarus Verilog vcd2fst");
+		  fstWriterSetCompressThreads(fst_ctx, threads);
+	    }
+      }
+      if (fst_ctx == 0 && lxt2_ctx == 0) {
+	    fprintf(stderr, "Unable to open %s for writing.\n", out_path);
+	    return 1;
+      }
+
+      gettimeofday(&start, 0);
+      convert();
+
+      if (fst_ctx) fstWriterClose(fst_ctx);
+      if (lxt2_ctx) lxt2_wr_close(lxt2_ctx);
+      if (vcd_in != stdin) fclose(vcd_in);
+
+      if (verbose_flag) {
+	    double secs;
+	    gettimeofday(&stop, 0);
+	    secs = (stop.tv_sec - start.tv_sec)
+		  + (stop.tv_usec - start.tv_usec) / 1000000.0;
+	    fprintf(stderr, "%llu bytes, %u identifiers, %llu value changes "
+		    "in %.2f seconds", vcd_bytes, symbol_count,
+		    vcd_changes, secs);
+	    if (secs > 0.0)
+		  fprintf(stderr, " (%.1f MB/s)",
+			  (double)vcd_bytes / secs / 1000000.0);
+	    fprintf(stderr, "\n");
+      }
+
+      return 0;
+}
@@ -130,6 +130,223 @@ void vcd_names_sort(struct vcd_names_list_s*tab)
       }
 }
 
+void vcd_vecval_to_bits(char*buf, const s_vpi_vecval*vec, unsigned size)
+{
+      static const char bit_chars[4] = { '0', '1', 'z', 'x' };
+      unsigned idx;
+
+      for (idx = 0 ;  idx < size ;  idx += 1) {
+	    unsigned bit = size - idx - 1;
+	    const s_vpi_vecval*word = vec + bit/32;
+	    unsigned shift = bit % 32;
+	    unsigned aval = (word->aval >> shift) & 1;
+	    unsigned bval = (word->bval >> shift) & 1;
+	    buf[idx] = bit_chars[(bval << 1) | aval];
+      }
+      buf[size] = 0;
+}
+
+/*
+ * The dump control file given with +dumpcfg=<file>. Each line is one
+ * of these (a # starts a comment):
+ *
+ *    scope <name> [<depth>]   dump this scope instead of the $dumpvars
+ *                             arguments (depth 0 is all levels)
+ *    signal <pattern>         only dump signals whose full name matches
+ *                             one of these (* and ? are wildcards)
+ *    window <start> [<end>]   only dump from start up to end, in units
+ *                             of the simulation precision
+ */
+struct vcd_dumpcfg_scope_s {
+      char*name;
+      unsigned depth;
+};
+
+struct vcd_dumpcfg_window_s {
+      PLI_UINT64 start;
+      PLI_UINT64 end;
+      int has_end;
+};
+
+static struct vcd_dumpcfg_scope_s*dumpcfg_scopes = 0;
+static unsigned dumpcfg_nscopes = 0;
+static char**dumpcfg_signals = 0;
+static unsigned dumpcfg_nsignals = 0;
+static struct vcd_dumpcfg_window_s*dumpcfg_windows = 0;
+static unsigned dumpcfg_nwindows = 0;
+
+static int dumpcfg_glob(const char*pat, const char*str)
+{
+      for ( ; *pat ; pat += 1, str += 1) {
+	    if (*pat == '*') {
+		  while (pat[1] == '*') pat += 1;
+		  if (pat[1] == 0) return 1;
+		  for ( ; *str ; str += 1)
+			if (dumpcfg_glob(pat+1, str)) return 1;
+		  return 0;
+	    }
+	    if (*str == 0) return 0;
+	    if (*pat != '?' && *pat != *str) return 0;
+      }
+      return *str == 0;
+}
+
+static int dumpcfg_parse_line(char*line)
+{
+      char*key, *arg1, *arg2;
+      const char*delim = " \t\r\n";
+
+      if (strchr(line, '#')) *strchr(line, '#') = 0;
+      key = strtok(line, delim);
+      if (key == 0) return 0;
+      arg1 = strtok(0, delim);
+      arg2 = strtok(0, delim);
+      if (arg1 == 0) return -1;
+
+      if (strcmp(key, "scope") == 0) {
+	    struct vcd_dumpcfg_scope_s*cur;
+	    dumpcfg_scopes = realloc(dumpcfg_scopes, (dumpcfg_nscopes+1) *
+	                             sizeof(struct vcd_dumpcfg_scope_s));
+	    cur = dumpcfg_scopes + dumpcfg_nscopes;
+	    cur->name = strdup(arg1);
+	    cur->depth = arg2 ? strtoul(arg2, 0, 10) : 0;
+	    dumpcfg_nscopes += 1;
+
+      } else if (strcmp(key, "signal") == 0) {
+	    dumpcfg_signals = realloc(dumpcfg_signals, (dumpcfg_nsignals+1) *
+	                              sizeof(char*));
+	    dumpcfg_signals[dumpcfg_nsignals] = strdup(arg1);
+	    dumpcfg_nsignals += 1;
+
+      } else if (strcmp(key, "window") == 0) {
+	    struct vcd_dumpcfg_window_s*cur;
+	    dumpcfg_windows = realloc(dumpcfg_windows, (dumpcfg_nwindows+1) *
+	                              sizeof(struct vcd_dumpcfg_window_s));
+	    cur = dumpcfg_windows + dumpcfg_nwindows;
+	    if (sscanf(arg1, "%" PLI_UINT64_FMT, &cur->start) != 1)
+		  return -1;
+	    cur->has_end = arg2 != 0;
+	    cur->end = 0;
+	    if (arg2 && sscanf(arg2, "%" PLI_UINT64_FMT, &cur->end) != 1)
+		  return -1;
+	    if (cur->has_end && cur->end <= cur->start)
+		  return -1;
+	    dumpcfg_nwindows += 1;
+
+      } else {
+	    return -1;
+      }
+
+      return 0;
+}
+
+void vcd_dumpcfg_load(const char*dumper)
+{
+      struct t_vpi_vlog_info vlog_info;
+      const char*path = 0;
+      FILE*fd;
+      char line[1024];
+      unsigned lineno = 0;
+      int idx;
+
+      vpi_get_vlog_info(&vlog_info);
+      for (idx = 0 ;  idx < vlog_info.argc ;  idx += 1) {
+	    if (strncmp(vlog_info.argv[idx], "+dumpcfg=", 9) == 0)
+		  path = vlog_info.argv[idx] + 9;
+      }
+      if (path == 0) return;
+
+      fd = fopen(path, "r");
+      if (fd == 0) {
+	    vpi_printf("%s warning: Unable to open dump control file %s.\n",
+	               dumper, path);
+	    return;
+      }
+
+      while (fgets(line, sizeof line, fd)) {
+	    lineno += 1;
+	    if (dumpcfg_parse_line(line) < 0) {
+		  vpi_printf("%s warning: %s:%u: Ignoring invalid dump "
+		             "control line.\n", dumper, path, lineno);
+	    }
+      }
+
+      fclose(fd);
+}
+
+unsigned vcd_dumpcfg_scope_count(void)
+{
+      return dumpcfg_nscopes;
+}
+
+const char*vcd_dumpcfg_scope(unsigned idx, unsigned*depth)
+{
+      assert(idx < dumpcfg_nscopes);
+      *depth = dumpcfg_scopes[idx].depth;
+      return dumpcfg_scopes[idx].name;
+}
+
+int vcd_dumpcfg_signal(const char*fullname)
+{
+      unsigned idx;
+
+      if (dumpcfg_nsignals == 0) return 1;
+
+      for (idx = 0 ;  idx < dumpcfg_nsignals ;  idx += 1) {
+	    if (dumpcfg_glob(dumpcfg_signals[idx], fullname)) return 1;
+      }
+
+      return 0;
+}
+
+int vcd_dumpcfg_has_windows(void)
+{
+      return dumpcfg_nwindows != 0;
+}
+
+int vcd_dumpcfg_window(PLI_UINT64 now, PLI_UINT64*next)
+{
+      int inside = 0;
+      unsigned idx;
+
+      *next = 0;
+      for (idx = 0 ;  idx < dumpcfg_nwindows ;  idx += 1) {
+	    const struct vcd_dumpcfg_window_s*cur = dumpcfg_windows + idx;
+
+	    if (now >= cur->start && (!cur->has_end || now < cur->end))
+		  inside = 1;
+
+	    if (cur->start > now && (*next == 0 || cur->start < *next))
+		  *next = cur->start;
+	    if (cur->has_end && cur->end > now
+		&& (*next == 0 || cur->end < *next))
+		  *next = cur->end;
+      }
+
+      return inside;
+}
+
+void vcd_dumpcfg_free(void)
+{
+      unsigned idx;
+
+      for (idx = 0 ;  idx < dumpcfg_nscopes ;  idx += 1)
+	    free(dumpcfg_scopes[idx].name);
+      free(dumpcfg_scopes);
+      dumpcfg_scopes = 0;
+      dumpcfg_nscopes = 0;
+
+      for (idx = 0 ;  idx < dumpcfg_nsignals ;  idx += 1)
+	    free(dumpcfg_signals[idx]);
+      free(dumpcfg_signals);
+      dumpcfg_signals = 0;
+      dumpcfg_nsignals = 0;
+
+      free(dumpcfg_windows);
+      dumpcfg_windows = 0;
+      dumpcfg_nwindows = 0;
+}
+
 /*
  * Since the compiletf routines are all the same they are located here,
  * so we only need a single copy. Some are generic enough they can use
@@ -62,6 +62,33 @@ EXTERN void vcd_scope_names_add(const char*name);
 EXTERN int  vcd_scope_names_test(const char*name);
 EXTERN void vcd_scope_names_delete(void);
 
+/*
+ * Convert a vpiVectorVal value of the given width to the 0/1/x/z
+ * characters that the dumpers emit, most significant bit first. The
+ * buffer must have room for size+1 characters. This avoids having
+ * the run time format a vpiBinStrVal string for every value change.
+ */
+EXTERN void vcd_vecval_to_bits(char*buf, const s_vpi_vecval*vec,
+			       unsigned size);
+
+/*
+ * Read the dump control file named by the +dumpcfg=<file> plusarg, if
+ * there is one. The file can replace the $dumpvars scopes, limit the
+ * dumped signals to those matching a set of patterns and limit the
+ * dump to a set of time windows. The dumper name is used in messages.
+ */
+EXTERN void vcd_dumpcfg_load(const char*dumper);
+EXTERN unsigned vcd_dumpcfg_scope_count(void);
+EXTERN const char*vcd_dumpcfg_scope(unsigned idx, unsigned*depth);
+  /* Return true if the signal with this full name should be dumped. */
+EXTERN int vcd_dumpcfg_signal(const char*fullname);
+EXTERN int vcd_dumpcfg_has_windows(void);
+  /* Return true if the time is in a dump window, and set next to the
+     time of the next window start or end (0 if there is none). */
+EXTERN int vcd_dumpcfg_window(PLI_UINT64 now, PLI_UINT64*next);
+  /* Release the dump control settings at the end of the simulation. */
+EXTERN void vcd_dumpcfg_free(void);
+
 /*
  * Implement a work queue that can be used to send commands to a
  * dumper thread.
@@ -71,6 +98,10 @@ typedef enum vcd_work_item_type_e {
       WT_NONE,
       WT_EMIT_BITS,
       WT_EMIT_DOUBLE,
+      WT_EMIT_VCD_VECTOR,
+      WT_EMIT_VCD_WIDE,
+      WT_EMIT_VCD_REAL,
+      WT_EMIT_VCD_EVENT,
       WT_DUMPON,
       WT_DUMPOFF,
       WT_FLUSH,
@@ -78,17 +109,26 @@ typedef enum vcd_work_item_type_e {
 } vcd_work_item_type_t;
 
 struct lxt2_wr_symbol;
+struct vcd_info;
 
 struct vcd_work_item_s {
       vcd_work_item_type_t type;
       uint64_t time;
       union {
 	    struct lxt2_wr_symbol*lxt2;
+	    struct vcd_info*vcd;
       } sym_;
 
       union {
 	    double val_double;
 	    char*val_char;
+	      /* Vectors up to 32 bits wide are stored in the item. */
+	    s_vpi_vecval val_vec;
+	      /* Wider vectors are copied, and freed when popped. */
+	    struct {
+		  s_vpi_vecval*words;
+		  unsigned nwords;
+	    } val_wide;
       } op_;
 };
 
@@ -126,6 +166,17 @@ EXTERN void vcd_work_dumpoff(void);
 EXTERN void vcd_work_emit_double(struct lxt2_wr_symbol*sym, double val);
 EXTERN void vcd_work_emit_bits(struct lxt2_wr_symbol*sym, const char*bits);
 
+/*
+ * These are used by the asynchronous VCD writer. The simulation
+ * thread only queues the raw vpiVectorVal words (or the real value)
+ * and the work thread formats them. The size is the width of the
+ * vector in bits.
+ */
+EXTERN void vcd_work_emit_vcd_vector(struct vcd_info*info,
+				     const s_vpi_vecval*vec, unsigned size);
+EXTERN void vcd_work_emit_vcd_real(struct vcd_info*info, double val);
+EXTERN void vcd_work_emit_vcd_event(struct vcd_info*info);
+
 /* The compiletf routines are common for the VCD, LXT and LXT2 dumpers. */
 EXTERN PLI_INT32 sys_dumpvars_compiletf(ICARUS_VPI_CONST PLI_BYTE8 *name);
 
@@ -89,9 +89,14 @@ static const unsigned WORK_QUEUE_SIZE = 128*1024;
 static const unsigned WORK_QUEUE_BATCH_MIN = 4*1024;
 static const unsigned WORK_QUEUE_BATCH_MAX = 32*1024;
 
+  // Wide vectors are copied out of the work queue, so also limit the
+  // number of bytes that are held by queued items.
+static const size_t WORK_QUEUE_BYTES_MAX = 16*1024*1024;
+
 static struct vcd_work_item_s work_queue[WORK_QUEUE_SIZE];
 static volatile unsigned work_queue_next = 0;
 static volatile unsigned work_queue_fill = 0;
+static volatile size_t work_queue_bytes = 0;
 
 static pthread_mutex_t work_queue_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t  work_queue_is_empty_sig = PTHREAD_COND_INITIALIZER;
@@ -126,8 +131,16 @@ extern "C" void vcd_work_thread_pop(void)
       unsigned use_next = work_queue_next;
 
       struct vcd_work_item_s*cell = work_queue + use_next;
+      size_t use_bytes = work_queue_bytes;
+      bool bytes_freed_flag = false;
       if (cell->type == WT_EMIT_BITS) {
 	    free(cell->op_.val_char);
+      } else if (cell->type == WT_EMIT_VCD_WIDE) {
+	    free(cell->op_.val_wide.words);
+	    size_t bytes = cell->op_.val_wide.nwords * sizeof(s_vpi_vecval);
+	    bytes_freed_flag = use_bytes > WORK_QUEUE_BYTES_MAX
+		  && use_bytes - bytes <= WORK_QUEUE_BYTES_MAX;
+	    work_queue_bytes = use_bytes - bytes;
       }
 
       use_next += 1;
@@ -135,7 +148,7 @@ extern "C" void vcd_work_thread_pop(void)
 	    use_next = 0;
       work_queue_next = use_next;
 
-      if (use_fill == WORK_QUEUE_SIZE-WORK_QUEUE_BATCH_MIN)
+      if (use_fill == WORK_QUEUE_SIZE-WORK_QUEUE_BATCH_MIN || bytes_freed_flag)
 	    pthread_cond_signal(&work_queue_minfree_sig);
       else if (use_fill == 0)
 	    pthread_cond_signal(&work_queue_is_empty_sig);
@@ -154,6 +167,7 @@ static uint64_t work_queue_next_time = 0;
 static unsigned current_batch_cnt = 0;
 static unsigned current_batch_alloc = 0;
 static unsigned current_batch_base = 0;
+static size_t current_batch_bytes = 0;
 
 extern "C" void vcd_work_start( void* (*fun) (void*), void*arg )
 {
@@ -164,7 +178,8 @@ static struct vcd_work_item_s* grab_item(void)
 {
       if (current_batch_alloc == 0) {
 	     pthread_mutex_lock(&work_queue_mutex);
-	     while ((WORK_QUEUE_SIZE-work_queue_fill) < WORK_QUEUE_BATCH_MIN)
+	     while ((WORK_QUEUE_SIZE-work_queue_fill) < WORK_QUEUE_BATCH_MIN
+		    || work_queue_bytes > WORK_QUEUE_BYTES_MAX)
 		  pthread_cond_wait(&work_queue_minfree_sig, &work_queue_mutex);
 
 	     current_batch_base = work_queue_next + work_queue_fill;
@@ -200,9 +215,11 @@ static void end_batch(void)
 
       use_fill += current_batch_cnt;
       work_queue_fill = use_fill;
+      work_queue_bytes += current_batch_bytes;
 
       current_batch_alloc = 0;
       current_batch_cnt = 0;
+      current_batch_bytes = 0;
 
       if (was_empty_flag)
 	    pthread_cond_signal(&work_queue_notempty_sig);
@@ -276,6 +293,49 @@ extern "C" void vcd_work_emit_bits(struct lxt2_wr_symbol*sym, const char* val)
       unlock_item();
 }
 
+extern "C" void vcd_work_emit_vcd_vector(struct vcd_info*info,
+					 const s_vpi_vecval*vec, unsigned size)
+{
+      struct vcd_work_item_s*cell = grab_item();
+      cell->sym_.vcd = info;
+
+      if (size <= 32) {
+	    cell->type = WT_EMIT_VCD_VECTOR;
+	    cell->op_.val_vec = vec[0];
+	    unlock_item();
+	    return;
+      }
+
+      unsigned nwords = (size + 31) / 32;
+      size_t bytes = nwords * sizeof(s_vpi_vecval);
+      cell->type = WT_EMIT_VCD_WIDE;
+      cell->op_.val_wide.words = (s_vpi_vecval*)malloc(bytes);
+      cell->op_.val_wide.nwords = nwords;
+      memcpy(cell->op_.val_wide.words, vec, bytes);
+
+	// Release the batch early if it is holding a lot of memory, so
+	// that the byte limit can take effect.
+      current_batch_bytes += bytes;
+      unlock_item(current_batch_bytes >= WORK_QUEUE_BYTES_MAX/4);
+}
+
+extern "C" void vcd_work_emit_vcd_real(struct vcd_info*info, double val)
+{
+      struct vcd_work_item_s*cell = grab_item();
+      cell->type = WT_EMIT_VCD_REAL;
+      cell->sym_.vcd = info;
+      cell->op_.val_double = val;
+      unlock_item();
+}
+
+extern "C" void vcd_work_emit_vcd_event(struct vcd_info*info)
+{
+      struct vcd_work_item_s*cell = grab_item();
+      cell->type = WT_EMIT_VCD_EVENT;
+      cell->sym_.vcd = info;
+      unlock_item();
+}
+
 extern "C" void vcd_work_terminate(void)
 {
       struct vcd_work_item_s*cell = grab_item();
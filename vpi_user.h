@@ -493,9 +493,30 @@ typedef struct t_cb_data {
 #define cbExitInteractive   22
 #define cbInteractiveScopeChange 23
 #define cbUnresolvedSystf   24
+/* IVL private callback reasons */
+#define _cbValueChangeBatch 0x1000000
+
+/*
+ * The _cbValueChangeBatch reason is registered like cbValueChange,
+ * once for each object to watch. All the registrations that share the
+ * same cb_rtn and user_data form a batch. Instead of calling cb_rtn
+ * for every change, the run time remembers which objects changed and
+ * calls cb_rtn once in the read-only synch region of the time step
+ * with a pointer to a s_cb_batch_data. Each object is listed once no
+ * matter how often it changed, and the values (if a value format was
+ * given when the first object of the batch was registered) are the
+ * final values for the time step.
+ */
+typedef struct t_cb_batch_data {
+      s_cb_data cb;     /* cb.obj is 0 and cb.index is count */
+      PLI_INT32 count;
+      vpiHandle *objs;
+      p_vpi_value values;
+} s_cb_batch_data, *p_cb_batch_data;
 
 extern vpiHandle vpi_register_cb(p_cb_data data);
 extern PLI_INT32 vpi_remove_cb(vpiHandle ref);
+extern void vpi_get_cb_info(vpiHandle ref, p_cb_data data);
 
 /*
  * This function allows a vpi application to control the simulation
@@ -647,6 +668,24 @@ extern void vpip_mcd_rawwrite(PLI_UINT32 mcd, const char*buf, size_t count);
 extern void vpip_count_drivers(vpiHandle ref, unsigned idx,
                                unsigned counts[4]);
 
+  /* Get a read only view of the value of a vector net or variable.
+     The abits and bbits arrays hold the value in words of unsigned
+     long, with the same encoding as the aval/bval of a vpiVectorVal,
+     and the generation counts the value changes of the object. The
+     pointers stay valid for the whole simulation, so the view can be
+     polled without calling vpi_get_value. The view does not include
+     forced values. Return 1 on success, or 0 if the object does not
+     have 4-value vector storage (for example a net with strength). */
+typedef struct t_vpip_vector_view {
+      PLI_UINT32 size;
+      PLI_UINT32 words;
+      const unsigned long *abits;
+      const unsigned long *bbits;
+      const unsigned long *generation;
+} s_vpip_vector_view, *p_vpip_vector_view;
+
+extern PLI_INT32 vpip_vector_view(vpiHandle ref, p_vpip_vector_view view);
+
 /*
  * Stopgap fix for br916. We need to reject any attempt to pass a thread
  * variable to $strobe or $monitor. To do this, we use some private VPI
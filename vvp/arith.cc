@@ -18,15 +18,20 @@
  */
 
 # include  "arith.h"
+# include  "compile.h"
 # include  "schedule.h"
+# include  "statistics.h"
+# include  "parallel.h"
 # include  <climits>
 # include  <iostream>
 # include  <cassert>
 # include  <cstdlib>
 # include  <cmath>
+# include  <map>
+# include  <vector>
 
 vvp_arith_::vvp_arith_(unsigned wid)
-: wid_(wid), op_a_(wid), op_b_(wid), x_val_(wid)
+: wid_(wid), two_state_(false), op_a_(wid), op_b_(wid), x_val_(wid)
 {
       for (unsigned idx = 0 ;  idx < wid ;  idx += 1) {
 	    op_a_ .set_bit(idx, BIT4_Z);
@@ -35,9 +40,27 @@ vvp_arith_::vvp_arith_(unsigned wid)
       }
 }
 
+bool vvp_arith_::has_two_state() const
+{
+      return false;
+}
+
 void vvp_arith_::dispatch_operand_(vvp_net_ptr_t ptr, vvp_vector4_t bit)
 {
       unsigned port = ptr.port();
+
+	/* In 2-state mode only the 2-state operands are kept. The
+	   conversion makes any X/Z bits 0, as a 2-state signal would
+	   have done. */
+      if (two_state_) {
+	    assert(port < 2);
+	    if (port == 0)
+		  op_a2_ = bit;
+	    else
+		  op_b2_ = bit;
+	    return;
+      }
+
       switch (port) {
 	  case 0:
 	    op_a_ = bit;
@@ -46,8 +69,8 @@ void vvp_arith_::dispatch_operand_(vvp_net_ptr_t ptr, vvp_vector4_t bit)
 	    op_b_ = bit;
 	    break;
 	  default:
-	    fprintf(stderr, "Unsupported port type %u.\n", port);
-	    assert(0);
+	    parallel_diag() << "Unsupported port type " << port << "." << endl;
+	    parallel_diag_fatal();
       }
 }
 
@@ -58,6 +81,57 @@ void vvp_arith_::recv_vec4_pv(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
       recv_vec4_pv_(ptr, bit, base, wid, vwid, ctx);
 }
 
+bool vvp_arith_::parallel_safe(void) const
+{
+      return true;
+}
+
+/*
+ * The nets of 2-state signals and the outputs of .cast/2 functors
+ * never carry X or Z bits. They are collected as they are compiled.
+ * When the netlist is complete, the functors that have a 2-state mode
+ * and that get both operands from such nets are switched to that
+ * mode. Their outputs are then 2-state too, so this is repeated
+ * through chains of arithmetic.
+ */
+static std::vector<vvp_net_t*> two_state_sources;
+
+void compile_two_state_source(vvp_net_t*net)
+{
+      two_state_sources.push_back(net);
+}
+
+void compile_two_state_arith(void)
+{
+      std::map<vvp_arith_*,unsigned> ports;
+      std::vector<vvp_net_t*> work;
+      work.swap(two_state_sources);
+
+      while (! work.empty()) {
+	    vvp_net_t*net = work.back();
+	    work.pop_back();
+
+	    vvp_net_ptr_t cur = net->fanout();
+	    while (vvp_net_t*ptr = cur.ptr()) {
+		  unsigned port = cur.port();
+		  cur = ptr->port[port];
+
+		  vvp_arith_*fun = dynamic_cast<vvp_arith_*>(ptr->fun);
+		  if (fun == 0 || fun->is_two_state() || ! fun->has_two_state())
+			continue;
+
+		  unsigned&mask = ports[fun];
+		  mask |= 1 << port;
+		  if (mask != 3)
+			continue;
+
+		  fun->set_two_state();
+		  count_functors_two_state += 1;
+		  work.push_back(ptr);
+	    }
+      }
+}
+
 vvp_arith_abs::vvp_arith_abs()
 {
 }
@@ -425,11 +499,23 @@ void vvp_arith_mult::wide_(vvp_net_ptr_t ptr)
       ptr.ptr()->send_vec4(res4, 0);
 }
 
+bool vvp_arith_mult::has_two_state() const
+{
+      return true;
+}
+
 void vvp_arith_mult::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
                                vvp_context_t)
 {
       dispatch_operand_(ptr, bit);
 
+      if (two_state_) {
+	    vvp_vector2_t value = vvp_vector2_t(op_a2_, wid_)
+		  * vvp_vector2_t(op_b2_, wid_);
+	    ptr.ptr()->send_vec4(vector2_to_vector4(value, wid_), 0);
+	    return;
+      }
+
       if (wid_ > 8 * sizeof(int64_t)) {
 	    wide_(ptr);
 	    return ;
@@ -525,6 +611,11 @@ vvp_arith_sum::~vvp_arith_sum()
 {
 }
 
+bool vvp_arith_sum::has_two_state() const
+{
+      return true;
+}
+
 void vvp_arith_sum::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
                               vvp_context_t)
 {
@@ -532,24 +623,27 @@ void vvp_arith_sum::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
 
       vvp_net_t*net = ptr.ptr();
 
-      vvp_vector4_t value (wid_);
-
-	/* Pad input vectors with this value to widen to the desired
-	   output width. */
-      const vvp_bit4_t pad = BIT4_0;
-
-      vvp_bit4_t carry = BIT4_0;
-      for (unsigned idx = 0 ;  idx < wid_ ;  idx += 1) {
-	    vvp_bit4_t a = (idx >= op_a_.size())? pad : op_a_.value(idx);
-	    vvp_bit4_t b = (idx >= op_b_.size())? pad : op_b_.value(idx);
-	    vvp_bit4_t cur = add_with_carry(a, b, carry);
-
-	    if (cur == BIT4_X) {
-		  net->send_vec4(x_val_, 0);
-		  return;
-	    }
+      if (two_state_) {
+	    vvp_vector2_t value (op_a2_, wid_);
+	    value += vvp_vector2_t(op_b2_, wid_);
+	    net->send_vec4(vector2_to_vector4(value, wid_), 0);
+	    return;
+      }
 
-	    value.set_bit(idx, cur);
+	/* Pad (or truncate) the input vectors to the output width
+	   and add them a word at a time. The vvp_vector4_t::add
+	   method checks the words for X/Z bits as it goes and makes
+	   the result all X if it finds any, so operands that carry
+	   only 0/1 values never go through the bit-by-bit path. */
+      vvp_vector4_t value (op_a_);
+      value.resize(wid_, BIT4_0);
+
+      if (op_b_.size() == wid_) {
+	    value.add(op_b_);
+      } else {
+	    vvp_vector4_t b (op_b_);
+	    b.resize(wid_, BIT4_0);
+	    value.add(b);
       }
 
       net->send_vec4(value, 0);
@@ -570,6 +664,11 @@ vvp_arith_sub::~vvp_arith_sub()
  * further reduce the operation to adding in the inverted value and
  * adding a correction.
  */
+bool vvp_arith_sub::has_two_state() const
+{
+      return true;
+}
+
 void vvp_arith_sub::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
                               vvp_context_t)
 {
@@ -577,24 +676,26 @@ void vvp_arith_sub::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
 
       vvp_net_t*net = ptr.ptr();
 
-      vvp_vector4_t value (wid_);
-
-	/* Pad input vectors with this value to widen to the desired
-	   output width. */
-      const vvp_bit4_t pad = BIT4_1;
-
-      vvp_bit4_t carry = BIT4_1;
-      for (unsigned idx = 0 ;  idx < wid_ ;  idx += 1) {
-	    vvp_bit4_t a = (idx >= op_a_.size())? pad : op_a_.value(idx);
-	    vvp_bit4_t b = (idx >= op_b_.size())? pad : ~op_b_.value(idx);
-	    vvp_bit4_t cur = add_with_carry(a, b, carry);
-
-	    if (cur == BIT4_X) {
-		  net->send_vec4(x_val_, 0);
-		  return;
-	    }
+      if (two_state_) {
+	    vvp_vector2_t value (op_a2_, wid_);
+	    value -= vvp_vector2_t(op_b2_, wid_);
+	    net->send_vec4(vector2_to_vector4(value, wid_), 0);
+	    return;
+      }
 
-	    value.set_bit(idx, cur);
+	/* Pad the input vectors to the output width. The A input is
+	   padded with 1 bits, and the B input is padded so that its
+	   inverted pad bits are 1. Then subtract a word at a time
+	   (see vvp_arith_sum above). */
+      vvp_vector4_t value (op_a_);
+      value.resize(wid_, BIT4_1);
+
+      if (op_b_.size() == wid_) {
+	    value.sub(op_b_);
+      } else {
+	    vvp_vector4_t b (op_b_);
+	    b.resize(wid_, BIT4_0);
+	    value.sub(b);
       }
 
       net->send_vec4(value, 0);
@@ -605,21 +706,24 @@ vvp_cmp_eeq::vvp_cmp_eeq(unsigned wid)
 {
 }
 
+bool vvp_cmp_eeq::has_two_state() const
+{
+      return true;
+}
+
 void vvp_cmp_eeq::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
                             vvp_context_t)
 {
       dispatch_operand_(ptr, bit);
 
-      vvp_vector4_t eeq (1);
-      eeq.set_bit(0, BIT4_1);
+      if (two_state_) {
+	    vvp_vector4_t res (1, op_a2_ == op_b2_? BIT4_1 : BIT4_0);
+	    ptr.ptr()->send_vec4(res, 0);
+	    return;
+      }
 
       assert(op_a_.size() == op_b_.size());
-      for (unsigned idx = 0 ;  idx < op_a_.size() ;  idx += 1)
-	    if (op_a_.value(idx) != op_b_.value(idx)) {
-		  eeq.set_bit(0, BIT4_0);
-		  break;
-	    }
-
+      vvp_vector4_t eeq (1, op_a_.eeq(op_b_)? BIT4_1 : BIT4_0);
 
       vvp_net_t*net = ptr.ptr();
       net->send_vec4(eeq, 0);
@@ -630,21 +734,24 @@ vvp_cmp_nee::vvp_cmp_nee(unsigned wid)
 {
 }
 
+bool vvp_cmp_nee::has_two_state() const
+{
+      return true;
+}
+
 void vvp_cmp_nee::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
                             vvp_context_t)
 {
       dispatch_operand_(ptr, bit);
 
-      vvp_vector4_t eeq (1);
-      eeq.set_bit(0, BIT4_0);
+      if (two_state_) {
+	    vvp_vector4_t res (1, op_a2_ == op_b2_? BIT4_0 : BIT4_1);
+	    ptr.ptr()->send_vec4(res, 0);
+	    return;
+      }
 
       assert(op_a_.size() == op_b_.size());
-      for (unsigned idx = 0 ;  idx < op_a_.size() ;  idx += 1)
-	    if (op_a_.value(idx) != op_b_.value(idx)) {
-		  eeq.set_bit(0, BIT4_1);
-		  break;
-	    }
-
+      vvp_vector4_t eeq (1, op_a_.eeq(op_b_)? BIT4_0 : BIT4_1);
 
       vvp_net_t*net = ptr.ptr();
       net->send_vec4(eeq, 0);
@@ -661,15 +768,35 @@ vvp_cmp_eq::vvp_cmp_eq(unsigned wid)
  * there are X/Z bits anywhere in A or B, the result is X. Finally,
  * the result is 1.
  */
+bool vvp_cmp_eq::has_two_state() const
+{
+      return true;
+}
+
 void vvp_cmp_eq::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
                            vvp_context_t)
 {
       dispatch_operand_(ptr, bit);
 
+	/* Without X/Z bits, == is the same as ===. */
+      if (two_state_) {
+	    vvp_vector4_t res (1, op_a2_ == op_b2_? BIT4_1 : BIT4_0);
+	    ptr.ptr()->send_vec4(res, 0);
+	    return;
+      }
+
       if (op_a_.size() != op_b_.size()) {
-	    cerr << "COMPARISON size mismatch. "
-		 << "a=" << op_a_ << ", b=" << op_b_ << endl;
-	    assert(0);
+	    parallel_diag() << "COMPARISON size mismatch. "
+			    << "a=" << op_a_ << ", b=" << op_b_ << endl;
+	    parallel_diag_fatal();
+      }
+
+	/* If neither operand has X/Z bits, then == is the same as
+	   === and the words can be compared directly. */
+      if (! (op_a_.has_xz() || op_b_.has_xz())) {
+	    vvp_vector4_t res (1, op_a_.eeq(op_b_)? BIT4_1 : BIT4_0);
+	    ptr.ptr()->send_vec4(res, 0);
+	    return;
       }
 
       vvp_vector4_t res (1);
@@ -714,9 +841,9 @@ void vvp_cmp_eqx::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
       dispatch_operand_(ptr, bit);
 
       if (op_a_.size() != op_b_.size()) {
-	    cerr << "COMPARISON size mismatch. "
-		 << "a=" << op_a_ << ", b=" << op_b_ << endl;
-	    assert(0);
+	    parallel_diag() << "COMPARISON size mismatch. "
+			    << "a=" << op_a_ << ", b=" << op_b_ << endl;
+	    parallel_diag_fatal();
       }
 
       vvp_vector4_t res (1);
@@ -751,9 +878,9 @@ void vvp_cmp_eqz::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
       dispatch_operand_(ptr, bit);
 
       if (op_a_.size() != op_b_.size()) {
-	    cerr << "COMPARISON size mismatch. "
-		 << "a=" << op_a_ << ", b=" << op_b_ << endl;
-	    assert(0);
+	    parallel_diag() << "COMPARISON size mismatch. "
+			    << "a=" << op_a_ << ", b=" << op_b_ << endl;
+	    parallel_diag_fatal();
       }
 
       vvp_vector4_t res (1);
@@ -786,15 +913,33 @@ vvp_cmp_ne::vvp_cmp_ne(unsigned wid)
  * there are X/Z bits anywhere in A or B, the result is X. Finally,
  * the result is 0.
  */
+bool vvp_cmp_ne::has_two_state() const
+{
+      return true;
+}
+
 void vvp_cmp_ne::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
                            vvp_context_t)
 {
       dispatch_operand_(ptr, bit);
 
+      if (two_state_) {
+	    vvp_vector4_t res (1, op_a2_ == op_b2_? BIT4_0 : BIT4_1);
+	    ptr.ptr()->send_vec4(res, 0);
+	    return;
+      }
+
       if (op_a_.size() != op_b_.size()) {
-	    cerr << "internal error: vvp_cmp_ne: op_a_=" << op_a_
-		 << ", op_b_=" << op_b_ << endl;
-	    assert(op_a_.size() == op_b_.size());
+	    parallel_diag() << "internal error: vvp_cmp_ne: op_a_=" << op_a_
+			    << ", op_b_=" << op_b_ << endl;
+	    parallel_diag_fatal();
+      }
+
+	/* Without X/Z bits this is the same as !== (see above). */
+      if (! (op_a_.has_xz() || op_b_.has_xz())) {
+	    vvp_vector4_t res (1, op_a_.eeq(op_b_)? BIT4_0 : BIT4_1);
+	    ptr.ptr()->send_vec4(res, 0);
+	    return;
       }
 
       vvp_vector4_t res (1);
@@ -31,6 +31,12 @@
  * op_b_ operands. Most arithmetic operators expect the widths of the
  * inputs to match, and since only one input at a time changes, the
  * other will need to be initialized to X.
+ *
+ * Some functors also have a 2-state mode. When all the operands of
+ * such a functor come from 2-state signals (or other functors that
+ * produce 2-state values), compile_two_state_arith() switches it to
+ * that mode. The operands are then kept in op_a2_ and op_b2_, and the
+ * result is calculated without looking for X or Z bits.
  */
 class vvp_arith_  : public vvp_net_fun_t {
 
@@ -41,16 +47,27 @@ class vvp_arith_  : public vvp_net_fun_t {
 			unsigned base, unsigned wid, unsigned vwid,
                         vvp_context_t ctx);
 
+	// Return true if this functor has a 2-state mode.
+      virtual bool has_two_state() const;
+      void set_two_state() { two_state_ = true; }
+      bool is_two_state() const { return two_state_; }
+
+      bool parallel_safe(void) const;
+
     protected:
       void dispatch_operand_(vvp_net_ptr_t ptr, vvp_vector4_t bit);
 
     protected:
       unsigned wid_;
+      bool two_state_;
 
       vvp_vector4_t op_a_;
       vvp_vector4_t op_b_;
 	// Precalculated X result for propagation.
       vvp_vector4_t x_val_;
+	// The operands in 2-state mode.
+      vvp_vector2_t op_a2_;
+      vvp_vector2_t op_b2_;
 };
 
 class vvp_arith_abs : public vvp_net_fun_t {
@@ -152,6 +169,7 @@ class vvp_cmp_eeq  : public vvp_arith_ {
       explicit vvp_cmp_eeq(unsigned wid);
       void recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
                      vvp_context_t);
+      bool has_two_state() const;
 
 };
 
@@ -161,6 +179,7 @@ class vvp_cmp_nee  : public vvp_arith_ {
       explicit vvp_cmp_nee(unsigned wid);
       void recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
                      vvp_context_t);
+      bool has_two_state() const;
 
 };
 
@@ -170,6 +189,7 @@ class vvp_cmp_eq  : public vvp_arith_ {
       explicit vvp_cmp_eq(unsigned wid);
       void recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
                      vvp_context_t);
+      bool has_two_state() const;
 
 };
 
@@ -197,6 +217,7 @@ class vvp_cmp_ne  : public vvp_arith_ {
       explicit vvp_cmp_ne(unsigned wid);
       void recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
                      vvp_context_t);
+      bool has_two_state() const;
 
 };
 
@@ -249,6 +270,7 @@ class vvp_arith_mult  : public vvp_arith_ {
       ~vvp_arith_mult();
       void recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
                      vvp_context_t);
+      bool has_two_state() const;
     private:
       void wide_(vvp_net_ptr_t ptr);
 };
@@ -271,6 +293,7 @@ class vvp_arith_sub  : public vvp_arith_ {
       ~vvp_arith_sub();
       virtual void recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
                              vvp_context_t);
+      bool has_two_state() const;
 
 };
 
@@ -281,6 +304,7 @@ class vvp_arith_sum  : public vvp_arith_ {
       ~vvp_arith_sum();
       virtual void recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
                              vvp_context_t);
+      bool has_two_state() const;
 
 };
 
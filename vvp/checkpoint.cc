@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2026 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+# include  "config.h"
+# include  "checkpoint.h"
+# include  "compile.h"
+# include  "schedule.h"
+# include  "vpi_priv.h"
+# include  <string>
+# include  <vector>
+# include  <map>
+# include  <fstream>
+# include  <sstream>
+# include  <cstdio>
+# include  <cstdlib>
+# include  <cstring>
+# include  <cerrno>
+#if !defined(__MINGW32__)
+# include  <sys/types.h>
+# include  <sys/wait.h>
+# include  <fcntl.h>
+# include  <unistd.h>
+# define HAVE_CHECKPOINT 1
+#endif
+
+using namespace std;
+
+/*
+ * The plusargs for each run, in the order of the runs file. If there
+ * is no runs file, the checkpoint is restored exactly once with the
+ * plusargs unchanged.
+ */
+static vector< vector<string> > checkpoint_runs;
+static string checkpoint_runs_path;
+static unsigned checkpoint_jobs = 1;
+
+struct checkpoint_file_s {
+      FILE*fd;
+      string path;
+};
+static vector<checkpoint_file_s> checkpoint_files;
+
+bool checkpoint_supported(void)
+{
+#ifdef HAVE_CHECKPOINT
+      return true;
+#else
+      return false;
+#endif
+}
+
+bool checkpoint_load_runs(const char*path)
+{
+      ifstream file (path);
+      if (! file.is_open())
+	    return false;
+
+      checkpoint_runs_path = path;
+      checkpoint_runs.clear();
+
+      string line;
+      while (getline(file, line)) {
+	    istringstream words (line);
+	    vector<string> args;
+	    string word;
+	    while (words >> word)
+		  args.push_back(word);
+
+	    if (args.empty() || args[0][0] == '#')
+		  continue;
+	    checkpoint_runs.push_back(args);
+      }
+
+      return true;
+}
+
+void checkpoint_set_jobs(unsigned jobs)
+{
+      checkpoint_jobs = jobs > 0 ? jobs : 1;
+}
+
+void checkpoint_per_run_file(FILE*fd, const char*path)
+{
+      checkpoint_file_s cur;
+      cur.fd = fd;
+      cur.path = path;
+      checkpoint_files.push_back(cur);
+}
+
+#ifdef HAVE_CHECKPOINT
+/*
+ * This is called in a freshly restored process to give it the
+ * plusargs and the log file of its run.
+ */
+static void checkpoint_restore_(unsigned idx)
+{
+      if (checkpoint_runs.empty())
+	    return;
+
+      const vector<string>&run = checkpoint_runs[idx];
+
+      s_vpi_vlog_info info;
+      vpi_get_vlog_info(&info);
+
+	/* The design file stays first, then the plusargs of this run,
+	   then the plusargs from the command line. */
+      char**argv = new char*[info.argc + run.size() + 1];
+      int argc = 0;
+      argv[argc++] = info.argv[0];
+      for (size_t ndx = 0 ; ndx < run.size() ; ndx += 1)
+	    argv[argc++] = strdup(run[ndx].c_str());
+      for (int ndx = 1 ; ndx < info.argc ; ndx += 1)
+	    argv[argc++] = info.argv[ndx];
+      argv[argc] = 0;
+      vpip_set_vlog_args(argc, argv);
+
+      ostringstream log_path;
+      log_path << checkpoint_runs_path << "." << (idx+1) << ".log";
+      int fd = open(log_path.str().c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0666);
+      if (fd < 0) {
+	    perror(log_path.str().c_str());
+	    _exit(1);
+      }
+      dup2(fd, 1);
+      dup2(fd, 2);
+      close(fd);
+
+	/* freopen keeps the FILE object, so the pointers that the
+	   rest of vvp holds stay good. */
+      for (size_t ndx = 0 ; ndx < checkpoint_files.size() ; ndx += 1) {
+	    ostringstream path;
+	    path << checkpoint_files[ndx].path << "." << (idx+1);
+	    if (freopen(path.str().c_str(), "w", checkpoint_files[ndx].fd) == 0) {
+		  perror(path.str().c_str());
+		  _exit(1);
+	    }
+      }
+}
+
+/*
+ * Wait for any of the restored processes to finish. Return its pid
+ * and its exit status (1 if it was killed) through rc.
+ */
+static pid_t checkpoint_wait_(int&rc)
+{
+      int status;
+      pid_t pid;
+      while ((pid = waitpid(-1, &status, 0)) < 0) {
+	    if (errno != EINTR) {
+		  perror("vvp checkpoint: waitpid");
+		  rc = 1;
+		  return pid;
+	    }
+      }
+
+      if (WIFEXITED(status))
+	    rc = WEXITSTATUS(status);
+      else
+	    rc = 1;
+      return pid;
+}
+#endif
+
+void checkpoint_take(void)
+{
+#ifdef HAVE_CHECKPOINT
+      if (verbose_flag) {
+	    vpi_mcd_printf(1, " ...checkpoint at time %" TIME_FMT_U "\n",
+			   schedule_simtime());
+      }
+
+      unsigned nruns = checkpoint_runs.size();
+      if (nruns == 0)
+	    nruns = 1;
+
+	/* This is the snapshot. It forks a process for each run, and
+	   does not touch the simulation state so that it stays ready
+	   to be restored again. */
+      map<pid_t,unsigned> running;
+      unsigned next = 0;
+      int rc = 0;
+      while (next < nruns || ! running.empty()) {
+	    if (next < nruns && running.size() < checkpoint_jobs) {
+		    /* Anything still buffered (including $fopen files
+		       and the log file) would otherwise be written by
+		       the snapshot and again by every restored process. */
+		  fflush(0);
+
+		  pid_t pid = fork();
+		  if (pid == 0) {
+			checkpoint_restore_(next);
+			return;
+		  }
+
+		  if (pid < 0) {
+			perror("vvp checkpoint: fork");
+			  /* If nothing was restored yet, simply go on
+			     with the simulation in this process. */
+			if (next == 0)
+			      return;
+			rc = 1;
+			nruns = next;
+			continue;
+		  }
+
+		  running[pid] = next;
+		  next += 1;
+		  continue;
+	    }
+
+	    int run_rc;
+	    pid_t pid = checkpoint_wait_(run_rc);
+	    if (pid < 0)
+		  break;
+
+	    map<pid_t,unsigned>::iterator cur = running.find(pid);
+	    if (cur == running.end())
+		  continue;
+
+	    if (run_rc != 0 && ! checkpoint_runs.empty()) {
+		  fprintf(stderr, "vvp: run %u exited with status %d\n",
+			  cur->second+1, run_rc);
+	    }
+	    if (run_rc > rc)
+		  rc = run_rc;
+	    running.erase(cur);
+      }
+
+      fflush(0);
+      _exit(rc);
+#endif
+}
@@ -0,0 +1,65 @@
+#ifndef IVL_checkpoint_H
+#define IVL_checkpoint_H
+/*
+ * Copyright (c) 2026 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+# include  <cstdio>
+
+/*
+ * A checkpoint is an in-memory snapshot of the complete simulation
+ * state. It is taken by forking the vvp process: the child continues
+ * the simulation, and the parent keeps the untouched state (sharing
+ * the unmodified pages with the child) so that it can be restored by
+ * forking again.
+ *
+ * The checkpoint_take() function is called by the scheduler between
+ * time steps. It returns in the process that is to continue the
+ * simulation. The snapshot process itself never returns from this
+ * function; it exits with the highest exit status of the restored
+ * runs.
+ *
+ * The checkpoint_supported() function returns false if the platform
+ * does not have fork(). In that case checkpoint_take() does nothing
+ * and the simulation simply continues.
+ */
+extern bool checkpoint_supported(void);
+extern void checkpoint_take(void);
+
+/*
+ * Restore the checkpoint once for each line of the given file instead
+ * of only once. Each line holds the extra plusargs for one run; they
+ * are put in front of the plusargs from the command line, so they
+ * take precedence. Blank lines and lines that start with '#' are
+ * skipped. The output of run N (counting from 1) goes to the file
+ * "<path>.N.log". At most "jobs" runs are active at the same time.
+ *
+ * checkpoint_load_runs returns false if the file cannot be read.
+ */
+extern bool checkpoint_load_runs(const char*path);
+extern void checkpoint_set_jobs(unsigned jobs);
+
+/*
+ * Register an output file that each run of the runs file needs a
+ * copy of (i.e. the log file or the profile). The restored process
+ * of run N reopens the file as "<path>.N", so that the runs do not
+ * write over each other.
+ */
+extern void checkpoint_per_run_file(FILE*fd, const char*path);
+
+#endif /* IVL_checkpoint_H */
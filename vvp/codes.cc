@@ -96,6 +96,67 @@ vvp_code_t codespace_null(void)
       return first_chunk + 0;
 }
 
+/*
+ * Try to fuse the instruction sequence that starts at cp. The lim is
+ * the number of instructions available after cp in the current chunk,
+ * so a sequence is never fused across a chunk link.
+ */
+static bool codespace_fuse_at(vvp_code_t cp, unsigned lim)
+{
+      if (cp[0].opcode != &of_LOAD_VEC4)
+	    return false;
+      if (lim < 2 || cp[1].opcode != &of_CMPIE)
+	    return false;
+
+      if (lim >= 3 && cp[2].opcode == &of_JMP0XZ) {
+	    cp[0].opcode = &of_LOAD_CMPIE_JMP0XZ;
+      } else if (lim >= 3 && cp[2].opcode == &of_JMP1XZ) {
+	    cp[0].opcode = &of_LOAD_CMPIE_JMP1XZ;
+      } else {
+	    cp[0].opcode = &of_LOAD_CMPIE;
+      }
+
+      return true;
+}
+
+void codespace_fuse(void)
+{
+      vvp_code_t chunk = first_chunk;
+      while (chunk) {
+	    unsigned used = code_chunk_size-1;
+	    if (chunk == current_chunk)
+		  used = current_within_chunk;
+
+	      /* Address 0 of the first chunk is the ZOMBIE
+		 instruction, which is never part of a sequence. */
+	    for (unsigned idx = 0 ; idx < used ; idx += 1) {
+		  if (codespace_fuse_at(chunk+idx, used-idx))
+			count_opcodes_fused += 1;
+	    }
+
+	    if (chunk == current_chunk)
+		  break;
+	    chunk = chunk[code_chunk_size-1].cptr;
+      }
+}
+
+void codespace_for_each(void (*fun)(vvp_code_t, void*), void*cd)
+{
+      vvp_code_t chunk = first_chunk;
+      while (chunk) {
+	    unsigned used = code_chunk_size-1;
+	    if (chunk == current_chunk)
+		  used = current_within_chunk;
+
+	    for (unsigned idx = 0 ; idx < used ; idx += 1)
+		  fun(chunk+idx, cd);
+
+	    if (chunk == current_chunk)
+		  break;
+	    chunk = chunk[code_chunk_size-1].cptr;
+      }
+}
+
 #ifdef CHECK_WITH_VALGRIND
 void codespace_delete(void)
 {
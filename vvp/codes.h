@@ -260,6 +260,17 @@ extern bool of_REAP_UFUNC(vthread_t thr, vvp_code_t code);
 
 extern bool of_CHUNK_LINK(vthread_t thr, vvp_code_t code);
 
+/*
+ * These are superinstructions that codespace_fuse() substitutes for
+ * the first instruction of common instruction sequences. They take
+ * their operands from the original instructions, which are left in
+ * place after the first, so jumps into the middle of a sequence still
+ * work.
+ */
+extern bool of_LOAD_CMPIE(vthread_t thr, vvp_code_t code);
+extern bool of_LOAD_CMPIE_JMP0XZ(vthread_t thr, vvp_code_t code);
+extern bool of_LOAD_CMPIE_JMP1XZ(vthread_t thr, vvp_code_t code);
+
 /*
  * This is the format of a machine code instruction.
  */
@@ -302,4 +313,23 @@ extern vvp_code_t codespace_allocate(void);
 extern vvp_code_t codespace_next(void);
 extern vvp_code_t codespace_null(void);
 
+/*
+ * Scan the code space for common instruction sequences and replace
+ * them with superinstructions. This must be called after all the code
+ * pointers and net references in the instructions are resolved.
+ */
+extern void codespace_fuse(void);
+
+/*
+ * Call the function for every instruction that has been allocated in
+ * the code space, skipping the links between chunks.
+ */
+extern void codespace_for_each(void (*fun)(vvp_code_t, void*), void*cd);
+
+/*
+ * Return the mnemonic for the opcode implementation. This is for
+ * reports (the profiler) and is slow.
+ */
+extern const char* compile_opcode_name(vvp_code_fun opcode);
+
 #endif /* IVL_codes_H */
@@ -34,6 +34,7 @@
 # include  "schedule.h"
 # include  <iostream>
 # include  <list>
+# include  <set>
 # include  <cstdlib>
 # include  <cstring>
 # include  <cassert>
@@ -306,6 +307,30 @@ static const struct opcode_table_s opcode_table[] = {
 static const unsigned opcode_count =
                     sizeof(opcode_table)/sizeof(*opcode_table) - 1;
 
+/*
+ * Get the mnemonic of an opcode implementation, for reports. The
+ * superinstructions are not in the opcode table since they never
+ * appear in the source; they are named by the sequence they replace.
+ */
+const char* compile_opcode_name(vvp_code_fun opcode)
+{
+      for (unsigned idx = 0 ;  idx < opcode_count ;  idx += 1) {
+	    if (opcode_table[idx].opcode == opcode)
+		  return opcode_table[idx].mnemonic;
+      }
+
+      if (opcode == &of_LOAD_CMPIE)
+	    return "%load/vec4+%cmpi/e";
+      if (opcode == &of_LOAD_CMPIE_JMP0XZ)
+	    return "%load/vec4+%cmpi/e+%jmp/0xz";
+      if (opcode == &of_LOAD_CMPIE_JMP1XZ)
+	    return "%load/vec4+%cmpi/e+%jmp/1xz";
+      if (opcode == &of_CHUNK_LINK)
+	    return "(chunk link)";
+
+      return "(unknown)";
+}
+
 static int opcode_compare(const void*k, const void*r)
 {
       const char*kp = (const char*)k;
@@ -512,12 +537,27 @@ struct functor_gen_resolv_list_s: public resolv_list_s {
       virtual bool resolve(bool mes);
 };
 
+static std::set<vvp_net_t*>*functor_refs = 0;
+
+void functor_refs_track(void)
+{
+      if (functor_refs == 0)
+	    functor_refs = new std::set<vvp_net_t*>;
+}
+
+bool functor_refs_find(vvp_net_t*net)
+{
+      return functor_refs && functor_refs->find(net) != functor_refs->end();
+}
+
 bool functor_gen_resolv_list_s::resolve(bool mes)
 {
       vvp_net_t*tmp = vvp_net_lookup(label());
 
       if (tmp) {
 	    *ref = tmp;
+	    if (functor_refs)
+		  functor_refs->insert(tmp);
 	    return true;
       }
 
@@ -760,6 +800,16 @@ void compile_cleanup(void)
 
       compile_errors += nerrs;
 
+	/* With all the code pointers resolved, look for instruction
+	   sequences that can be replaced with superinstructions. */
+      if (nerrs == 0)
+	    codespace_fuse();
+
+	/* With all the functors linked, find the arithmetic that only
+	   sees 2-state values. */
+      if (nerrs == 0)
+	    compile_two_state_arith();
+
       if (verbose_flag) {
 	    fprintf(stderr, " ... Removing symbol tables\n");
 	    fflush(stderr);
@@ -1026,6 +1076,7 @@ void compile_arith_cast_vec2(char*label, long width,
 
       vvp_net_t* ptr = new vvp_net_t;
       ptr->fun = arith;
+      compile_two_state_source(ptr);
 
       define_functor_symbol(label, ptr);
       free(label);
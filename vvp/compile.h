@@ -48,6 +48,21 @@ extern void compile_init(void);
 
 extern void compile_cleanup(void);
 
+/*
+ * Simplify the functor netlist after compile_cleanup and before the
+ * simulation starts. This is enabled by the -O flag.
+ */
+extern void optimize_netlist(void);
+
+/*
+ * The nets of 2-state signals are passed to compile_two_state_source
+ * as they are compiled. compile_two_state_arith is called when the
+ * netlist is complete, and switches the arithmetic functors that are
+ * fed only by 2-state values to their 2-state mode (see arith.h).
+ */
+extern void compile_two_state_source(vvp_net_t*net);
+extern void compile_two_state_arith(void);
+
 extern bool verbose_flag;
 
 /*
@@ -338,6 +353,16 @@ class resolv_list_s {
  */
 extern void functor_ref_lookup(vvp_net_t**ref, char*lab);
 
+/*
+ * The nets that functor_ref_lookup finds are used by instructions,
+ * VPI part selects and function ports, outside the fan-out lists.
+ * After functor_refs_track() is called, those nets are remembered,
+ * and functor_refs_find() tells if a net is one of them. The netlist
+ * optimizer uses this to leave such nets alone.
+ */
+extern void functor_refs_track(void);
+extern bool functor_refs_find(vvp_net_t*net);
+
 /*
  * This function schedules a lookup of the labeled instruction. The
  * code points to a code structure that points to the instruction
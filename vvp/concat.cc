@@ -19,6 +19,7 @@
 
 # include  "compile.h"
 # include  "vvp_net.h"
+# include  "parallel.h"
 # include  <cstdlib>
 # include  <iostream>
 # include  <cassert>
@@ -47,10 +48,10 @@ void vvp_fun_concat::recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
       unsigned pdx = port.port();
 
       if (bit.size() != wid_[pdx]) {
-	    cerr << "internal error: port " << pdx
-		 << " expects wid=" << wid_[pdx]
-		 << ", got wid=" << bit.size() << endl;
-	    assert(0);
+	    parallel_diag() << "internal error: port " << pdx
+			    << " expects wid=" << wid_[pdx]
+			    << ", got wid=" << bit.size() << endl;
+	    parallel_diag_fatal();
       }
 
       unsigned off = 0;
@@ -73,10 +74,10 @@ void vvp_fun_concat::recv_vec4_pv(vvp_net_ptr_t port, const vvp_vector4_t&bit,
       unsigned pdx = port.port();
 
       if (vwid != wid_[pdx]) {
-	    cerr << "internal error: port " << pdx
-		 << " expects wid=" << wid_[pdx]
-		 << ", got wid=" << vwid << endl;
-	    assert(0);
+	    parallel_diag() << "internal error: port " << pdx
+			    << " expects wid=" << wid_[pdx]
+			    << ", got wid=" << vwid << endl;
+	    parallel_diag_fatal();
       }
 
       unsigned off = 0;
@@ -94,6 +95,11 @@ void vvp_fun_concat::recv_vec4_pv(vvp_net_ptr_t port, const vvp_vector4_t&bit,
       port.ptr()->send_vec4(val_, 0);
 }
 
+bool vvp_fun_concat::parallel_safe(void) const
+{
+      return true;
+}
+
 void compile_concat(char*label, unsigned w0, unsigned w1,
 		    unsigned w2, unsigned w3,
 		    unsigned argc, struct symb_s*argv)
@@ -237,6 +243,11 @@ void vvp_fun_repeat::recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
       port.ptr()->send_vec4(val, 0);
 }
 
+bool vvp_fun_repeat::parallel_safe(void) const
+{
+      return true;
+}
+
 void compile_repeat(char*label, long width, long repeat, struct symb_s arg)
 {
       vvp_fun_repeat*fun = new vvp_fun_repeat(width, repeat);
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2026 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * This module is used with batch.vvp. It implements $watch_batch,
+ * which puts all its arguments in one batched value change callback
+ * and prints the name and binary value of each changed object.
+ */
+
+# include  "vpi_user.h"
+# include  <stdio.h>
+
+static PLI_INT32 batch_changed(p_cb_data cb)
+{
+      p_cb_batch_data data = (p_cb_batch_data)cb;
+      PLI_INT32 idx;
+
+      for (idx = 0 ; idx < data->count ; idx += 1) {
+	    printf("%s%s=%s", idx? " " : "",
+		   vpi_get_str(vpiName, data->objs[idx]),
+		   data->values[idx].value.str);
+      }
+      printf("\n");
+      return 0;
+}
+
+static PLI_INT32 watch_batch_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
+{
+      vpiHandle callh = vpi_handle(vpiSysTfCall, 0);
+      vpiHandle argv = vpi_iterate(vpiArgument, callh);
+      vpiHandle arg;
+      s_vpi_time time;
+      s_vpi_value value;
+      s_cb_data cb;
+      (void)name;  /* Parameter is not used. */
+
+      time.type = vpiSuppressTime;
+      value.format = vpiBinStrVal;
+      cb.reason = _cbValueChangeBatch;
+      cb.cb_rtn = batch_changed;
+      cb.time = &time;
+      cb.value = &value;
+      cb.user_data = 0;
+
+      if (argv == 0)
+	    return 0;
+
+      while ((arg = vpi_scan(argv))) {
+	    cb.obj = arg;
+	    vpi_register_cb(&cb);
+      }
+      return 0;
+}
+
+static void batch_register(void)
+{
+      s_vpi_systf_data tf_data;
+
+      tf_data.type      = vpiSysTask;
+      tf_data.tfname    = "$watch_batch";
+      tf_data.calltf    = watch_batch_calltf;
+      tf_data.compiletf = 0;
+      tf_data.sizetf    = 0;
+      tf_data.user_data = 0;
+      vpi_register_systf(&tf_data);
+}
+
+void (*vlog_startup_routines[])(void) = {
+      batch_register,
+      0
+};
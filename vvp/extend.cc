@@ -58,3 +58,8 @@ void vvp_fun_extend_signed::recv_vec4_pv(vvp_net_ptr_t ptr, const vvp_vector4_t&
 {
       recv_vec4_pv_(ptr, bit, base, wid, vwid, ctx);
 }
+
+bool vvp_fun_extend_signed::parallel_safe(void) const
+{
+      return true;
+}
@@ -74,6 +74,16 @@ void vvp_fun_boolean_::recv_vec4_pv(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
       }
 }
 
+bool vvp_fun_boolean_::parallel_safe(void) const
+{
+      return true;
+}
+
+vvp_net_t* vvp_fun_boolean_::parallel_net(void)
+{
+      return net_;
+}
+
 vvp_fun_and::vvp_fun_and(unsigned wid, bool invert)
 : vvp_fun_boolean_(wid), invert_(invert)
 {
@@ -173,6 +183,16 @@ void vvp_fun_buf::run_run()
       ptr->send_vec4(tmp, 0);
 }
 
+bool vvp_fun_buf::parallel_safe(void) const
+{
+      return true;
+}
+
+vvp_net_t* vvp_fun_buf::parallel_net(void)
+{
+      return net_;
+}
+
 vvp_fun_bufz::vvp_fun_bufz()
 {
       count_functors_logic += 1;
@@ -437,6 +457,16 @@ void vvp_fun_muxz::run_run()
       }
 }
 
+bool vvp_fun_muxz::parallel_safe(void) const
+{
+      return true;
+}
+
+vvp_net_t* vvp_fun_muxz::parallel_net(void)
+{
+      return net_;
+}
+
 vvp_fun_not::vvp_fun_not(unsigned wid)
 : input_(wid, BIT4_Z)
 {
@@ -498,6 +528,16 @@ void vvp_fun_not::run_run()
       ptr->send_vec4(result, 0);
 }
 
+bool vvp_fun_not::parallel_safe(void) const
+{
+      return true;
+}
+
+vvp_net_t* vvp_fun_not::parallel_net(void)
+{
+      return net_;
+}
+
 vvp_fun_or::vvp_fun_or(unsigned wid, bool invert)
 : vvp_fun_boolean_(wid), invert_(invert)
 {
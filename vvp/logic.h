@@ -38,6 +38,11 @@ class vvp_fun_boolean_ : public vvp_net_fun_t, protected vvp_gen_event_s {
 			unsigned base, unsigned wid, unsigned vwid,
                         vvp_context_t);
 
+      bool parallel_safe(void) const;
+
+    protected:
+      vvp_net_t* parallel_net(void);
+
     protected:
       vvp_vector4_t input_[4];
       vvp_net_t*net_;
@@ -72,8 +77,11 @@ class vvp_fun_buf: public vvp_net_fun_t, private vvp_gen_event_s {
 			unsigned base, unsigned wid, unsigned vwid,
                         vvp_context_t);
 
+      bool parallel_safe(void) const;
+
     private:
       void run_run();
+      vvp_net_t* parallel_net(void);
 
     private:
       vvp_vector4_t input_;
@@ -138,8 +146,11 @@ class vvp_fun_muxz : public vvp_net_fun_t, private vvp_gen_event_s {
 			unsigned base, unsigned wid, unsigned vwid,
                         vvp_context_t);
 
+      bool parallel_safe(void) const;
+
     private:
       void run_run();
+      vvp_net_t* parallel_net(void);
 
     private:
       vvp_vector4_t a_;
@@ -182,8 +193,11 @@ class vvp_fun_not: public vvp_net_fun_t, private vvp_gen_event_s {
 			unsigned base, unsigned wid, unsigned vwid,
                         vvp_context_t);
 
+      bool parallel_safe(void) const;
+
     private:
       void run_run();
+      vvp_net_t* parallel_net(void);
 
     private:
       vvp_vector4_t input_;
@@ -23,6 +23,9 @@
 # include  "parse_misc.h"
 # include  "compile.h"
 # include  "schedule.h"
+# include  "checkpoint.h"
+# include  "parallel.h"
+# include  "profile.h"
 # include  "vpi_priv.h"
 # include  "statistics.h"
 # include  "vvp_cleanup.h"
@@ -58,6 +61,10 @@ extern "C" const char*optarg;
 
 bool verbose_flag = false;
 bool version_flag = false;
+bool optimize_flag = false;
+static bool checkpoint_flag = false;
+static bool checkpoint_runs_flag = false;
+static unsigned parallel_threads = 1;
 static int vvp_return_value = 0;
 
 void vpip_set_return_value(int value)
@@ -315,26 +322,63 @@ int main(int argc, char*argv[])
         /* For non-interactive runs we do not want to run the interactive
          * debugger, so make $stop just execute a $finish. */
       stop_is_finish = false;
-      while ((opt = getopt(argc, argv, "+hil:M:m:nNsvV")) != EOF) switch (opt) {
+      while ((opt = getopt(argc, argv, "+c:F:hij:l:M:m:nNOp:st:vV")) != EOF) switch (opt) {
+	  case 'c':
+	    if (!checkpoint_supported()) {
+		  fprintf(stderr, "%s: -c is not supported on this "
+			  "platform.\n", argv[0]);
+		  flag_errors += 1;
+		  break;
+	    }
+	    schedule_checkpoint(strtoull(optarg, 0, 0));
+	    checkpoint_flag = true;
+	    break;
+	  case 'F':
+	    if (!checkpoint_supported()) {
+		  fprintf(stderr, "%s: -F is not supported on this "
+			  "platform.\n", argv[0]);
+		  flag_errors += 1;
+		  break;
+	    }
+	    if (!checkpoint_load_runs(optarg)) {
+		  fprintf(stderr, "%s: Unable to read runs file %s.\n",
+			  argv[0], optarg);
+		  flag_errors += 1;
+		  break;
+	    }
+	      /* Without -c, the runs fork before the first time step. */
+	    if (!checkpoint_flag)
+		  schedule_checkpoint(0);
+	    checkpoint_runs_flag = true;
+	    break;
          case 'h':
            fprintf(stderr,
                    "Usage: vvp [options] input-file [+plusargs...]\n"
                    "Options:\n"
+                   " -c time        Checkpoint the simulation at this time (with -F).\n"
+                   " -F file        Restore the checkpoint once per line of plusargs.\n"
                    " -h             Print this help message.\n"
                    " -i             Interactive mode (unbuffered stdio).\n"
+                   " -j jobs        Number of checkpoint runs (-F) to run at once.\n"
                    " -l file        Logfile, '-' for <stderr>\n"
                    " -M path        VPI module directory\n"
 		   " -M -           Clear VPI module path\n"
                    " -m module      Load vpi module.\n"
 		   " -n             Non-interactive ($stop = $finish).\n"
                    " -N             Same as -n, but exit code is 1 instead of 0\n"
+                   " -O             Optimize the netlist before running.\n"
+                   " -p file        Write a run time profile to this file.\n"
 		   " -s             $stop right away.\n"
+		   " -t threads     Evaluate independent net partitions on this many threads.\n"
                    " -v             Verbose progress messages.\n"
                    " -V             Print the version information.\n" );
            exit(0);
 	  case 'i':
 	    setvbuf(stdout, 0, _IONBF, 0);
 	    break;
+	  case 'j':
+	    checkpoint_set_jobs(strtoul(optarg, 0, 0));
+	    break;
 	  case 'l':
 	    logfile_name = optarg;
 	    break;
@@ -356,9 +400,27 @@ int main(int argc, char*argv[])
             stop_is_finish = true;
             stop_is_finish_exit_code = 1;
             break;
+	  case 'O':
+	    optimize_flag = true;
+	    break;
+	  case 'p':
+	    if (!profile_open(optarg)) {
+		  perror(optarg);
+		  flag_errors += 1;
+	    }
+	    break;
 	  case 's':
 	    schedule_stop(0);
 	    break;
+	  case 't':
+	    if (!parallel_supported()) {
+		  fprintf(stderr, "%s: -t is not supported on this "
+			  "platform.\n", argv[0]);
+		  flag_errors += 1;
+		  break;
+	    }
+	    parallel_threads = strtoul(optarg, 0, 0);
+	    break;
 	  case 'v':
 	    verbose_flag = true;
 	    break;
@@ -369,6 +431,13 @@ int main(int argc, char*argv[])
 	    flag_errors += 1;
       }
 
+	/* The worker threads do not survive the fork of a checkpoint
+	   run, so the two cannot be used together. */
+      if (parallel_threads > 1 && (checkpoint_flag || checkpoint_runs_flag)) {
+	    fprintf(stderr, "%s: -t cannot be used with -c or -F.\n", argv[0]);
+	    flag_errors += 1;
+      }
+
       if (flag_errors)
 	    return flag_errors;
 
@@ -422,6 +491,7 @@ int main(int argc, char*argv[])
 		        exit(1);
 		  }
 		  setvbuf(logfile, log_buffer, _IOLBF, sizeof(log_buffer));
+		  checkpoint_per_run_file(logfile, logfile_name);
 	    }
       }
 
@@ -439,6 +509,11 @@ int main(int argc, char*argv[])
 
       compile_init();
 
+	/* The optimizer needs to know which nets are referenced
+	   outside the fan-out lists. */
+      if (optimize_flag)
+	    functor_refs_track();
+
       for (unsigned idx = 0 ;  idx < module_cnt ;  idx += 1)
 	    vpip_load_module(module_tab[idx]);
 
@@ -466,6 +541,12 @@ int main(int argc, char*argv[])
 	    return compile_errors;
       }
 
+      if (optimize_flag) {
+	    if (verbose_flag)
+		  vpi_mcd_printf(1, "Optimizing netlist...\n");
+	    optimize_netlist();
+      }
+
       if (verbose_flag) {
 	    vpi_mcd_printf(1, " ... %8lu functors (net_fun pool=%zu bytes)\n",
 			   count_functors, vvp_net_fun_t::heap_total());
@@ -473,13 +554,26 @@ int main(int argc, char*argv[])
 	    vpi_mcd_printf(1, "           %8lu bufif\n",  count_functors_bufif);
 	    vpi_mcd_printf(1, "           %8lu resolv\n",count_functors_resolv);
 	    vpi_mcd_printf(1, "           %8lu signals\n", count_functors_sig);
+	    vpi_mcd_printf(1, "           %8lu 2-state arith\n",
+			   count_functors_two_state);
+	    if (optimize_flag) {
+		  vpi_mcd_printf(1, "           %8lu fused\n",
+				 count_functors_fused);
+		  vpi_mcd_printf(1, "           %8lu removed\n",
+				 count_functors_removed);
+	    }
 	    vpi_mcd_printf(1, " ... %8lu filters (net_fil pool=%zu bytes)\n",
 			   count_filters, vvp_net_fil_t::heap_total());
 	    vpi_mcd_printf(1, " ... %8lu opcodes (%zu bytes)\n",
 	                   count_opcodes, size_opcodes);
+	    vpi_mcd_printf(1, "           %8lu fused\n", count_opcodes_fused);
 	    vpi_mcd_printf(1, " ... %8lu nets\n",     count_vpi_nets);
 	    vpi_mcd_printf(1, " ... %8lu vvp_nets (%zu bytes)\n",
 			   count_vvp_nets, size_vvp_nets);
+	    unsigned long largest_partition;
+	    unsigned long partitions = count_net_partitions(largest_partition);
+	    vpi_mcd_printf(1, "           %8lu partitions (largest %lu vvp_nets)\n",
+			   partitions, largest_partition);
 	    vpi_mcd_printf(1, " ... %8lu arrays (%lu words)\n",
 			   count_net_arrays, count_net_array_words);
 	    vpi_mcd_printf(1, " ... %8lu memories\n",
@@ -491,6 +585,13 @@ int main(int argc, char*argv[])
 	    vpi_mcd_printf(1, " ... %8lu scopes\n",   count_vpi_scopes);
       }
 
+      if (!parallel_start(parallel_threads)) {
+	    vpi_mcd_printf(1, "%s: Unable to start %u threads for -t.\n",
+			   argv[0], parallel_threads);
+	    final_cleanup();
+	    return 1;
+      }
+
       if (verbose_flag) {
 	    my_getrusage(cycles+1);
 	    print_rusage(cycles+1, cycles+0);
@@ -500,6 +601,8 @@ int main(int argc, char*argv[])
 
       schedule_simulate();
 
+      profile_report();
+
       if (verbose_flag) {
 	    my_getrusage(cycles+2);
 	    print_rusage(cycles+2, cycles+1);
@@ -523,6 +626,11 @@ int main(int argc, char*argv[])
 			   count_assign_arword_pool());
 	    vpi_mcd_printf(1, "    %8lu other events (pool=%lu)\n",
 			   count_gen_events, count_gen_pool());
+	    vpi_mcd_printf(1, "    %8lu vec4 word allocations (%lu reused)\n",
+			   count_vec4_word_allocs, count_vec4_word_reuse);
+	    if (parallel_enabled())
+		  vpi_mcd_printf(1, "    %8lu parallel events (%lu batches)\n",
+				 count_parallel_events, count_parallel_batches);
       }
 
       final_cleanup();
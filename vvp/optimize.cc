@@ -0,0 +1,278 @@
+/*
+ * Copyright (c) 2026 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+# include  "compile.h"
+# include  "codes.h"
+# include  "statistics.h"
+# include  "vvp_net.h"
+# include  "arith.h"
+# include  "logic.h"
+# include  "part.h"
+# include  <map>
+# include  <set>
+# include  <vector>
+# include  <typeinfo>
+# include  <cassert>
+
+/*
+ * The netlist optimizer runs (when enabled with -O) after the design
+ * is compiled and cleaned up, and before the simulation starts. It
+ * rewrites the functor graph in place:
+ *
+ *   - Concatenations of statically allocated part selects that all
+ *     select from the same vector are replaced with a single
+ *     vvp_fun_part_concat functor connected directly to the vector.
+ *
+ *   - Pure combinational functors whose output goes nowhere are
+ *     disconnected from their drivers, so values are no longer
+ *     propagated to them. This is repeated until no more functors
+ *     become dead.
+ *
+ * A vvp_net_t that is referenced by an instruction (for example by
+ * %force/link or %cassign/link) may get new fan-out at run time, and
+ * one that a VPI part select or function port refers to is read
+ * directly, so those nets are never touched. Nets with a filter are
+ * signals and are visible to VPI, so they are also left alone.
+ */
+
+struct net_drivers_s {
+      net_drivers_s() { drv[0] = drv[1] = drv[2] = drv[3] = 0; }
+      vvp_net_t*drv[4];
+};
+
+struct net_optimize_s {
+	// The net that drives each input port. A port can only be in
+	// one fan-out list, so there is at most one driver.
+      std::map<vvp_net_t*,net_drivers_s> drivers;
+	// Nets that the instructions refer to.
+      std::set<vvp_net_t*> code_refs;
+
+      vvp_net_t*driver(vvp_net_t*net, unsigned port);
+      bool is_fixed(vvp_net_t*net) const;
+      unsigned fanout_count(vvp_net_t*net) const;
+};
+
+vvp_net_t* net_optimize_s::driver(vvp_net_t*net, unsigned port)
+{
+      std::map<vvp_net_t*,net_drivers_s>::iterator cur = drivers.find(net);
+      if (cur == drivers.end())
+	    return 0;
+      return cur->second.drv[port];
+}
+
+bool net_optimize_s::is_fixed(vvp_net_t*net) const
+{
+      return net->fil != 0 || code_refs.find(net) != code_refs.end()
+	    || functor_refs_find(net);
+}
+
+unsigned net_optimize_s::fanout_count(vvp_net_t*net) const
+{
+      unsigned count = 0;
+      vvp_net_ptr_t cur = net->fanout();
+      while (vvp_net_t*ptr = cur.ptr()) {
+	    count += 1;
+	    cur = ptr->port[cur.port()];
+      }
+      return count;
+}
+
+static void collect_drivers(vvp_net_t*net, void*cd)
+{
+      net_optimize_s*opt = static_cast<net_optimize_s*>(cd);
+
+      vvp_net_ptr_t cur = net->fanout();
+      while (vvp_net_t*ptr = cur.ptr()) {
+	    opt->drivers[ptr].drv[cur.port()] = net;
+	    cur = ptr->port[cur.port()];
+      }
+}
+
+static void collect_code_refs(vvp_code_t cp, void*cd)
+{
+      net_optimize_s*opt = static_cast<net_optimize_s*>(cd);
+
+	/* The operands are untyped unions, so any operand that might
+	   be a net pointer is taken as a reference. A false match only
+	   makes the optimizer more conservative. */
+      if (cp->net) opt->code_refs.insert(cp->net);
+      if (cp->net2) opt->code_refs.insert(cp->net2);
+}
+
+/*
+ * Replace a .concat whose inputs are all part selects of the same
+ * source with a vvp_fun_part_concat. The concat net keeps its fan-out
+ * and is linked to the source in place of the part selects, which are
+ * then left unconnected.
+ */
+static bool fuse_part_concat(net_optimize_s&opt, vvp_net_t*net)
+{
+      vvp_fun_concat*cat = dynamic_cast<vvp_fun_concat*>(net->fun);
+      if (cat == 0 || typeid(*cat) != typeid(vvp_fun_concat))
+	    return false;
+      if (opt.is_fixed(net))
+	    return false;
+
+      vvp_net_t*src = 0;
+      vvp_net_t*parts[4];
+      unsigned base[4], wid[4];
+      unsigned nparts = 0;
+
+      for (unsigned idx = 0 ;  idx < 4 ;  idx += 1) {
+	    vvp_net_t*drv = opt.driver(net, idx);
+	    if (cat->port_width(idx) == 0) {
+		  if (drv != 0) return false;
+		  continue;
+	    }
+
+	    if (drv == 0 || opt.is_fixed(drv))
+		  return false;
+	    vvp_fun_part_sa*part = dynamic_cast<vvp_fun_part_sa*>(drv->fun);
+	    if (part == 0 || part->width() != cat->port_width(idx))
+		  return false;
+	    if (opt.fanout_count(drv) != 1)
+		  return false;
+
+	    vvp_net_t*drv_src = opt.driver(drv, 0);
+	    if (drv_src == 0 || (src != 0 && drv_src != src))
+		  return false;
+	    src = drv_src;
+
+	    parts[nparts] = drv;
+	    base[nparts] = part->base();
+	    wid[nparts] = part->width();
+	    nparts += 1;
+      }
+
+      if (nparts == 0)
+	    return false;
+
+	/* Ports of the concat with no width are skipped, so the parts
+	   are packed in port order, which is also bit order. */
+      for (unsigned idx = 0 ;  idx < 4 ;  idx += 1) {
+	    if (opt.driver(net, idx))
+		  opt.driver(net, idx)->unlink(vvp_net_ptr_t(net, idx));
+	    opt.drivers[net].drv[idx] = 0;
+      }
+
+      for (unsigned idx = 0 ;  idx < nparts ;  idx += 1) {
+	    src->unlink(vvp_net_ptr_t(parts[idx], 0));
+	    opt.drivers[parts[idx]].drv[0] = 0;
+      }
+
+	/* Functors are allocated from a heap that is never given
+	   back, so the storage of the replaced concat stays, but its
+	   value is released. */
+      cat->~vvp_fun_concat();
+      net->fun = new vvp_fun_part_concat(nparts, base, wid);
+      src->link(vvp_net_ptr_t(net, 0));
+      opt.drivers[net].drv[0] = src;
+
+      count_functors_fused += nparts;
+      return true;
+}
+
+/*
+ * These functors only compute their output from their inputs, so if
+ * the output goes nowhere they can be disconnected.
+ */
+static bool is_pure_functor(vvp_net_fun_t*fun)
+{
+      if (fun == 0)
+	    return false;
+      if (dynamic_cast<vvp_fun_boolean_*>(fun)) return true;
+      if (dynamic_cast<vvp_fun_not*>(fun)) return true;
+      if (dynamic_cast<vvp_fun_buf*>(fun)) return true;
+      if (dynamic_cast<vvp_fun_bufz*>(fun)) return true;
+      if (dynamic_cast<vvp_arith_*>(fun)) return true;
+      if (dynamic_cast<vvp_arith_real_*>(fun)) return true;
+      if (dynamic_cast<vvp_fun_extend_signed*>(fun)) return true;
+      if (dynamic_cast<vvp_fun_part_sa*>(fun)) return true;
+      if (dynamic_cast<vvp_fun_part_pv*>(fun)) return true;
+      if (dynamic_cast<vvp_fun_part_concat*>(fun)) return true;
+      if (typeid(*fun) == typeid(vvp_fun_concat)) return true;
+      return false;
+}
+
+static bool is_dead(net_optimize_s&opt, vvp_net_t*net)
+{
+      if (! net->fanout().nil())
+	    return false;
+      if (opt.is_fixed(net))
+	    return false;
+      return is_pure_functor(net->fun);
+}
+
+static void remove_dead_functors(net_optimize_s&opt)
+{
+      std::vector<vvp_net_t*> work;
+      std::set<vvp_net_t*> removed;
+
+      for (std::map<vvp_net_t*,net_drivers_s>::iterator cur = opt.drivers.begin()
+		 ; cur != opt.drivers.end() ; ++ cur ) {
+	    if (is_dead(opt, cur->first))
+		  work.push_back(cur->first);
+      }
+
+      while (! work.empty()) {
+	    vvp_net_t*net = work.back();
+	    work.pop_back();
+	    if (! removed.insert(net).second)
+		  continue;
+
+	    net_drivers_s&drv = opt.drivers[net];
+	    bool connected = false;
+	    for (unsigned idx = 0 ;  idx < 4 ;  idx += 1) {
+		  vvp_net_t*src = drv.drv[idx];
+		  if (src == 0)
+			continue;
+		  src->unlink(vvp_net_ptr_t(net, idx));
+		  drv.drv[idx] = 0;
+		  connected = true;
+		  if (is_dead(opt, src))
+			work.push_back(src);
+	    }
+
+	      /* A functor that was already disconnected (for example
+		 a part select absorbed into a fused concat) is not
+		 counted again. */
+	    if (connected)
+		  count_functors_removed += 1;
+      }
+}
+
+void optimize_netlist(void)
+{
+      net_optimize_s opt;
+
+      vvp_net_t::for_each(&collect_drivers, &opt);
+      codespace_for_each(&collect_code_refs, &opt);
+
+      std::vector<vvp_net_t*> cats;
+      for (std::map<vvp_net_t*,net_drivers_s>::iterator cur = opt.drivers.begin()
+		 ; cur != opt.drivers.end() ; ++ cur ) {
+	    if (dynamic_cast<vvp_fun_concat*>(cur->first->fun))
+		  cats.push_back(cur->first);
+      }
+
+      for (size_t idx = 0 ; idx < cats.size() ; idx += 1)
+	    fuse_part_concat(opt, cats[idx]);
+
+      remove_dead_functors(opt);
+}
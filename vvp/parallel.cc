@@ -0,0 +1,599 @@
+/*
+ * Copyright (c) 2026 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+# include  "config.h"
+# include  "parallel.h"
+# include  "vvp_net.h"
+# include  <iostream>
+# include  <sstream>
+# include  <map>
+# include  <vector>
+# include  <climits>
+# include  <cstdlib>
+# include  <cassert>
+#ifdef HAVE_LIBPTHREAD
+# include  <pthread.h>
+#endif
+
+using namespace std;
+
+bool vvp_parallel_active = false;
+
+unsigned long count_parallel_batches = 0;
+unsigned long count_parallel_events = 0;
+
+/*
+ * A batch is only worth handing to the threads if there is enough
+ * work in it to pay for waking them up.
+ */
+static const size_t parallel_min_events = 16;
+
+/*
+ * A value that reached a boundary (or a schedule_functor) on a worker
+ * is recorded with the event that caused it. A record with an obj is
+ * a scheduled functor, a record with a non-zero vwid is a part value.
+ */
+struct parallel_record_s {
+      vvp_gen_event_t obj;
+      vvp_net_ptr_t ptr;
+      vvp_vector4_t val;
+      unsigned base, wid, vwid;
+      vvp_context_t context;
+};
+
+struct parallel_worker_s {
+      parallel_worker_s() : records(0), event(0), deferring(false), main(false) { }
+
+      vector<parallel_record_s>*records;
+      size_t event;
+	// Set when the running event has recorded a value.
+      bool deferring;
+	// Set for the main thread.
+      bool main;
+      ostringstream diag;
+};
+
+/*
+ * The state of the batch that is running. The worker threads only
+ * write the records, diagnostics and ran flag of the events of the
+ * groups that they take, so nothing but the group counter is shared.
+ */
+static const vector<vvp_gen_event_t>*batch_objs = 0;
+static vector< vector<size_t> > batch_groups;
+static vector< vector<parallel_record_s> > batch_records;
+static vector<string> batch_diag;
+static vector<char> batch_ran;
+static size_t batch_next_group = 0;
+
+static bool parallel_started = false;
+
+bool parallel_net_ok(vvp_net_t*net)
+{
+      return net->fil == 0 && net->fun && net->fun->parallel_safe();
+}
+
+bool parallel_event_ok(vvp_gen_event_t obj)
+{
+      vvp_net_t*net = obj->parallel_net();
+      if (net == 0 || !parallel_net_ok(net))
+	    return false;
+      return net->partition() != ULONG_MAX;
+}
+
+/*
+ * The boundary functor sits in the fan-out of a partition net, and
+ * has the nets outside of the partition in its own fan-out. On a
+ * worker it records the vector4 values it gets (nothing else is sent
+ * by the functors that run there), and otherwise passes everything
+ * on unchanged.
+ */
+class vvp_fun_parallel_boundary : public vvp_net_fun_t {
+
+    public:
+      void recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
+                     vvp_context_t context);
+      void recv_vec8(vvp_net_ptr_t port, const vvp_vector8_t&bit);
+      void recv_real(vvp_net_ptr_t port, double bit,
+                     vvp_context_t context);
+      void recv_long(vvp_net_ptr_t port, long bit);
+      void recv_string(vvp_net_ptr_t port, const std::string&bit,
+		       vvp_context_t context);
+      void recv_object(vvp_net_ptr_t port, vvp_object_t bit,
+		       vvp_context_t context);
+
+      void recv_vec4_pv(vvp_net_ptr_t port, const vvp_vector4_t&bit,
+			unsigned base, unsigned wid, unsigned vwid,
+                        vvp_context_t context);
+      void recv_vec8_pv(vvp_net_ptr_t port, const vvp_vector8_t&bit,
+			unsigned base, unsigned wid, unsigned vwid);
+      void recv_long_pv(vvp_net_ptr_t port, long bit,
+                        unsigned base, unsigned wid);
+};
+
+static map<vvp_net_t*,vvp_net_t*> parallel_boundaries;
+
+static vvp_net_t* parallel_boundary_(vvp_net_t*net)
+{
+      vvp_net_t*&bnd = parallel_boundaries[net];
+      if (bnd == 0) {
+	    bnd = new vvp_net_t;
+	    bnd->fun = new vvp_fun_parallel_boundary;
+	    vvp_net_ptr_t bnd_ptr (bnd, 0);
+	    net->link(bnd_ptr);
+      }
+      return bnd;
+}
+
+static void parallel_collect_(vvp_net_t*net, void*cd)
+{
+      if (net->partition() != ULONG_MAX)
+	    static_cast<vector<vvp_net_t*>*>(cd)->push_back(net);
+}
+
+/*
+ * Move the fan-out of each partition net that leaves its partition
+ * behind a boundary.
+ */
+static void parallel_make_boundaries_(void)
+{
+      vector<vvp_net_t*> nets;
+      vvp_net_t::for_each(&parallel_collect_, &nets);
+
+      for (size_t idx = 0 ; idx < nets.size() ; idx += 1) {
+	    vvp_net_t*net = nets[idx];
+	    unsigned long part = net->partition();
+
+	    vector<vvp_net_ptr_t> leave;
+	    vvp_net_ptr_t cur = net->fanout();
+	    while (vvp_net_t*dst = cur.ptr()) {
+		  if (dst->partition() != part)
+			leave.push_back(cur);
+		  cur = dst->port[cur.port()];
+	    }
+
+	    if (leave.empty())
+		  continue;
+
+	    vvp_net_t*bnd = parallel_boundary_(net);
+	    for (size_t ldx = 0 ; ldx < leave.size() ; ldx += 1) {
+		  net->unlink(leave[ldx]);
+		  bnd->link(leave[ldx]);
+	    }
+      }
+}
+
+vvp_net_t* parallel_link_source(vvp_net_t*src, vvp_net_t*dst)
+{
+      if (! parallel_started)
+	    return src;
+
+      unsigned long part = src->partition();
+      if (part == ULONG_MAX || dst->partition() == part)
+	    return src;
+      if (dynamic_cast<vvp_fun_parallel_boundary*>(dst->fun))
+	    return src;
+
+      return parallel_boundary_(src);
+}
+
+#ifdef HAVE_LIBPTHREAD
+
+static pthread_key_t parallel_key;
+static pthread_mutex_t parallel_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t parallel_wake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t parallel_done = PTHREAD_COND_INITIALIZER;
+static unsigned long parallel_generation = 0;
+static unsigned parallel_workers = 0;
+static unsigned parallel_busy = 0;
+static bool parallel_fatal = false;
+
+static parallel_worker_s*parallel_worker_(void)
+{
+      return static_cast<parallel_worker_s*>(pthread_getspecific(parallel_key));
+}
+
+static void parallel_run_group_(parallel_worker_s*wrk, size_t grp)
+{
+      const vector<size_t>&events = batch_groups[grp];
+
+      for (size_t idx = 0 ; idx < events.size() ; idx += 1) {
+	    size_t cur = events[idx];
+	    wrk->records = &batch_records[cur];
+	    wrk->event = cur;
+	    wrk->deferring = false;
+	    (*batch_objs)[cur]->run_run();
+	    batch_ran[cur] = 1;
+
+	    if (wrk->diag.tellp() > 0) {
+		  batch_diag[cur] = wrk->diag.str();
+		  wrk->diag.str("");
+	    }
+
+	      /* The recorded values may come back into this
+		 partition when the main thread replays them, so the
+		 later events of the partition wait for that. */
+	    if (wrk->deferring)
+		  break;
+      }
+}
+
+/*
+ * Take groups of the current batch until there are none left. The
+ * main thread does this too, so that it is not idle.
+ */
+static void parallel_work_(parallel_worker_s*wrk)
+{
+      for (;;) {
+	    pthread_mutex_lock(&parallel_lock);
+	    size_t grp = batch_next_group;
+	    if (grp < batch_groups.size())
+		  batch_next_group += 1;
+	    pthread_mutex_unlock(&parallel_lock);
+
+	    if (grp >= batch_groups.size())
+		  return;
+
+	    parallel_run_group_(wrk, grp);
+      }
+}
+
+static void* parallel_thread_(void*)
+{
+      parallel_worker_s wrk;
+      pthread_setspecific(parallel_key, &wrk);
+
+      unsigned long seen = 0;
+      pthread_mutex_lock(&parallel_lock);
+      for (;;) {
+	    while (parallel_generation == seen)
+		  pthread_cond_wait(&parallel_wake, &parallel_lock);
+	    seen = parallel_generation;
+	    pthread_mutex_unlock(&parallel_lock);
+
+	    parallel_work_(&wrk);
+
+	    pthread_mutex_lock(&parallel_lock);
+	    parallel_busy -= 1;
+	    if (parallel_busy == 0)
+		  pthread_cond_signal(&parallel_done);
+      }
+      return 0;
+}
+
+bool parallel_supported(void)
+{
+      return true;
+}
+
+bool parallel_start(unsigned threads)
+{
+      assert(! parallel_started);
+      if (threads < 2)
+	    return true;
+
+      if (pthread_key_create(&parallel_key, 0) != 0)
+	    return false;
+
+      static parallel_worker_s main_worker;
+      main_worker.main = true;
+      pthread_setspecific(parallel_key, &main_worker);
+
+      for (unsigned idx = 1 ; idx < threads ; idx += 1) {
+	    pthread_t thr;
+	    if (pthread_create(&thr, 0, &parallel_thread_, 0) != 0)
+		  break;
+	    pthread_detach(thr);
+	    parallel_workers += 1;
+      }
+
+      if (parallel_workers == 0)
+	    return false;
+
+      vvp_net_t::make_partitions();
+      parallel_make_boundaries_();
+      parallel_started = true;
+      return true;
+}
+
+static void parallel_wait_workers_(void)
+{
+      pthread_mutex_lock(&parallel_lock);
+      while (parallel_busy > 0)
+	    pthread_cond_wait(&parallel_done, &parallel_lock);
+      pthread_mutex_unlock(&parallel_lock);
+}
+
+static void parallel_run_threads_(void)
+{
+      vvp_parallel_active = true;
+
+      pthread_mutex_lock(&parallel_lock);
+      parallel_generation += 1;
+      parallel_busy = parallel_workers;
+      pthread_cond_broadcast(&parallel_wake);
+      pthread_mutex_unlock(&parallel_lock);
+
+      parallel_work_(parallel_worker_());
+      parallel_wait_workers_();
+
+      vvp_parallel_active = false;
+}
+
+static void parallel_emit_fatal_(void)
+{
+      for (size_t idx = 0 ; idx < batch_diag.size() ; idx += 1)
+	    cerr << batch_diag[idx];
+      cerr.flush();
+      abort();
+}
+
+/*
+ * A worker thread that gets a fatal diagnostic counts itself done and
+ * stops for good. The main thread waits for the others, and then
+ * writes out the diagnostics of the batch and aborts.
+ */
+void parallel_diag_fatal(void)
+{
+      if (! vvp_parallel_active) {
+	    cerr.flush();
+	    abort();
+      }
+
+      parallel_worker_s*wrk = parallel_worker_();
+      batch_diag[wrk->event] = wrk->diag.str();
+
+      pthread_mutex_lock(&parallel_lock);
+      parallel_fatal = true;
+      if (! wrk->main) {
+	    parallel_busy -= 1;
+	    if (parallel_busy == 0)
+		  pthread_cond_signal(&parallel_done);
+	    for (;;)
+		  pthread_cond_wait(&parallel_wake, &parallel_lock);
+      }
+      pthread_mutex_unlock(&parallel_lock);
+
+      parallel_wait_workers_();
+      vvp_parallel_active = false;
+      parallel_emit_fatal_();
+}
+
+#else
+
+static parallel_worker_s*parallel_worker_(void)
+{
+      assert(0);
+      return 0;
+}
+
+bool parallel_supported(void)
+{
+      return false;
+}
+
+bool parallel_start(unsigned threads)
+{
+      return threads < 2;
+}
+
+static void parallel_run_threads_(void)
+{
+      assert(0);
+}
+
+void parallel_diag_fatal(void)
+{
+      cerr.flush();
+      abort();
+}
+
+#endif
+
+bool parallel_enabled(void)
+{
+      return parallel_started;
+}
+
+ostream& parallel_diag(void)
+{
+      if (! vvp_parallel_active)
+	    return cerr;
+      return parallel_worker_()->diag;
+}
+
+void parallel_defer_functor(vvp_gen_event_t obj)
+{
+      parallel_worker_s*wrk = parallel_worker_();
+      wrk->records->push_back(parallel_record_s());
+      wrk->records->back().obj = obj;
+}
+
+static void parallel_record_(vvp_net_ptr_t ptr, const vvp_vector4_t&val,
+			     unsigned base, unsigned wid, unsigned vwid,
+			     vvp_context_t context)
+{
+      parallel_worker_s*wrk = parallel_worker_();
+      wrk->records->push_back(parallel_record_s());
+      parallel_record_s&cur = wrk->records->back();
+      cur.obj = 0;
+      cur.ptr = ptr;
+      cur.val = val;
+      cur.base = base;
+      cur.wid = wid;
+      cur.vwid = vwid;
+      cur.context = context;
+      wrk->deferring = true;
+}
+
+void vvp_fun_parallel_boundary::recv_vec4(vvp_net_ptr_t port,
+					  const vvp_vector4_t&bit,
+					  vvp_context_t context)
+{
+      if (vvp_parallel_active)
+	    parallel_record_(port, bit, 0, 0, 0, context);
+      else
+	    port.ptr()->send_vec4(bit, context);
+}
+
+void vvp_fun_parallel_boundary::recv_vec4_pv(vvp_net_ptr_t port,
+					     const vvp_vector4_t&bit,
+					     unsigned base, unsigned wid,
+					     unsigned vwid,
+					     vvp_context_t context)
+{
+      if (vvp_parallel_active)
+	    parallel_record_(port, bit, base, wid, vwid, context);
+      else
+	    port.ptr()->send_vec4_pv(bit, base, wid, vwid, context);
+}
+
+void vvp_fun_parallel_boundary::recv_vec8(vvp_net_ptr_t port,
+					  const vvp_vector8_t&bit)
+{
+      assert(! vvp_parallel_active);
+      port.ptr()->send_vec8(bit);
+}
+
+void vvp_fun_parallel_boundary::recv_real(vvp_net_ptr_t port, double bit,
+					  vvp_context_t context)
+{
+      assert(! vvp_parallel_active);
+      port.ptr()->send_real(bit, context);
+}
+
+void vvp_fun_parallel_boundary::recv_long(vvp_net_ptr_t port, long bit)
+{
+      assert(! vvp_parallel_active);
+      vvp_send_long(port.ptr()->fanout(), bit);
+}
+
+void vvp_fun_parallel_boundary::recv_string(vvp_net_ptr_t port,
+					    const std::string&bit,
+					    vvp_context_t context)
+{
+      assert(! vvp_parallel_active);
+      port.ptr()->send_string(bit, context);
+}
+
+void vvp_fun_parallel_boundary::recv_object(vvp_net_ptr_t port,
+					    vvp_object_t bit,
+					    vvp_context_t context)
+{
+      assert(! vvp_parallel_active);
+      port.ptr()->send_object(bit, context);
+}
+
+void vvp_fun_parallel_boundary::recv_vec8_pv(vvp_net_ptr_t port,
+					     const vvp_vector8_t&bit,
+					     unsigned base, unsigned wid,
+					     unsigned vwid)
+{
+      assert(! vvp_parallel_active);
+      port.ptr()->send_vec8_pv(bit, base, wid, vwid);
+}
+
+void vvp_fun_parallel_boundary::recv_long_pv(vvp_net_ptr_t port, long bit,
+					     unsigned base, unsigned wid)
+{
+      assert(! vvp_parallel_active);
+      vvp_send_long_pv(port.ptr()->fanout(), bit, base, wid);
+}
+
+static void parallel_replay_(const vector<parallel_record_s>&records)
+{
+      for (size_t idx = 0 ; idx < records.size() ; idx += 1) {
+	    const parallel_record_s&cur = records[idx];
+	    if (cur.obj) {
+		  schedule_functor(cur.obj);
+		  continue;
+	    }
+
+	    vvp_net_ptr_t ptr = cur.ptr;
+	    vvp_net_t*net = ptr.ptr();
+	    if (cur.vwid)
+		  net->fun->recv_vec4_pv(ptr, cur.val, cur.base, cur.wid,
+					 cur.vwid, cur.context);
+	    else
+		  net->fun->recv_vec4(ptr, cur.val, cur.context);
+      }
+}
+
+/*
+ * Run the events of the batch. The events are grouped by partition,
+ * keeping their order, and the groups are run by the threads. Then
+ * the main thread goes through the events in their original order:
+ * for an event that a worker ran it writes out the diagnostics and
+ * replays the recorded values, and an event that no worker ran is
+ * run now.
+ */
+void parallel_run_batch(const vector<vvp_gen_event_t>&objs)
+{
+      if (!parallel_started || objs.size() < parallel_min_events) {
+	    for (size_t idx = 0 ; idx < objs.size() ; idx += 1)
+		  objs[idx]->run_run();
+	    return;
+      }
+
+      map<unsigned long,size_t> group_of;
+      batch_groups.clear();
+      for (size_t idx = 0 ; idx < objs.size() ; idx += 1) {
+	    unsigned long part = objs[idx]->parallel_net()->partition();
+	    map<unsigned long,size_t>::iterator cur = group_of.find(part);
+	    if (cur == group_of.end()) {
+		  cur = group_of.insert(make_pair(part, batch_groups.size())).first;
+		  batch_groups.push_back(vector<size_t>());
+	    }
+	    batch_groups[cur->second].push_back(idx);
+      }
+
+      if (batch_groups.size() < 2) {
+	    for (size_t idx = 0 ; idx < objs.size() ; idx += 1)
+		  objs[idx]->run_run();
+	    return;
+      }
+
+      batch_objs = &objs;
+      batch_records.clear();
+      batch_records.resize(objs.size());
+      batch_diag.clear();
+      batch_diag.resize(objs.size());
+      batch_ran.assign(objs.size(), 0);
+      batch_next_group = 0;
+
+      parallel_run_threads_();
+
+#ifdef HAVE_LIBPTHREAD
+      if (parallel_fatal)
+	    parallel_emit_fatal_();
+#endif
+
+      count_parallel_batches += 1;
+      for (size_t idx = 0 ; idx < objs.size() ; idx += 1) {
+	    if (batch_ran[idx]) {
+		  count_parallel_events += 1;
+		  if (! batch_diag[idx].empty())
+			cerr << batch_diag[idx];
+		  parallel_replay_(batch_records[idx]);
+	    } else {
+		  objs[idx]->run_run();
+	    }
+      }
+
+      batch_objs = 0;
+}
@@ -0,0 +1,90 @@
+#ifndef IVL_parallel_H
+#define IVL_parallel_H
+/*
+ * Copyright (c) 2026 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+# include  "schedule.h"
+# include  <iosfwd>
+# include  <vector>
+
+/*
+ * Parallel evaluation (vvp -t) runs gate events of the active queue
+ * on several threads. The netlist is divided into partitions: the
+ * sets of nets with parallel_safe() functors that are connected
+ * through their fan-out. Signals and the other nets are boundaries
+ * between the partitions. The events of one partition are run in
+ * order by one thread.
+ *
+ * parallel_start() puts a boundary functor in front of the fan-out of
+ * each partition net to nets outside its partition, so the ordinary
+ * sends need no test of their own. While the workers run, a boundary
+ * records what reaches it, and the main thread replays the records in
+ * event order once the batch is done. After an event of a partition
+ * has recorded a value, the later events of that partition are left
+ * to the main thread as well. Events in the active queue may run in
+ * any order, and this order depends only on the events and not on
+ * the number of threads or their timing.
+ *
+ * parallel_start() returns false if the threads cannot be started.
+ * The scheduler passes runs of eligible events to
+ * parallel_run_batch(), which runs the run_run() method of each of
+ * them in some way. The events must be ones for which
+ * parallel_event_ok() is true.
+ */
+extern bool parallel_supported(void);
+extern bool parallel_start(unsigned threads);
+extern bool parallel_enabled(void);
+
+extern bool parallel_net_ok(vvp_net_t*net);
+extern bool parallel_event_ok(vvp_gen_event_t obj);
+extern void parallel_run_batch(const std::vector<vvp_gen_event_t>&objs);
+
+/*
+ * True while the worker threads run a batch.
+ */
+extern bool vvp_parallel_active;
+
+/*
+ * While a batch runs, schedule_functor passes its object here
+ * instead of putting it in the queue.
+ */
+extern void parallel_defer_functor(vvp_gen_event_t obj);
+
+/*
+ * Links made after parallel_start() from a partition net to a net
+ * outside of its partition go through the boundary of the net. This
+ * returns the net that the link is to be made from.
+ */
+extern vvp_net_t* parallel_link_source(vvp_net_t*src, vvp_net_t*dst);
+
+/*
+ * The functors that may run on a worker thread write their
+ * diagnostics to parallel_diag() instead of stderr. While a batch
+ * runs, the text is kept with the event and written by the main
+ * thread after the join, in event order. parallel_diag_fatal() ends a
+ * diagnostic that the simulation cannot go on after; it does not
+ * return.
+ */
+extern std::ostream& parallel_diag(void);
+extern void parallel_diag_fatal(void);
+
+extern unsigned long count_parallel_batches;
+extern unsigned long count_parallel_events;
+
+#endif /* IVL_parallel_H */
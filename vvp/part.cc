@@ -94,6 +94,82 @@ void vvp_fun_part_sa::run_run()
       ptr->send_vec4(val_, 0);
 }
 
+vvp_fun_part_concat::vvp_fun_part_concat(unsigned nparts,
+					 const unsigned base[4],
+					 const unsigned wid[4])
+: nparts_(nparts)
+{
+      assert(nparts_ <= 4);
+      for (unsigned idx = 0 ;  idx < nparts_ ;  idx += 1) {
+	    base_[idx] = base[idx];
+	    wid_[idx] = wid[idx];
+      }
+      net_ = 0;
+}
+
+vvp_fun_part_concat::~vvp_fun_part_concat()
+{
+}
+
+void vvp_fun_part_concat::recv_vec4(vvp_net_ptr_t port,
+				    const vvp_vector4_t&bit,
+				    vvp_context_t)
+{
+      assert(port.port() == 0);
+
+      unsigned wid = 0;
+      for (unsigned idx = 0 ;  idx < nparts_ ;  idx += 1)
+	    wid += wid_[idx];
+
+      vvp_vector4_t tmp (wid);
+      unsigned off = 0;
+      for (unsigned idx = 0 ;  idx < nparts_ ;  idx += 1) {
+	    tmp.set_vec(off, vvp_vector4_t(bit, base_[idx], wid_[idx]));
+	    off += wid_[idx];
+      }
+
+      if (val_ .eeq( tmp ))
+	    return;
+
+      val_ = tmp;
+
+      if (net_ == 0) {
+	    net_ = port.ptr();
+	    schedule_functor(this);
+      }
+}
+
+/*
+ * As in vvp_fun_part_sa::recv_vec4_pv, the bits that the parts held
+ * before are merged with the new bits, so that bits outside the
+ * part select assignment keep their value.
+ */
+void vvp_fun_part_concat::recv_vec4_pv(vvp_net_ptr_t port,
+				       const vvp_vector4_t&bit,
+				       unsigned base, unsigned wid,
+				       unsigned vwid, vvp_context_t)
+{
+      assert(bit.size() == wid);
+
+      vvp_vector4_t tmp (vwid, BIT4_Z);
+      if (val_.size() > 0) {
+	    unsigned off = 0;
+	    for (unsigned idx = 0 ;  idx < nparts_ ;  idx += 1) {
+		  tmp.set_vec(base_[idx], val_.subvalue(off, wid_[idx]));
+		  off += wid_[idx];
+	    }
+      }
+      tmp.set_vec(base, bit);
+      recv_vec4(port, tmp, 0);
+}
+
+void vvp_fun_part_concat::run_run()
+{
+      vvp_net_t*ptr = net_;
+      net_ = 0;
+      ptr->send_vec4(val_, 0);
+}
+
 vvp_fun_part_aa::vvp_fun_part_aa(unsigned base, unsigned wid)
 : vvp_fun_part(base, wid)
 {
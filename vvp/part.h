@@ -34,6 +34,9 @@ class vvp_fun_part  : public vvp_net_fun_t {
       vvp_fun_part(unsigned base, unsigned wid);
       ~vvp_fun_part();
 
+      unsigned base() const { return base_; }
+      unsigned width() const { return wid_; }
+
     protected:
       unsigned base_;
       unsigned wid_;
@@ -64,6 +67,40 @@ class vvp_fun_part_sa  : public vvp_fun_part, public vvp_gen_event_s {
       vvp_net_t*net_;
 };
 
+/*
+ * This is the replacement that the netlist optimizer makes for a
+ * .concat whose inputs are all statically allocated part selects of
+ * the same vector. The parts are listed in the order of the concat
+ * ports, so the first part lands in the least significant bits of
+ * the result. Like vvp_fun_part_sa, the output is scheduled instead
+ * of being propagated immediately, but only once for all the parts.
+ */
+class vvp_fun_part_concat  : public vvp_net_fun_t, public vvp_gen_event_s {
+
+    public:
+      vvp_fun_part_concat(unsigned nparts,
+                          const unsigned base[4], const unsigned wid[4]);
+      ~vvp_fun_part_concat();
+
+    public:
+      void recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
+                     vvp_context_t);
+
+      void recv_vec4_pv(vvp_net_ptr_t port, const vvp_vector4_t&bit,
+			unsigned, unsigned, unsigned,
+                        vvp_context_t);
+
+    private:
+      void run_run();
+
+    private:
+      unsigned nparts_;
+      unsigned base_[4];
+      unsigned wid_[4];
+      vvp_vector4_t val_;
+      vvp_net_t*net_;
+};
+
 /*
  * Automatically allocated vvp_fun_part.
  */
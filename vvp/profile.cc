@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2026 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+# include  "config.h"
+# include  "profile.h"
+# include  "compile.h"
+# include  "vpi_priv.h"
+# include  "checkpoint.h"
+# include  <algorithm>
+# include  <map>
+# include  <string>
+# include  <vector>
+# include  <cstdio>
+# include  <cstring>
+
+using namespace std;
+
+bool profile_flag = false;
+
+static FILE*profile_file = 0;
+
+struct profile_scope_s {
+      profile_scope_s() : count(0), runs(0), wall(0.0), cpu(0.0) { }
+      unsigned long count;
+      unsigned long runs;
+      double wall;
+      double cpu;
+};
+
+struct profile_line_s {
+      profile_line_s() : statements(0), count(0) { }
+      unsigned long statements;
+      unsigned long count;
+};
+
+/*
+ * The opcodes are counted for every executed instruction, so they go
+ * into a small open hash table keyed by the opcode function instead
+ * of a map. The table is larger than the number of opcodes, so it
+ * never fills. It is sorted at report time.
+ */
+struct profile_opcode_s {
+      vvp_code_fun opcode;
+      unsigned long count;
+};
+static const size_t profile_opcode_size = 1024;
+static profile_opcode_s profile_opcodes[profile_opcode_size];
+
+static map<__vpiScope*,profile_scope_s> profile_scopes;
+static map<__vpiHandle*,profile_line_s> profile_lines;
+static map<vvp_net_t*,unsigned long> profile_nets;
+
+bool profile_open(const char*path)
+{
+      profile_file = fopen(path, "w");
+      if (profile_file == 0)
+	    return false;
+
+      checkpoint_per_run_file(profile_file, path);
+
+      profile_flag = true;
+      return true;
+}
+
+void profile_opcode(vvp_code_fun opcode)
+{
+      size_t key = reinterpret_cast<size_t>(opcode);
+      size_t idx = ((key >> 4) ^ (key >> 14)) & (profile_opcode_size-1);
+
+      while (profile_opcodes[idx].opcode != opcode) {
+	    if (profile_opcodes[idx].opcode == 0) {
+		  profile_opcodes[idx].opcode = opcode;
+		  break;
+	    }
+	    idx = (idx + 1) & (profile_opcode_size-1);
+      }
+
+      profile_opcodes[idx].count += 1;
+}
+
+void profile_statement(__vpiHandle*file_line)
+{
+      profile_lines[file_line].statements += 1;
+}
+
+void profile_line(__vpiHandle*file_line, unsigned long count)
+{
+      profile_lines[file_line].count += count;
+}
+
+void profile_scope(__vpiScope*scope, unsigned long count,
+		   double wall, double cpu)
+{
+      profile_scope_s&cur = profile_scopes[scope];
+      cur.count += count;
+      cur.runs += 1;
+      cur.wall += wall;
+      cur.cpu += cpu;
+}
+
+void profile_net_change(vvp_net_t*net)
+{
+      profile_nets[net] += 1;
+}
+
+/*
+ * The nets are counted by vvp_net_t, but reported by the name of the
+ * signal (or real variable) that the net implements. Scan the scope
+ * tree to find the names.
+ */
+static void profile_net_names_(__vpiScope*scope, map<vvp_net_t*,string>&names)
+{
+      for (size_t idx = 0 ; idx < scope->intern.size() ; idx += 1) {
+	    __vpiHandle*item = scope->intern[idx];
+
+	    vvp_net_t*net = 0;
+	    if (__vpiScope*sub = dynamic_cast<__vpiScope*>(item)) {
+		  profile_net_names_(sub, names);
+		  continue;
+	    } else if (__vpiSignal*sig = dynamic_cast<__vpiSignal*>(item)) {
+		  net = sig->node;
+	    } else if (__vpiRealVar*var = dynamic_cast<__vpiRealVar*>(item)) {
+		  net = var->net;
+	    }
+
+	    if (net && profile_nets.find(net) != profile_nets.end())
+		  names[net] = vpi_get_str(vpiFullName, item);
+      }
+}
+
+template <class K> static bool profile_by_count_(const pair<K,unsigned long>&a,
+						 const pair<K,unsigned long>&b)
+{
+      return a.second > b.second;
+}
+
+static bool profile_by_seconds_(const pair<__vpiScope*,profile_scope_s>&a,
+				const pair<__vpiScope*,profile_scope_s>&b)
+{
+      return a.second.wall > b.second.wall;
+}
+
+static bool profile_by_line_count_(const pair<__vpiHandle*,profile_line_s>&a,
+				   const pair<__vpiHandle*,profile_line_s>&b)
+{
+      return a.second.count > b.second.count;
+}
+
+/*
+ * The report has one record per line. The first word is the kind of
+ * record and the numbers follow, so that the report can be sorted
+ * with standard tools. Each section is already sorted by cost, the
+ * largest first.
+ */
+void profile_report(void)
+{
+      if (profile_file == 0)
+	    return;
+
+      fprintf(profile_file, "# vvp profile\n");
+
+      fprintf(profile_file, "# opcode <executed> <mnemonic>\n");
+      vector< pair<vvp_code_fun,unsigned long> > opcodes;
+      for (size_t idx = 0 ; idx < profile_opcode_size ; idx += 1) {
+	    if (profile_opcodes[idx].opcode == 0)
+		  continue;
+	    opcodes.push_back(make_pair(profile_opcodes[idx].opcode,
+					profile_opcodes[idx].count));
+      }
+      sort(opcodes.begin(), opcodes.end(), profile_by_count_<vvp_code_fun>);
+      for (size_t idx = 0 ; idx < opcodes.size() ; idx += 1) {
+	    fprintf(profile_file, "opcode %lu %s\n", opcodes[idx].second,
+		    compile_opcode_name(opcodes[idx].first));
+      }
+
+      fprintf(profile_file, "# scope <wall seconds> <cpu seconds> <executed> <runs> <name>\n");
+      vector< pair<__vpiScope*,profile_scope_s> > scopes
+	    (profile_scopes.begin(), profile_scopes.end());
+      sort(scopes.begin(), scopes.end(), profile_by_seconds_);
+      for (size_t idx = 0 ; idx < scopes.size() ; idx += 1) {
+	    const profile_scope_s&cur = scopes[idx].second;
+	    fprintf(profile_file, "scope %.6f %.6f %lu %lu %s\n", cur.wall,
+		    cur.cpu, cur.count, cur.runs,
+		    vpi_get_str(vpiFullName, scopes[idx].first));
+      }
+
+      fprintf(profile_file, "# line <executed> <statements> <file>:<line>\n");
+      vector< pair<__vpiHandle*,profile_line_s> > lines
+	    (profile_lines.begin(), profile_lines.end());
+      sort(lines.begin(), lines.end(), profile_by_line_count_);
+      for (size_t idx = 0 ; idx < lines.size() ; idx += 1) {
+	    const profile_line_s&cur = lines[idx].second;
+	    string file = vpi_get_str(vpiFile, lines[idx].first);
+	    fprintf(profile_file, "line %lu %lu %s:%d\n", cur.count,
+		    cur.statements, file.c_str(),
+		    vpi_get(vpiLineNo, lines[idx].first));
+      }
+
+      fprintf(profile_file, "# net <changes> <name>\n");
+      map<vvp_net_t*,string> names;
+      __vpiHandle**roots;
+      unsigned nroots;
+      vpip_make_root_iterator(roots, nroots);
+      for (unsigned idx = 0 ; idx < nroots ; idx += 1) {
+	    if (__vpiScope*scope = dynamic_cast<__vpiScope*>(roots[idx]))
+		  profile_net_names_(scope, names);
+      }
+
+      vector< pair<vvp_net_t*,unsigned long> > nets
+	    (profile_nets.begin(), profile_nets.end());
+      sort(nets.begin(), nets.end(), profile_by_count_<vvp_net_t*>);
+      for (size_t idx = 0 ; idx < nets.size() ; idx += 1) {
+	    map<vvp_net_t*,string>::const_iterator cur = names.find(nets[idx].first);
+	    if (cur != names.end())
+		  fprintf(profile_file, "net %lu %s\n", nets[idx].second,
+			  cur->second.c_str());
+	    else
+		  fprintf(profile_file, "net %lu <%p>\n", nets[idx].second,
+			  (void*)nets[idx].first);
+      }
+
+      fclose(profile_file);
+      profile_file = 0;
+}
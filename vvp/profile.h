@@ -0,0 +1,47 @@
+#ifndef IVL_profile_H
+#define IVL_profile_H
+/*
+ * Copyright (c) 2026 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+# include  "codes.h"
+
+class __vpiScope;
+class __vpiHandle;
+
+/*
+ * The run time profiler is enabled with the -p flag. When it is on,
+ * the thread interpreter counts every executed instruction by opcode,
+ * by %file_line statement and by scope, and times each thread run by
+ * scope, in wall clock and in CPU seconds. The value changes of
+ * signals are counted per net. The counts are written to a report
+ * file at the end of the simulation.
+ */
+extern bool profile_flag;
+
+extern bool profile_open(const char*path);
+extern void profile_report(void);
+
+extern void profile_opcode(vvp_code_fun opcode);
+extern void profile_statement(__vpiHandle*file_line);
+extern void profile_line(__vpiHandle*file_line, unsigned long count);
+extern void profile_scope(__vpiScope*scope, unsigned long count,
+			  double wall, double cpu);
+extern void profile_net_change(vvp_net_t*net);
+
+#endif /* IVL_profile_H */
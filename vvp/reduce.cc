@@ -45,6 +45,8 @@ class vvp_reduce_base : public vvp_net_fun_t {
 
       virtual vvp_bit4_t calculate_result() const =0;
 
+      bool parallel_safe(void) const;
+
     protected:
       vvp_vector4_t bits_;
 };
@@ -82,6 +84,11 @@ void vvp_reduce_base::recv_vec4_pv(vvp_net_ptr_t prt, const vvp_vector4_t&bit,
       prt.ptr()->send_vec4(rv, context);
 }
 
+bool vvp_reduce_base::parallel_safe(void) const
+{
+      return true;
+}
+
 class vvp_reduce_and  : public vvp_reduce_base {
 
     public:
@@ -24,6 +24,8 @@
 # include  "vvp_net_sig.h"
 # include  "slab.h"
 # include  "compile.h"
+# include  "checkpoint.h"
+# include  "parallel.h"
 # include  <new>
 # include  <typeinfo>
 # include  <csignal>
@@ -49,6 +51,8 @@ unsigned long count_time_events = 0;
  *
  * The event_time_s objects are one per time step. Each time step in
  * turn contains a list of event_s objects that are the actual events.
+ * The time steps that are in the future are kept in a timing wheel
+ * (see below) that is indexed by the absolute time of the step.
  *
  * The event_s objects are base classes for the more specific sort of
  * event.
@@ -61,6 +65,10 @@ struct event_s {
 	// Write something about the event to stderr
       virtual void single_step_display(void);
 
+	// The object to run if this event may be run in a parallel
+	// batch, otherwise 0.
+      virtual vvp_gen_event_t parallel_obj(void) { return 0; }
+
 	// Fallback new/delete
       static void*operator new (size_t size) { return ::new char[size]; }
       static void operator delete(void*ptr)  { ::delete[]( (char*)ptr ); }
@@ -82,7 +90,8 @@ struct event_time_s {
 	    del_thr = 0;
 	    next = NULL;
       }
-      vvp_time64_t delay;
+	// The absolute simulation time of this time step.
+      vvp_time64_t time;
 
       struct event_s*start;
       struct event_s*active;
@@ -101,6 +110,11 @@ vvp_gen_event_s::~vvp_gen_event_s()
 {
 }
 
+vvp_net_t* vvp_gen_event_s::parallel_net(void)
+{
+      return 0;
+}
+
 void vvp_gen_event_s::single_step_display(void)
 {
       cerr << "vvp_gen_event_s: Step into event " << typeid(*this).name() << endl;
@@ -490,6 +504,8 @@ struct generic_event_s : public event_s {
       bool delete_obj_when_done;
       void run_run(void);
       void single_step_display(void);
+      vvp_gen_event_t parallel_obj(void)
+      { return delete_obj_when_done? 0 : obj; }
 
       static void* operator new(size_t);
       static void operator delete(void*);
@@ -550,11 +566,234 @@ inline void event_time_s::operator delete(void*ptr, size_t)
 unsigned long count_time_pool(void) { return event_time_heap.pool; }
 
 /*
- * This is the head of the list of pending events. This includes all
- * the events that have not been executed yet, and reaches into the
- * future.
+ * This is the time step that is currently being executed. It is nil
+ * between time steps, in which case the next time step is pulled from
+ * the timing wheel below.
+ */
+static struct event_time_s* sched_current = 0;
+
+/*
+ * The pending time steps that are in the future are kept in a
+ * hierarchical timing wheel. The absolute time is split into digits of
+ * WHEEL_BITS bits, and each level of the wheel has one slot for each
+ * value of a digit. A time step is stored in the level of the most
+ * significant digit that differs from the wheel time, and in the slot
+ * selected by that digit. This means that level 0 has exactly one time
+ * step per slot, and the higher levels hold lists of time steps that
+ * are moved down a level (cascaded) when the wheel time reaches their
+ * slot. Each level also keeps a bitmap of the occupied slots so that
+ * the next time step can be found without stepping through empty
+ * slots. Inserting a time step is therefore constant time no matter
+ * how many distinct future times are pending.
+ *
+ * The time steps in a slot are kept in insertion order. A higher level
+ * slot may hold more than one event_time_s for the same time; these
+ * are merged (in order) when they are cascaded down to level 0.
  */
-static struct event_time_s* sched_list = 0;
+static const unsigned WHEEL_BITS = 8;
+static const unsigned WHEEL_SLOTS = 1 << WHEEL_BITS;
+static const unsigned WHEEL_MASK = WHEEL_SLOTS - 1;
+static const unsigned WHEEL_TIME_BITS = 8 * sizeof(vvp_time64_t);
+static const unsigned WHEEL_LEVELS = (WHEEL_TIME_BITS + WHEEL_BITS - 1) / WHEEL_BITS;
+static const unsigned WHEEL_MAP_BITS = 8 * sizeof(unsigned);
+static const unsigned WHEEL_MAP_WORDS = WHEEL_SLOTS / WHEEL_MAP_BITS;
+
+struct event_wheel_level_s {
+      unsigned map[WHEEL_MAP_WORDS];
+      struct event_time_s*head[WHEEL_SLOTS];
+      struct event_time_s*tail[WHEEL_SLOTS];
+};
+
+static struct event_wheel_level_s sched_wheel[WHEEL_LEVELS];
+  // The time that the wheel positions are relative to.
+static vvp_time64_t sched_wheel_time = 0;
+  // The number of event_time_s objects in the wheel.
+static unsigned long sched_wheel_count = 0;
+
+static inline unsigned wheel_level_(vvp_time64_t time)
+{
+      vvp_time64_t diff = (time ^ sched_wheel_time) >> WHEEL_BITS;
+      unsigned level = 0;
+      while (diff) {
+	    diff >>= WHEEL_BITS;
+	    level += 1;
+      }
+      return level;
+}
+
+static inline unsigned wheel_slot_(vvp_time64_t time, unsigned level)
+{
+      return (time >> (level*WHEEL_BITS)) & WHEEL_MASK;
+}
+
+static inline unsigned wheel_first_bit_(unsigned word)
+{
+#if defined(__GNUC__)
+      return __builtin_ctz(word);
+#else
+      unsigned idx = 0;
+      while ((word & 1) == 0) {
+	    word >>= 1;
+	    idx += 1;
+      }
+      return idx;
+#endif
+}
+
+/*
+ * Return the first occupied slot of the level at or after the given
+ * slot, or WHEEL_SLOTS if there are none.
+ */
+static unsigned wheel_find_slot_(const struct event_wheel_level_s&lev,
+				 unsigned from)
+{
+      for (unsigned wdx = from / WHEEL_MAP_BITS ; wdx < WHEEL_MAP_WORDS ; wdx += 1) {
+	    unsigned word = lev.map[wdx];
+	    if (wdx == from / WHEEL_MAP_BITS)
+		  word &= ~0U << (from % WHEEL_MAP_BITS);
+	    if (word)
+		  return wdx*WHEEL_MAP_BITS + wheel_first_bit_(word);
+      }
+      return WHEEL_SLOTS;
+}
+
+static void wheel_append_(struct event_time_s*ctim, unsigned level, unsigned idx)
+{
+      struct event_wheel_level_s&lev = sched_wheel[level];
+      ctim->next = 0;
+      if (lev.tail[idx]) {
+	    lev.tail[idx]->next = ctim;
+      } else {
+	    lev.head[idx] = ctim;
+	    lev.map[idx / WHEEL_MAP_BITS] |= 1U << (idx % WHEEL_MAP_BITS);
+      }
+      lev.tail[idx] = ctim;
+}
+
+/*
+ * Append the events of the src queue to the end of the dst queue.
+ * Both are circular lists that point at their last event.
+ */
+static inline void merge_queue_(struct event_s*&dst, struct event_s*src)
+{
+      if (src == 0)
+	    return;
+
+      if (dst) {
+	    struct event_s*head = dst->next;
+	    dst->next = src->next;
+	    src->next = head;
+      }
+      dst = src;
+}
+
+/*
+ * Move the events of the src time step to the end of the dst time
+ * step, and delete the src time step.
+ */
+static void merge_event_time_(struct event_time_s*dst, struct event_time_s*src)
+{
+      assert(dst->time == src->time);
+      merge_queue_(dst->start,    src->start);
+      merge_queue_(dst->active,   src->active);
+      merge_queue_(dst->nbassign, src->nbassign);
+      merge_queue_(dst->rwsync,   src->rwsync);
+      merge_queue_(dst->rosync,   src->rosync);
+      merge_queue_(dst->del_thr,  src->del_thr);
+      delete src;
+}
+
+/*
+ * Get the event_time_s for the given (future) time, creating it if
+ * needed. Level 0 slots hold a single time so the slot is either
+ * empty or the time step we want. The higher levels check the most
+ * recently added time step, which catches the common case of many
+ * events being scheduled with the same delay.
+ */
+static struct event_time_s* wheel_get_(vvp_time64_t time)
+{
+      assert(time != sched_wheel_time);
+      unsigned level = wheel_level_(time);
+      unsigned idx = wheel_slot_(time, level);
+
+      struct event_time_s*ctim = sched_wheel[level].tail[idx];
+      if (ctim && ctim->time == time)
+	    return ctim;
+
+      ctim = new struct event_time_s;
+      ctim->time = time;
+      wheel_append_(ctim, level, idx);
+      sched_wheel_count += 1;
+      return ctim;
+}
+
+/*
+ * Remove the earliest time step from the wheel and advance the wheel
+ * time to it. The caller must make sure the wheel is not empty.
+ */
+static struct event_time_s* wheel_pop_(void)
+{
+      assert(sched_wheel_count > 0);
+
+      for (;;) {
+	    struct event_wheel_level_s&lev0 = sched_wheel[0];
+	    unsigned idx = wheel_find_slot_(lev0, sched_wheel_time & WHEEL_MASK);
+	    if (idx < WHEEL_SLOTS) {
+		  struct event_time_s*ctim = lev0.head[idx];
+		  assert(ctim && ctim->next == 0);
+		  lev0.head[idx] = 0;
+		  lev0.tail[idx] = 0;
+		  lev0.map[idx / WHEEL_MAP_BITS] &= ~(1U << (idx % WHEEL_MAP_BITS));
+		  sched_wheel_count -= 1;
+		  sched_wheel_time = ctim->time;
+		  return ctim;
+	    }
+
+	      /* Level 0 is empty, so find the next occupied slot in
+		 the higher levels and cascade its time steps down. */
+	    unsigned level = 1;
+	    for ( ; level < WHEEL_LEVELS ; level += 1) {
+		  unsigned from = wheel_slot_(sched_wheel_time, level) + 1;
+		  if (from >= WHEEL_SLOTS)
+			continue;
+		  idx = wheel_find_slot_(sched_wheel[level], from);
+		  if (idx < WHEEL_SLOTS)
+			break;
+	    }
+	    assert(level < WHEEL_LEVELS);
+
+	    struct event_wheel_level_s&lev = sched_wheel[level];
+	    struct event_time_s*list = lev.head[idx];
+	    lev.head[idx] = 0;
+	    lev.tail[idx] = 0;
+	    lev.map[idx / WHEEL_MAP_BITS] &= ~(1U << (idx % WHEEL_MAP_BITS));
+
+	      /* Move the wheel time to the start of the slot. The
+		 digits above this level are unchanged, and the digits
+		 below are all zero. */
+	    unsigned shift = level * WHEEL_BITS;
+	    vvp_time64_t keep = 0;
+	    if (shift + WHEEL_BITS < WHEEL_TIME_BITS)
+		  keep = sched_wheel_time & (~(vvp_time64_t)0 << (shift + WHEEL_BITS));
+	    sched_wheel_time = keep | ((vvp_time64_t)idx << shift);
+
+	    while (list) {
+		  struct event_time_s*ctim = list;
+		  list = ctim->next;
+
+		  unsigned nlevel = wheel_level_(ctim->time);
+		  unsigned nidx = wheel_slot_(ctim->time, nlevel);
+		  assert(nlevel < level);
+		  struct event_time_s*tail = sched_wheel[nlevel].tail[nidx];
+		  if (nlevel == 0 && tail) {
+			merge_event_time_(tail, ctim);
+			sched_wheel_count -= 1;
+		  } else {
+			wheel_append_(ctim, nlevel, nidx);
+		  }
+	    }
+      }
+}
 
 /*
  * This is a list of initialization events. The setup puts
@@ -664,61 +903,26 @@ static void schedule_final_event(struct event_s*cur)
 typedef enum event_queue_e { SEQ_START, SEQ_ACTIVE, SEQ_NBASSIGN,
 			     SEQ_RWSYNC, SEQ_ROSYNC, DEL_THREAD } event_queue_t;
 
+static vvp_time64_t schedule_time;
+
 static void schedule_event_(struct event_s*cur, vvp_time64_t delay,
 			    event_queue_t select_queue)
 {
       cur->next = cur;
 
-      struct event_time_s*ctim = sched_list;
-
-      if (sched_list == 0) {
-	      /* Is the event_time list completely empty? Create the
-		 first event_time object. */
-	    ctim = new struct event_time_s;
-	    ctim->delay = delay;
-	    ctim->next  = 0;
-	    sched_list = ctim;
+      struct event_time_s*ctim;
 
-      } else if (sched_list->delay > delay) {
-
-	      /* Am I looking for an event before the first event_time?
-		 If so, create a new event_time to go in front. */
-	    struct event_time_s*tmp = new struct event_time_s;
-	    tmp->delay = delay;
-	    tmp->next = ctim;
-	    ctim->delay -= delay;
-	    ctim = tmp;
-	    sched_list = ctim;
+      if (delay > 0) {
+	    ctim = wheel_get_(schedule_time + delay);
 
       } else {
-	    struct event_time_s*prev = 0;
-
-	    while (ctim->next && (ctim->delay < delay)) {
-		  delay -= ctim->delay;
-		  prev = ctim;
-		  ctim = ctim->next;
-	    }
-
-	    if (ctim->delay > delay) {
-		  struct event_time_s*tmp = new struct event_time_s;
-		  tmp->delay = delay;
-		  tmp->next  = prev->next;
-		  prev->next = tmp;
-
-		  tmp->next->delay -= delay;
-		  ctim = tmp;
-
-	    } else if (ctim->delay == delay) {
-
-	    } else {
-		  assert(ctim->next == 0);
-		  struct event_time_s*tmp = new struct event_time_s;
-		  tmp->delay = delay - ctim->delay;
-		  tmp->next = 0;
-		  ctim->next = tmp;
-
-		  ctim = tmp;
+	      /* If we are between time steps, then create a new time
+		 step for the current time. */
+	    if (sched_current == 0) {
+		  sched_current = new struct event_time_s;
+		  sched_current->time = schedule_time;
 	    }
+	    ctim = sched_current;
       }
 
 	/* By this point, ctim is the event_time structure that is to
@@ -765,12 +969,12 @@ static void schedule_event_(struct event_s*cur, vvp_time64_t delay,
 
 static void schedule_event_push_(struct event_s*cur)
 {
-      if ((sched_list == 0) || (sched_list->delay > 0)) {
+      if (sched_current == 0) {
 	    schedule_event_(cur, 0, SEQ_ACTIVE);
 	    return;
       }
 
-      struct event_time_s*ctim = sched_list;
+      struct event_time_s*ctim = sched_current;
 
       if (ctim->active == 0) {
 	    cur->next = cur;
@@ -971,8 +1175,48 @@ void schedule_generic(vvp_gen_event_t obj, vvp_time64_t delay,
 
 static bool sim_started;
 
+/*
+ * Take the run of events at the front of the active queue that may be
+ * evaluated in parallel and pass them to parallel_run_batch(). Return
+ * false if the first event is not one of them.
+ */
+static const size_t PARALLEL_BATCH_MAX = 4096;
+
+static bool schedule_parallel_batch_(struct event_time_s*ctim)
+{
+      static std::vector<vvp_gen_event_t> objs;
+      objs.clear();
+
+      while (ctim->active && objs.size() < PARALLEL_BATCH_MAX) {
+	    struct event_s*cur = ctim->active->next;
+	    vvp_gen_event_t obj = cur->parallel_obj();
+	    if (obj == 0 || !parallel_event_ok(obj))
+		  break;
+
+	    if (cur->next == cur) {
+		  ctim->active = 0;
+	    } else {
+		  ctim->active->next = cur->next;
+	    }
+	    delete cur;
+	    objs.push_back(obj);
+      }
+
+      if (objs.empty())
+	    return false;
+
+      count_gen_events += objs.size();
+      parallel_run_batch(objs);
+      return true;
+}
+
 void schedule_functor(vvp_gen_event_t obj)
 {
+      if (vvp_parallel_active) {
+	    parallel_defer_functor(obj);
+	    return;
+      }
+
       struct generic_event_s*cur = new generic_event_s;
 
       cur->obj = obj;
@@ -993,7 +1237,6 @@ void schedule_at_start_of_simtime(vvp_gen_event_t obj, vvp_time64_t delay)
       schedule_event_(cur, delay, SEQ_START);
 }
 
-static vvp_time64_t schedule_time;
 vvp_time64_t schedule_simtime(void)
 { return schedule_time; }
 
@@ -1050,6 +1293,27 @@ static void run_rosync(struct event_time_s*ctim)
       }
 }
 
+static bool checkpoint_pending = false;
+static vvp_time64_t checkpoint_time = 0;
+
+void schedule_checkpoint(vvp_time64_t at)
+{
+      checkpoint_pending = true;
+      checkpoint_time = at;
+}
+
+/*
+ * This is called just before a time step starts to run, to take the
+ * pending checkpoint if its time has come.
+ */
+static void schedule_checkpoint_check_(void)
+{
+      if (checkpoint_pending && schedule_time >= checkpoint_time) {
+	    checkpoint_pending = false;
+	    checkpoint_take();
+      }
+}
+
 void schedule_simulate(void)
 {
       bool run_finals;
@@ -1084,6 +1348,11 @@ void schedule_simulate(void)
 	    vpi_mcd_printf(1, " ...execute StartOfSim callbacks\n");
       }
 
+	// A checkpoint at time 0 is taken before the start of
+	// simulation callbacks and before any time 0 event runs.
+      if (schedule_runnable)
+	    schedule_checkpoint_check_();
+
       // Execute start of simulation callbacks
       vpiStartOfSim();
 
@@ -1099,7 +1368,7 @@ void schedule_simulate(void)
       // process events and when done run the final blocks.
       run_finals = schedule_runnable;
 
-      if (schedule_runnable) while (sched_list) {
+      if (schedule_runnable) while (sched_current || sched_wheel_count) {
 
 	    if (schedule_stopped_flag) {
 		  schedule_stopped_flag = false;
@@ -1109,37 +1378,40 @@ void schedule_simulate(void)
 		  continue;
 	    }
 
-	      /* ctim is the current time step. */
-	    struct event_time_s* ctim = sched_list;
-
-	      /* If the time is advancing, then first run the
-		 postponed sync events. Run them all. */
-	    if (ctim->delay > 0) {
+	      /* If the current time step is done, then advance to the
+		 next time step and first run the postponed sync
+		 events. Run them all. */
+	    if (sched_current == 0) {
 
 		  if (!schedule_runnable) break;
-		  schedule_time += ctim->delay;
+		  sched_current = wheel_pop_();
+		  schedule_time = sched_current->time;
+
+		  schedule_checkpoint_check_();
+
 		    /* When the design is being traced (we are emitting
 		     * file/line information) also print any time changes. */
 		  if (show_file_line) {
 			cerr << "Advancing to simulation time: "
 			     << schedule_time << endl;
 		  }
-		  ctim->delay = 0;
 
 		  vpiNextSimTime();
 		    // Process the cbAtStartOfSimTime callbacks.
-		  while (ctim->start) {
-			struct event_s*cur = ctim->start->next;
+		  while (sched_current->start) {
+			struct event_s*cur = sched_current->start->next;
 			if (cur->next == cur) {
-			      ctim->start = 0;
+			      sched_current->start = 0;
 			} else {
-			      ctim->start->next = cur->next;
+			      sched_current->start->next = cur->next;
 			}
 			cur->run_run();
 			delete (cur);
 		  }
 	    }
 
+	      /* ctim is the current time step. */
+	    struct event_time_s* ctim = sched_current;
 
 	      /* If there are no more active events, advance the event
 		 queues. If there are not events at all, then release
@@ -1157,13 +1429,19 @@ void schedule_simulate(void)
 			     deletes threads as needed. */
 			if (ctim->active == 0) {
 			      run_rosync(ctim);
-			      sched_list = ctim->next;
+			      sched_current = 0;
 			      delete ctim;
 			      continue;
 			}
 		  }
 	    }
 
+	      /* With -t, runs of gate events are passed to the
+		 parallel evaluation. */
+	    if (parallel_enabled() && !schedule_single_step_flag
+		&& schedule_parallel_batch_(ctim))
+		  continue;
+
 	      /* Pull the first item off the list. If this is the last
 		 cell in the list, then clear the list. Execute that
 		 event type, and delete it. */
@@ -149,6 +149,11 @@ struct vvp_gen_event_s
       virtual ~vvp_gen_event_s() =0;
       virtual void run_run() =0;
       virtual void single_step_display(void);
+
+	// Gate functors that schedule themselves return their net
+	// here, so that the parallel evaluation (see parallel.h) can
+	// tell which partition they are in. Others return 0.
+      virtual vvp_net_t* parallel_net(void);
 };
 
 /*
@@ -157,6 +162,16 @@ struct vvp_gen_event_s
  */
 extern void schedule_simulate(void);
 
+/*
+ * Arrange for a checkpoint (see checkpoint.h) to be taken when the
+ * simulation is about to start the first time step at or after the
+ * given simulation time. All the events of earlier time steps will
+ * have been run, and none of the events of the new time step. A
+ * checkpoint at time 0 is taken before the start of simulation
+ * callbacks.
+ */
+extern void schedule_checkpoint(vvp_time64_t at);
+
 /*
  * Get the current absolute simulation time. This is not used
  * internally by the scheduler (which uses time differences instead)
@@ -23,12 +23,16 @@
  * This is a count of the instruction opcodes that were created.
  */
 unsigned long count_opcodes = 0;
+unsigned long count_opcodes_fused = 0;
 
 unsigned long count_functors = 0;
 unsigned long count_functors_logic = 0;
 unsigned long count_functors_bufif = 0;
 unsigned long count_functors_resolv= 0;
 unsigned long count_functors_sig   = 0;
+unsigned long count_functors_fused = 0;
+unsigned long count_functors_removed = 0;
+unsigned long count_functors_two_state = 0;
 
 unsigned long count_filters = 0;
 unsigned long count_vpi_nets = 0;
@@ -27,11 +27,15 @@
 #endif
 
 extern unsigned long count_opcodes;
+extern unsigned long count_opcodes_fused;
 extern unsigned long count_functors;
 extern unsigned long count_functors_logic;
 extern unsigned long count_functors_bufif;
 extern unsigned long count_functors_resolv;
 extern unsigned long count_functors_sig;
+extern unsigned long count_functors_fused;
+extern unsigned long count_functors_removed;
+extern unsigned long count_functors_two_state;
 extern unsigned long count_filters;
 extern unsigned long count_vvp_nets;
 extern unsigned long count_vpi_nets;
@@ -58,6 +62,15 @@ extern unsigned long count_assign_arword_pool(void);
 extern unsigned long count_gen_events;
 extern unsigned long count_gen_pool(void);
 
+  /* Word arrays allocated for wide vvp_vector4_t values, and the
+     number of times a freed array was reused instead. */
+extern unsigned long count_vec4_word_allocs;
+extern unsigned long count_vec4_word_reuse;
+
+  /* Count the partitions of the parallel evaluation (vvp -t), and
+     return the size of the largest one in the largest argument. */
+extern unsigned long count_net_partitions(unsigned long&largest);
+
 extern size_t size_opcodes;
 extern size_t size_vvp_nets;
 extern size_t size_vvp_net_funs;
@@ -34,9 +34,12 @@
 #ifdef CHECK_WITH_VALGRIND
 #include  "vvp_cleanup.h"
 #endif
+# include  <algorithm>
 # include  <cstdio>
 # include  <cassert>
 # include  <cstdlib>
+# include  <cstring>
+# include  <vector>
 /*
  * Callback handles are created when the VPI function registers a
  * callback. The handle is stored by the run time, and it triggered
@@ -392,6 +395,202 @@ static struct __vpiCallback* make_afterdelay(p_cb_data data, bool simtime_flag)
       return obj;
 }
 
+/*
+ * A batched value change callback is an ordinary value change
+ * callback whose cb_rtn is batch_value_change. The per-change work is
+ * only to mark the object as changed and, for the first change of the
+ * time step, to schedule a read-only synch event for the batch. That
+ * event calls the user's cb_rtn once with all the changed objects.
+ */
+struct batch_group_s;
+
+struct batch_member_s {
+      batch_group_s*group;
+      vpiHandle obj;
+      bool changed;
+};
+
+struct batch_sync_cb : public vvp_gen_event_s {
+      batch_group_s*group;
+      virtual void run_run();
+};
+
+struct batch_group_s {
+      PLI_INT32 (*cb_rtn)(struct t_cb_data*cb);
+      char*user_data;
+      PLI_INT32 time_type;
+      PLI_INT32 value_format;
+      bool scheduled;
+      batch_sync_cb sync;
+      std::vector<batch_member_s*> changed;
+};
+
+static std::vector<batch_group_s*> batch_groups;
+
+static PLI_INT32 batch_value_change(struct t_cb_data*cb)
+{
+      batch_member_s*member = reinterpret_cast<batch_member_s*>(cb->user_data);
+      if (member->changed)
+	    return 0;
+
+      member->changed = true;
+      batch_group_s*group = member->group;
+      group->changed.push_back(member);
+      if (! group->scheduled) {
+	    group->scheduled = true;
+	    schedule_generic(&group->sync, 0, true, true);
+      }
+      return 0;
+}
+
+/*
+ * vpi_get_value returns strings and vectors in a buffer that the next
+ * call reuses, so each value of the batch is copied out before the
+ * next one is read.
+ */
+struct batch_value_copy_s {
+      std::vector<char> str;
+      std::vector<s_vpi_vecval> vec;
+      std::vector<s_vpi_strengthval> strength;
+      s_vpi_time time;
+};
+
+static void batch_keep_value(vpiHandle obj, s_vpi_value&val,
+			     batch_value_copy_s&copy)
+{
+      switch (val.format) {
+	  case vpiBinStrVal:
+	  case vpiOctStrVal:
+	  case vpiDecStrVal:
+	  case vpiHexStrVal:
+	  case vpiStringVal:
+	    copy.str.assign(val.value.str,
+			    val.value.str + strlen(val.value.str) + 1);
+	    val.value.str = &copy.str[0];
+	    break;
+	  case vpiVectorVal: {
+		unsigned words = (vpi_get(vpiSize, obj) + 31) / 32;
+		copy.vec.assign(val.value.vector, val.value.vector + words);
+		val.value.vector = &copy.vec[0];
+		break;
+	  }
+	  case vpiStrengthVal: {
+		unsigned wid = vpi_get(vpiSize, obj);
+		copy.strength.assign(val.value.strength, val.value.strength + wid);
+		val.value.strength = &copy.strength[0];
+		break;
+	  }
+	  case vpiTimeVal:
+	    copy.time = *val.value.time;
+	    val.value.time = &copy.time;
+	    break;
+	  default:
+	    break;
+      }
+}
+
+void batch_sync_cb::run_run()
+{
+      batch_group_s*cur = group;
+      cur->scheduled = false;
+
+	/* All the members that changed may have been removed since
+	   the event was scheduled. */
+      size_t count = cur->changed.size();
+      if (count == 0)
+	    return;
+
+      std::vector<vpiHandle> objs (count);
+      std::vector<s_vpi_value> values;
+      std::vector<batch_value_copy_s> copies;
+      for (size_t idx = 0 ; idx < count ; idx += 1) {
+	    objs[idx] = cur->changed[idx]->obj;
+	    cur->changed[idx]->changed = false;
+      }
+      cur->changed.clear();
+
+      if (cur->value_format != vpiSuppressVal) {
+	    values.resize(count);
+	    copies.resize(count);
+	    for (size_t idx = 0 ; idx < count ; idx += 1) {
+		  values[idx].format = cur->value_format;
+		  vpi_get_value(objs[idx], &values[idx]);
+		  batch_keep_value(objs[idx], values[idx], copies[idx]);
+	    }
+      }
+
+      s_vpi_time cb_time;
+      cb_time.type = cur->time_type;
+      if (cb_time.type == vpiSimTime)
+	    vpip_time_to_timestruct(&cb_time, schedule_simtime());
+
+      s_cb_batch_data data;
+      data.cb.reason = _cbValueChangeBatch;
+      data.cb.cb_rtn = cur->cb_rtn;
+      data.cb.obj = 0;
+      data.cb.time = &cb_time;
+      data.cb.value = 0;
+      data.cb.index = count;
+      data.cb.user_data = cur->user_data;
+      data.count = count;
+      data.objs = count? &objs[0] : 0;
+      data.values = values.empty()? 0 : &values[0];
+
+      assert(vpi_mode_flag == VPI_MODE_NONE);
+      vpi_mode_flag = VPI_MODE_ROSYNC;
+      (cur->cb_rtn)(&data.cb);
+      vpi_mode_flag = VPI_MODE_NONE;
+}
+
+static value_callback* make_value_change_batch(p_cb_data data)
+{
+      if (data->time && data->time->type != vpiSimTime
+	  && data->time->type != vpiSuppressTime) {
+	    fprintf(stderr, "vpi error: batched value change callbacks "
+		    "only support vpiSimTime or vpiSuppressTime.\n");
+	    return 0;
+      }
+
+      batch_group_s*group = 0;
+      for (size_t idx = 0 ; idx < batch_groups.size() ; idx += 1) {
+	    if (batch_groups[idx]->cb_rtn == data->cb_rtn
+		&& batch_groups[idx]->user_data == data->user_data) {
+		  group = batch_groups[idx];
+		  break;
+	    }
+      }
+
+      if (group == 0) {
+	    group = new batch_group_s;
+	    group->cb_rtn = data->cb_rtn;
+	    group->user_data = data->user_data;
+	    group->time_type = data->time? data->time->type : vpiSuppressTime;
+	    group->value_format = data->value? data->value->format : vpiSuppressVal;
+	    group->scheduled = false;
+	    group->sync.group = group;
+	    batch_groups.push_back(group);
+      }
+
+      batch_member_s*member = new batch_member_s;
+      member->group = group;
+      member->obj = data->obj;
+      member->changed = false;
+
+	/* The per-change callback only marks the member, so it needs
+	   neither the time nor the value. */
+      s_cb_data member_data = *data;
+      member_data.reason = cbValueChange;
+      member_data.cb_rtn = batch_value_change;
+      member_data.time = 0;
+      member_data.value = 0;
+      member_data.user_data = reinterpret_cast<char*>(member);
+
+      value_callback*obj = make_value_change(&member_data);
+      if (obj == 0)
+	    delete member;
+      return obj;
+}
+
 /*
  * The following functions are the used for pre and post simulation
  * callbacks.
@@ -560,6 +759,10 @@ vpiHandle vpi_register_cb(p_cb_data data)
 	    obj = make_value_change(data);
 	    break;
 
+	  case _cbValueChangeBatch:
+	    obj = make_value_change_batch(data);
+	    break;
+
 	  case cbReadOnlySynch:
 	    obj = make_sync(data, true);
 	    break;
@@ -596,17 +799,51 @@ vpiHandle vpi_register_cb(p_cb_data data)
 /*
  * Removing a callback doesn't really delete it right away. Instead,
  * it clears the reference to the user callback function. This causes
- * the callback to quietly reap itself.
+ * the callback to quietly reap itself. The member of a batched value
+ * change callback is owned by the callback, so it is released here.
  */
 PLI_INT32 vpi_remove_cb(vpiHandle ref)
 {
       struct __vpiCallback*obj = dynamic_cast<__vpiCallback*>(ref);
       assert(obj);
+
+      if (obj->cb_data.cb_rtn == batch_value_change) {
+	    batch_member_s*member = reinterpret_cast<batch_member_s*>(obj->cb_data.user_data);
+	    std::vector<batch_member_s*>&changed = member->group->changed;
+	    std::vector<batch_member_s*>::iterator cur
+		  = std::find(changed.begin(), changed.end(), member);
+	    if (cur != changed.end())
+		  changed.erase(cur);
+	    delete member;
+	    obj->cb_data.user_data = 0;
+      }
+
       obj->cb_data.cb_rtn = 0;
 
       return 1;
 }
 
+/*
+ * Return the callback data as the user registered it. A batched
+ * value change callback is registered internally with its own
+ * cb_rtn and user_data, so report those of the batch instead.
+ */
+void vpi_get_cb_info(vpiHandle ref, p_cb_data data)
+{
+      struct __vpiCallback*obj = dynamic_cast<__vpiCallback*>(ref);
+      assert(obj);
+      assert(data);
+
+      *data = obj->cb_data;
+
+      if (obj->cb_data.cb_rtn == batch_value_change) {
+	    batch_member_s*member = reinterpret_cast<batch_member_s*>(obj->cb_data.user_data);
+	    data->reason = _cbValueChangeBatch;
+	    data->cb_rtn = member->group->cb_rtn;
+	    data->user_data = member->group->user_data;
+      }
+}
+
 void callback_execute(struct __vpiCallback*cur)
 {
       const vpi_mode_t save_mode = vpi_mode_flag;
@@ -638,6 +875,7 @@ void callback_execute(struct __vpiCallback*cur)
 
 vvp_vpi_callback::vvp_vpi_callback()
 {
+      generation_ = 0;
       vpi_callbacks_ = 0;
       array_ = 0;
       array_word_ = 0;
@@ -682,6 +920,7 @@ void vvp_vpi_callback::clear_all_callbacks()
  */
 void vvp_vpi_callback::run_vpi_callbacks()
 {
+      generation_ += 1;
       if (array_) array_->word_change(array_word_);
 
       value_callback *next = vpi_callbacks_;
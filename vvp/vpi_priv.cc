@@ -20,6 +20,8 @@
 # include  "version_base.h"
 # include  "vpi_priv.h"
 # include  "schedule.h"
+# include  "vvp_net_sig.h"
+# include  "symbols.h"
 #ifdef CHECK_WITH_VALGRIND
 # include  "vvp_cleanup.h"
 #endif
@@ -586,6 +588,12 @@ void vpi_set_vlog_info(int argc, char** argv)
     }
 }
 
+void vpip_set_vlog_args(int argc, char**argv)
+{
+      vpi_vlog_info.argc = argc;
+      vpi_vlog_info.argv = argv;
+}
+
 static void vec4_get_value_string(const vvp_vector4_t&word_val, unsigned width,
 				  s_vpi_value*vp)
 {
@@ -1264,11 +1272,103 @@ vpiHandle vpi_handle_by_index(vpiHandle ref, PLI_INT32 idx)
       return ref->vpi_index(idx);
 }
 
+/*
+ * The name index maps the full hierarchical name of every scope and
+ * every (non-port) scope item to its handle. It is built the first
+ * time vpi_handle_by_name is used, after the design is compiled, so
+ * that resolving many names does not search the scopes linearly. The
+ * index only ever holds the first of several objects with the same
+ * name, and names that are not in the index (array words, for
+ * example) are still found by searching the scopes.
+ */
+static symbol_map_s<__vpiHandle>*name_index = 0;
+
+static void name_index_add_(const std::string&key, __vpiHandle*item)
+{
+      if (name_index->sym_get_value(key.c_str()) == 0)
+	    name_index->sym_set_value(key.c_str(), item);
+}
+
+static void name_index_scope_(__vpiScope*scope, const std::string&path)
+{
+      for (unsigned idx = 0 ;  idx < scope->intern.size() ;  idx += 1) {
+	    __vpiHandle*item = scope->intern[idx];
+	    if (item->get_type_code() == vpiPort)
+		  continue;
+	    const char*nm = item->vpi_get_str(vpiName);
+	    if (nm == 0)
+		  continue;
+
+	    std::string key = path + "." + nm;
+	    name_index_add_(key, item);
+	    if (__vpiScope*sub = dynamic_cast<__vpiScope*>(item))
+		  name_index_scope_(sub, key);
+      }
+}
+
+static void name_index_build_(void)
+{
+      name_index = new symbol_map_s<__vpiHandle>;
+
+      __vpiHandle**roots;
+      unsigned nroots;
+      vpip_make_root_iterator(roots, nroots);
+      for (unsigned idx = 0 ;  idx < nroots ;  idx += 1) {
+	    __vpiScope*scope = dynamic_cast<__vpiScope*>(roots[idx]);
+	    if (scope == 0)
+		  continue;
+	    std::string key = scope->scope_name();
+	    name_index_add_(key, scope);
+	    name_index_scope_(scope, key);
+      }
+}
+
+static void name_index_path_(__vpiScope*scope, std::string&path)
+{
+      if (scope->scope) {
+	    name_index_path_(scope->scope, path);
+	    path += ".";
+      }
+      path += scope->scope_name();
+}
+
+/*
+ * Look up the name relative to the scope (or the root if the scope
+ * is nil) in the name index. Return 0 if the index is not usable or
+ * does not have the name.
+ */
+static vpiHandle name_index_find_(const char*name, vpiHandle handle)
+{
+      if (vpi_mode_flag == VPI_MODE_REGISTER)
+	    return 0;
+
+      std::string key;
+      if (handle) {
+	    __vpiScope*scope = dynamic_cast<__vpiScope*>(handle);
+	    if (scope == 0)
+		  return 0;
+	    name_index_path_(scope, key);
+	    key += ".";
+      }
+      key += name;
+
+      if (name_index == 0)
+	    name_index_build_();
+
+      return name_index->sym_get_value(key.c_str());
+}
+
 static vpiHandle find_name(const char *name, vpiHandle handle)
 {
       vpiHandle rtn = 0;
       __vpiScope*ref = dynamic_cast<__vpiScope*>(handle);
 
+      if (vpiHandle item = name_index_find_(name, handle))
+	    return item;
+
+      if (ref == 0)
+	    return 0;
+
       /* check module names */
       if (!strcmp(name, vpi_get_str(vpiName, handle)))
 	    rtn = handle;
@@ -1304,8 +1404,36 @@ static vpiHandle find_name(const char *name, vpiHandle handle)
       return rtn;
 }
 
+/*
+ * These are the objects that vpi_iterate(vpiInternalScope, ...)
+ * returns, and so the only scopes that find_scope may find below the
+ * root. At the root, find_scope may also find any root scope.
+ */
+static bool is_internal_scope_(vpiHandle item)
+{
+      switch (item->get_type_code()) {
+	  case vpiModule:
+	  case vpiGenScope:
+	  case vpiFunction:
+	  case vpiTask:
+	  case vpiNamedBegin:
+	  case vpiNamedFork:
+	    return true;
+	  default:
+	    return false;
+      }
+}
+
 static vpiHandle find_scope(const char *name, vpiHandle handle, int depth)
 {
+      if (depth == 0) {
+	    vpiHandle item = name_index_find_(name, handle);
+	    if (item && is_internal_scope_(item))
+		  return item;
+	    __vpiScope*root = dynamic_cast<__vpiScope*>(item);
+	    if (handle == 0 && root && root->scope == 0)
+		  return item;
+      }
 
       vpiHandle iter = handle==0
 	    ? vpi_iterate(vpiModule, NULL)
@@ -1621,3 +1749,29 @@ extern "C" void vpip_count_drivers(vpiHandle ref, unsigned idx,
       assert(rfp);
       rfp->node->count_drivers(idx, counts);
 }
+
+/*
+ * Give the VPI client direct read access to the value of a vector
+ * signal. Only signals that keep their value in a vvp_wire_vec4 (that
+ * is, statically allocated 4-value variables and nets without
+ * strength) have such storage.
+ */
+extern "C" PLI_INT32 vpip_vector_view(vpiHandle ref, p_vpip_vector_view view)
+{
+      struct __vpiSignal*rfp = dynamic_cast<__vpiSignal*>(ref);
+      if (rfp == 0)
+	    return 0;
+
+      vvp_wire_vec4*wire = dynamic_cast<vvp_wire_vec4*>(rfp->node->fil);
+      if (wire == 0)
+	    return 0;
+
+      const vvp_vector4_t&bits = wire->driven_vec4();
+      const unsigned word_bits = 8 * sizeof(unsigned long);
+      view->size = bits.size();
+      view->words = (bits.size() + word_bits - 1) / word_bits;
+      view->abits = bits.abits_words();
+      view->bbits = bits.bbits_words();
+      view->generation = wire->generation();
+      return 1;
+}
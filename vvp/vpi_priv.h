@@ -868,6 +868,13 @@ vpiHandle vpip_make_vthr_APV(char*label, unsigned index, unsigned bit, unsigned
  */
 extern void vpip_load_module(const char*name);
 
+/*
+ * Replace the extended arguments (the design file and the plusargs)
+ * that vpi_get_vlog_info reports. This is used when a checkpoint is
+ * restored with a different set of plusargs.
+ */
+extern void vpip_set_vlog_args(int argc, char**argv);
+
 # define VPIP_MODULE_PATH_MAX 64
 extern const char* vpip_module_path[64];
 extern unsigned vpip_module_path_cnt;
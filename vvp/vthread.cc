@@ -28,6 +28,7 @@
 # include  "vvp_cobject.h"
 # include  "vvp_darray.h"
 # include  "class_type.h"
+# include  "profile.h"
 #ifdef CHECK_WITH_VALGRIND
 # include  "vvp_cleanup.h"
 #endif
@@ -42,6 +43,8 @@
 
 # include  <iostream>
 # include  <cstdio>
+# include  <ctime>
+# include  <sys/time.h>
 
 using namespace std;
 
@@ -124,7 +127,9 @@ struct vthread_s {
       inline vvp_vector4_t pop_vec4(void)
       {
 	    assert(! stack_vec4_.empty());
-	    vvp_vector4_t val = stack_vec4_.back();
+	      // Take the value off the stack without copying the bits.
+	    vvp_vector4_t val;
+	    val.swap(stack_vec4_.back());
 	    stack_vec4_.pop_back();
 	    return val;
       }
@@ -132,6 +137,12 @@ struct vthread_s {
       {
 	    stack_vec4_.push_back(val);
       }
+#if __cplusplus >= 201103L
+      inline void push_vec4(vvp_vector4_t&&val)
+      {
+	    stack_vec4_.push_back(std::move(val));
+      }
+#endif
       inline const vvp_vector4_t& peek_vec4(unsigned depth)
       {
 	    unsigned size = stack_vec4_.size();
@@ -680,6 +691,52 @@ void vthread_delay_delete()
 	    running_thread->delay_delete = 1;
 }
 
+/*
+ * This is the inner loop of vthread_run when the profiler is on. It
+ * runs the thread until it pauses, as the normal loop does, counting
+ * every instruction and timing the whole run.
+ */
+static void vthread_run_profiled_(vthread_t thr)
+{
+      __vpiScope*scope = thr->parent_scope;
+      struct timeval wall_start;
+      gettimeofday(&wall_start, 0);
+      clock_t start = clock();
+      unsigned long count = 0;
+
+	/* Instructions are charged to the last %file_line statement
+	   executed in this run. */
+      vpiHandle line = 0;
+      unsigned long line_count = 0;
+
+      for (;;) {
+	    vvp_code_t cp = thr->pc;
+	    thr->pc += 1;
+
+	    count += 1;
+	    profile_opcode(cp->opcode);
+	    if (cp->opcode == &of_FILE_LINE) {
+		  if (line) profile_line(line, line_count);
+		  line = cp->handle;
+		  line_count = 0;
+		  profile_statement(line);
+	    }
+	    line_count += 1;
+
+	    bool rc = (cp->opcode)(thr, cp);
+	    if (rc == false)
+		  break;
+      }
+
+      if (line) profile_line(line, line_count);
+      clock_t stop = clock();
+      struct timeval wall_stop;
+      gettimeofday(&wall_stop, 0);
+      double wall = (wall_stop.tv_sec - wall_start.tv_sec)
+	    + (wall_stop.tv_usec - wall_start.tv_usec) / 1E6;
+      profile_scope(scope, count, wall, (double)(stop - start) / CLOCKS_PER_SEC);
+}
+
 /*
  * This function runs each thread by fetching an instruction,
  * incrementing the PC, and executing the instruction. The thread may
@@ -696,6 +753,12 @@ void vthread_run(vthread_t thr)
 
             running_thread = thr;
 
+	    if (profile_flag) {
+		  vthread_run_profiled_(thr);
+		  thr = tmp;
+		  continue;
+	    }
+
 	    for (;;) {
 		  vvp_code_t cp = thr->pc;
 		  thr->pc += 1;
@@ -3689,6 +3752,54 @@ bool of_LOAD_VEC4(vthread_t thr, vvp_code_t cp)
       return true;
 }
 
+/*
+ * %load/vec4 <net> ; %cmpi/e <vala>, <valb>, <wid>
+ *
+ * The fused form compares the signal value directly with the
+ * immediate value, without pushing it onto the vec4 stack. The
+ * %cmpi/e operands are in the next instruction.
+ */
+static void load_cmpie_(vthread_t thr, vvp_code_t cp)
+{
+      vvp_signal_value*sig = dynamic_cast<vvp_signal_value*> (cp[0].net->fil);
+      assert(sig);
+
+      vvp_vector4_t lval;
+      sig->vec4_value(lval);
+
+      vvp_vector4_t rval (cp[1].number, BIT4_0);
+      get_immediate_rval (cp+1, rval);
+
+      do_CMPE(thr, lval, rval);
+}
+
+bool of_LOAD_CMPIE(vthread_t thr, vvp_code_t cp)
+{
+      load_cmpie_(thr, cp);
+      thr->pc = cp + 2;
+      return true;
+}
+
+/*
+ * %load/vec4 <net> ; %cmpi/e <vala>, <valb>, <wid> ; %jmp/0xz <pc>, <flag>
+ */
+bool of_LOAD_CMPIE_JMP0XZ(vthread_t thr, vvp_code_t cp)
+{
+      load_cmpie_(thr, cp);
+      thr->pc = cp + 3;
+      return of_JMP0XZ(thr, cp + 2);
+}
+
+/*
+ * %load/vec4 <net> ; %cmpi/e <vala>, <valb>, <wid> ; %jmp/1xz <pc>, <flag>
+ */
+bool of_LOAD_CMPIE_JMP1XZ(vthread_t thr, vvp_code_t cp)
+{
+      load_cmpie_(thr, cp);
+      thr->pc = cp + 3;
+      return of_JMP1XZ(thr, cp + 2);
+}
+
 /*
  * %load/vec4a <arr>, <adrx>
  */
@@ -25,6 +25,7 @@
 # include  "resolv.h"
 # include  "schedule.h"
 # include  "statistics.h"
+# include  "parallel.h"
 # include  <cstdio>
 # include  <cstring>
 # include  <cstdlib>
@@ -33,9 +34,10 @@
 # include  <climits>
 # include  <cmath>
 # include  <cassert>
+# include  <map>
+# include  <vector>
 #ifdef CHECK_WITH_VALGRIND
 # include  <valgrind/memcheck.h>
-# include  <map>
 # include  "sfunc.h"
 # include  "udp.h"
 # include  "ivl_alloc.h"
@@ -57,6 +59,9 @@ static vvp_net_t **vvp_net_pool = NULL;
 static unsigned vvp_net_pool_count = 0;
 #endif
 static size_t vvp_net_alloc_remaining = 0;
+// All the chunks allocated so far, in allocation order. This is used
+// by vvp_net_t::for_each() to visit all the nets.
+static vector<vvp_net_t*> vvp_net_chunks;
 // For statistics, count the vvp_nets allocated and the bytes of alloc
 // chunks allocated.
 unsigned long count_vvp_nets = 0;
@@ -69,6 +74,7 @@ void* vvp_net_t::operator new (size_t size)
 	    vvp_net_alloc_table = ::new vvp_net_t[VVP_NET_CHUNK];
 	    vvp_net_alloc_remaining = VVP_NET_CHUNK;
 	    size_vvp_nets += size*VVP_NET_CHUNK;
+	    vvp_net_chunks.push_back(vvp_net_alloc_table);
 #ifdef CHECK_WITH_VALGRIND
 	    VALGRIND_MAKE_MEM_NOACCESS(vvp_net_alloc_table, size*VVP_NET_CHUNK);
 	    VALGRIND_CREATE_MEMPOOL(vvp_net_alloc_table, 0, 0);
@@ -91,6 +97,156 @@ void* vvp_net_t::operator new (size_t size)
       return return_this;
 }
 
+void vvp_net_t::for_each(void (*fun)(vvp_net_t*net, void*cd), void*cd)
+{
+      for (size_t idx = 0 ; idx < vvp_net_chunks.size() ; idx += 1) {
+	    vvp_net_t*chunk = vvp_net_chunks[idx];
+	    size_t cnt = VVP_NET_CHUNK;
+	    if (idx+1 == vvp_net_chunks.size())
+		  cnt -= vvp_net_alloc_remaining;
+	    for (size_t ndx = 0 ; ndx < cnt ; ndx += 1)
+		  fun(chunk+ndx, cd);
+      }
+}
+
+/*
+ * The net partitioning divides the functors that the parallel
+ * evaluation may run (see parallel_net_ok) into sets that are
+ * connected through their fan-out. Signals and all the other nets are
+ * the boundaries of the partitions, and are in none of them, so that
+ * a clock or reset that reaches the whole design does not join it
+ * into one partition. The partitions are found with a union-find over
+ * the net numbers, where a net is numbered by its position in the
+ * allocation chunks.
+ */
+struct net_partition_s {
+	// Map the base of each allocation chunk to its first net number.
+      map<vvp_net_t*,unsigned long> chunk_base;
+      vector<unsigned long> parent;
+      vector<unsigned long> size;
+	// Set for the nets that are in a partition.
+      vector<bool> member;
+
+      unsigned long number(vvp_net_t*net) const;
+      unsigned long find(unsigned long idx);
+      void join(unsigned long a, unsigned long b);
+};
+
+unsigned long net_partition_s::number(vvp_net_t*net) const
+{
+      map<vvp_net_t*,unsigned long>::const_iterator cur = chunk_base.upper_bound(net);
+      if (cur == chunk_base.begin())
+	    return ULONG_MAX;
+      -- cur;
+      if ((size_t)(net - cur->first) >= VVP_NET_CHUNK)
+	    return ULONG_MAX;
+
+      unsigned long idx = cur->second + (net - cur->first);
+      return idx < parent.size()? idx : ULONG_MAX;
+}
+
+unsigned long net_partition_s::find(unsigned long idx)
+{
+      while (parent[idx] != idx) {
+	    parent[idx] = parent[parent[idx]];
+	    idx = parent[idx];
+      }
+      return idx;
+}
+
+void net_partition_s::join(unsigned long a, unsigned long b)
+{
+      a = find(a);
+      b = find(b);
+      if (a == b) return;
+      if (size[a] < size[b]) {
+	    unsigned long tmp = a;
+	    a = b;
+	    b = tmp;
+      }
+      parent[b] = a;
+      size[a] += size[b];
+}
+
+static void net_partition_link(vvp_net_t*net, void*cd)
+{
+      if (! parallel_net_ok(net))
+	    return;
+
+      net_partition_s*part = static_cast<net_partition_s*>(cd);
+      unsigned long src = part->number(net);
+      part->member[src] = true;
+
+      vvp_net_ptr_t cur = net->fanout();
+      while (vvp_net_t*dst = cur.ptr()) {
+	    if (parallel_net_ok(dst))
+		  part->join(src, part->number(dst));
+	    cur = dst->port[cur.port()];
+      }
+}
+
+static void net_partition_build(net_partition_s&part)
+{
+      for (size_t idx = 0 ; idx < vvp_net_chunks.size() ; idx += 1)
+	    part.chunk_base[vvp_net_chunks[idx]] = idx * VVP_NET_CHUNK;
+
+      part.parent.resize(count_vvp_nets);
+      part.size.resize(count_vvp_nets, 1);
+      part.member.resize(count_vvp_nets, false);
+      for (unsigned long idx = 0 ; idx < count_vvp_nets ; idx += 1)
+	    part.parent[idx] = idx;
+
+      vvp_net_t::for_each(&net_partition_link, &part);
+}
+
+unsigned long count_net_partitions(unsigned long&largest)
+{
+      net_partition_s part;
+      largest = 0;
+
+      net_partition_build(part);
+
+      unsigned long count = 0;
+      for (unsigned long idx = 0 ; idx < count_vvp_nets ; idx += 1) {
+	    if (!part.member[idx] || part.parent[idx] != idx) continue;
+	    count += 1;
+	    if (part.size[idx] > largest) largest = part.size[idx];
+      }
+
+      return count;
+}
+
+/*
+ * The partitions that the parallel evaluation uses are made once,
+ * before the simulation starts. Every net then points straight at
+ * the root of its set, or holds ULONG_MAX if it is in no partition,
+ * so that looking up a partition does not change the table.
+ */
+static net_partition_s*net_partitions = 0;
+
+void vvp_net_t::make_partitions(void)
+{
+      delete net_partitions;
+      net_partitions = new net_partition_s;
+      net_partition_build(*net_partitions);
+
+      for (unsigned long idx = 0 ; idx < count_vvp_nets ; idx += 1) {
+	    if (net_partitions->member[idx])
+		  net_partitions->parent[idx] = net_partitions->find(idx);
+	    else
+		  net_partitions->parent[idx] = ULONG_MAX;
+      }
+}
+
+unsigned long vvp_net_t::partition(void)
+{
+      assert(net_partitions);
+      unsigned long idx = net_partitions->number(this);
+      if (idx == ULONG_MAX)
+	    return ULONG_MAX;
+      return net_partitions->parent[idx];
+}
+
 #ifdef CHECK_WITH_VALGRIND
 static map<vvp_net_t*, bool> vvp_net_map;
 static map<sfunc_core*, bool> sfunc_map;
@@ -197,8 +353,11 @@ vvp_net_t::vvp_net_t()
 void vvp_net_t::link(vvp_net_ptr_t port_to_link)
 {
       vvp_net_t*net = port_to_link.ptr();
-      net->port[port_to_link.port()] = out_;
-      out_ = port_to_link;
+	// With -t, links that leave a partition are made from the
+	// boundary of the net (see parallel.h).
+      vvp_net_t*src = parallel_link_source(this, net);
+      net->port[port_to_link.port()] = src->out_;
+      src->out_ = port_to_link;
 }
 
 /*
@@ -212,6 +371,12 @@ void vvp_net_t::unlink(vvp_net_ptr_t dst_ptr)
       vvp_net_t*net = dst_ptr.ptr();
       unsigned net_port = dst_ptr.port();
 
+      vvp_net_t*src = parallel_link_source(this, net);
+      if (src != this) {
+	    src->unlink(dst_ptr);
+	    return;
+      }
+
       if (out_ == dst_ptr) {
 	      /* If the drive fan-out list starts with this pointer,
 		 then the unlink is easy. Pull the list forward. */
@@ -691,6 +856,58 @@ void vvp_vector4_t::copy_bits(const vvp_vector4_t&that)
       }
 }
 
+/*
+ * The word arrays of vectors that are wider than a machine word, but
+ * no more than VVP_VECTOR4_POOL_WORDS words wide, are kept on free
+ * lists (one per word count) when the vector is destroyed, and
+ * reused by the next vector of that width. Procedural code on wide
+ * buses creates and destroys such vectors on the thread stack for
+ * nearly every instruction, so this saves a trip through the heap
+ * for each of them. The free arrays are linked through a pointer
+ * stored at their start. The lists are not shared with the parallel
+ * evaluation threads (vvp -t), so while they run the heap is used.
+ */
+#ifndef VVP_VECTOR4_POOL_WORDS
+# define VVP_VECTOR4_POOL_WORDS (256 / (8*sizeof(unsigned long)))
+#endif
+
+unsigned long count_vec4_word_allocs = 0;
+unsigned long count_vec4_word_reuse = 0;
+
+#ifndef CHECK_WITH_VALGRIND
+static unsigned long*vec4_word_pool[VVP_VECTOR4_POOL_WORDS+1];
+#endif
+
+unsigned long*vvp_vector4_t::alloc_words_(unsigned cnt)
+{
+#ifndef CHECK_WITH_VALGRIND
+      if (vvp_parallel_active)
+	    return new unsigned long[2*cnt];
+      if (cnt <= VVP_VECTOR4_POOL_WORDS && vec4_word_pool[cnt]) {
+	    unsigned long*res = vec4_word_pool[cnt];
+	    vec4_word_pool[cnt] = *reinterpret_cast<unsigned long**>(res);
+	    count_vec4_word_reuse += 1;
+	    return res;
+      }
+#endif
+      count_vec4_word_allocs += 1;
+      return new unsigned long[2*cnt];
+}
+
+void vvp_vector4_t::free_words_(unsigned long*ptr, unsigned cnt)
+{
+#ifndef CHECK_WITH_VALGRIND
+      if (cnt <= VVP_VECTOR4_POOL_WORDS && !vvp_parallel_active) {
+	    *reinterpret_cast<unsigned long**>(ptr) = vec4_word_pool[cnt];
+	    vec4_word_pool[cnt] = ptr;
+	    return;
+      }
+#else
+      (void)cnt;
+#endif
+      delete[]ptr;
+}
+
 /*
  * This function should ONLY BE CALLED FROM vvp_vector4_t::copy_from_,
  * as it performs part of that functions tasks.
@@ -698,7 +915,7 @@ void vvp_vector4_t::copy_bits(const vvp_vector4_t&that)
 void vvp_vector4_t::copy_from_big_(const vvp_vector4_t&that)
 {
       unsigned words = (size_+BITS_PER_WORD-1) / BITS_PER_WORD;
-      abits_ptr_ = new unsigned long[2*words];
+      abits_ptr_ = alloc_words_(words);
       bbits_ptr_ = abits_ptr_ + words;
 
       for (unsigned idx = 0 ;  idx < words ;  idx += 1)
@@ -717,7 +934,7 @@ void vvp_vector4_t::copy_inverted_from_(const vvp_vector4_t&that)
       size_ = that.size_;
       if (size_ > BITS_PER_WORD) {
 	    unsigned words = (size_+BITS_PER_WORD-1) / BITS_PER_WORD;
-	    abits_ptr_ = new unsigned long[2*words];
+	    abits_ptr_ = alloc_words_(words);
 	    bbits_ptr_ = abits_ptr_ + words;
 
 	    unsigned remaining = size_;
@@ -747,7 +964,7 @@ void vvp_vector4_t::allocate_words_(unsigned long inita, unsigned long initb)
 {
       if (size_ > BITS_PER_WORD) {
 	    unsigned cnt = (size_ + BITS_PER_WORD - 1) / BITS_PER_WORD;
-	    abits_ptr_ = new unsigned long[2*cnt];
+	    abits_ptr_ = alloc_words_(cnt);
 	    bbits_ptr_ = abits_ptr_ + cnt;
 	    for (unsigned idx = 0 ;  idx < cnt ;  idx += 1)
 		  abits_ptr_[idx] = inita;
@@ -997,7 +1214,7 @@ void vvp_vector4_t::resize(unsigned newsize, vvp_bit4_t pad_bit)
 		  return;
 	    }
 
-	    unsigned long*newbits = new unsigned long[2*newcnt];
+	    unsigned long*newbits = alloc_words_(newcnt);
 
 	    if (cnt > 1) {
 		  unsigned trans = cnt;
@@ -1009,7 +1226,7 @@ void vvp_vector4_t::resize(unsigned newsize, vvp_bit4_t pad_bit)
 		  for (unsigned idx = 0 ;  idx < trans ;  idx += 1)
 			newbits[newcnt+idx] = bbits_ptr_[idx];
 
-		  delete[]abits_ptr_;
+		  free_words_(abits_ptr_, cnt);
 
 	    } else {
 		  newbits[0] = abits_val_;
@@ -1037,7 +1254,7 @@ void vvp_vector4_t::resize(unsigned newsize, vvp_bit4_t pad_bit)
 	    if (cnt > 1) {
 		  unsigned long newvala = abits_ptr_[0];
 		  unsigned long newvalb = bbits_ptr_[0];
-		  delete[]abits_ptr_;
+		  free_words_(abits_ptr_, cnt);
 		  abits_val_ = newvala;
 		  bbits_val_ = newvalb;
 	    }
@@ -2967,16 +3184,13 @@ bool operator == (const vvp_vector2_t&a, const vvp_vector2_t&b)
 
 vvp_vector4_t vector2_to_vector4(const vvp_vector2_t&that, unsigned wid)
 {
-      vvp_vector4_t res (wid);
-
-      for (unsigned idx = 0 ;  idx < res.size() ;  idx += 1) {
-	    vvp_bit4_t bit = BIT4_0;
+      vvp_vector4_t res (wid, BIT4_0);
 
-	    if (that.value(idx))
-		  bit = BIT4_1;
-
-	    res.set_bit(idx, bit);
-      }
+	/* Copy the bits a word at a time. Bits past the end of that
+	   are left 0. */
+      unsigned cnt = that.wid_ < wid? that.wid_ : wid;
+      if (cnt > 0)
+	    res.setarray(0, cnt, that.vec_);
 
       return res;
 }
@@ -3347,6 +3561,11 @@ void vvp_net_fun_t::force_flag(bool)
 {
 }
 
+bool vvp_net_fun_t::parallel_safe(void) const
+{
+      return false;
+}
+
 /* **** vvp_fun_drive methods **** */
 
 vvp_fun_drive::vvp_fun_drive(unsigned str0, unsigned str1)
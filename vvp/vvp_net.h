@@ -267,9 +267,19 @@ class vvp_vector4_t {
       vvp_vector4_t(const vvp_vector4_t&that);
       vvp_vector4_t(const vvp_vector4_t&that, bool invert_flag);
       vvp_vector4_t& operator= (const vvp_vector4_t&that);
+#if __cplusplus >= 201103L
+	// Moving a vector takes over the word arrays instead of
+	// copying them. This lets containers of vectors (i.e. the
+	// thread vec4 stack) grow without reallocating every value.
+      vvp_vector4_t(vvp_vector4_t&&that) noexcept;
+      vvp_vector4_t& operator= (vvp_vector4_t&&that) noexcept;
+#endif
 
       ~vvp_vector4_t();
 
+	// Exchange the values of the vectors without copying the bits.
+      void swap(vvp_vector4_t&that);
+
       inline unsigned size() const { return size_; }
       void resize(unsigned new_size, vvp_bit4_t pad_bit = BIT4_X);
 
@@ -321,6 +331,13 @@ class vvp_vector4_t {
 	// Display the value into the buf as a string.
       char*as_string(char*buf, size_t buf_len) const;
 
+	// Read access to the abits and bbits words of the vector. A
+	// copy assignment of a vector of the same size keeps the
+	// words in place, so the pointers stay valid as long as the
+	// vector is only assigned values of its own size.
+      const unsigned long*abits_words() const;
+      const unsigned long*bbits_words() const;
+
       void invert();
       vvp_vector4_t& operator &= (const vvp_vector4_t&that);
       vvp_vector4_t& operator |= (const vvp_vector4_t&that);
@@ -354,9 +371,19 @@ class vvp_vector4_t {
       void copy_from_(const vvp_vector4_t&that);
       void copy_from_big_(const vvp_vector4_t&that);
       void copy_inverted_from_(const vvp_vector4_t&that);
+	// Take the value (and the word arrays) of that vector, and
+	// leave that vector empty.
+      void take_from_(vvp_vector4_t&that);
 
       void allocate_words_(unsigned long inita, unsigned long initb);
 
+	// Allocate/free the abits+bbits array of a vector with cnt
+	// words. The arrays of narrow multi-word vectors are
+	// recycled through free lists instead of going back to the
+	// heap.
+      static unsigned long*alloc_words_(unsigned cnt);
+      static void free_words_(unsigned long*ptr, unsigned cnt);
+
 	// Values in the vvp_vector4_t are stored split across two
 	// arrays. For each bit in the vector, there is an abit and a
 	// bbit. the encoding of a vvp_vector4_t is:
@@ -413,7 +440,7 @@ inline vvp_vector4_t::vvp_vector4_t(unsigned size__, vvp_bit4_t val)
 inline vvp_vector4_t::~vvp_vector4_t()
 {
       if (size_ > BITS_PER_WORD) {
-	    delete[] abits_ptr_;
+	    free_words_(abits_ptr_, (size_ + BITS_PER_WORD - 1) / BITS_PER_WORD);
 	      // bbits_ptr_ actually points half-way into a
 	      // double-length array started at abits_ptr_
       }
@@ -424,14 +451,33 @@ inline vvp_vector4_t& vvp_vector4_t::operator= (const vvp_vector4_t&that)
       if (this == &that)
 	    return *this;
 
+      if (size_ > BITS_PER_WORD && size_ == that.size_) {
+	    unsigned words = (size_ + BITS_PER_WORD - 1) / BITS_PER_WORD;
+	    for (unsigned idx = 0 ;  idx < words ;  idx += 1)
+		  abits_ptr_[idx] = that.abits_ptr_[idx];
+	    for (unsigned idx = 0 ;  idx < words ;  idx += 1)
+		  bbits_ptr_[idx] = that.bbits_ptr_[idx];
+	    return *this;
+      }
+
       if (size_ > BITS_PER_WORD)
-	    delete[] abits_ptr_;
+	    free_words_(abits_ptr_, (size_ + BITS_PER_WORD - 1) / BITS_PER_WORD);
 
       copy_from_(that);
 
       return *this;
 }
 
+inline const unsigned long* vvp_vector4_t::abits_words() const
+{
+      return size_ > BITS_PER_WORD? abits_ptr_ : &abits_val_;
+}
+
+inline const unsigned long* vvp_vector4_t::bbits_words() const
+{
+      return size_ > BITS_PER_WORD? bbits_ptr_ : &bbits_val_;
+}
+
 inline void vvp_vector4_t::copy_from_(const vvp_vector4_t&that)
 {
       size_ = that.size_;
@@ -443,6 +489,44 @@ inline void vvp_vector4_t::copy_from_(const vvp_vector4_t&that)
       }
 }
 
+inline void vvp_vector4_t::take_from_(vvp_vector4_t&that)
+{
+      size_ = that.size_;
+      if (size_ > BITS_PER_WORD) {
+	    abits_ptr_ = that.abits_ptr_;
+	    bbits_ptr_ = that.bbits_ptr_;
+      } else {
+	    abits_val_ = that.abits_val_;
+	    bbits_val_ = that.bbits_val_;
+      }
+      that.size_ = 0;
+}
+
+#if __cplusplus >= 201103L
+inline vvp_vector4_t::vvp_vector4_t(vvp_vector4_t&&that) noexcept
+{
+      take_from_(that);
+}
+
+inline vvp_vector4_t& vvp_vector4_t::operator= (vvp_vector4_t&&that) noexcept
+{
+      if (this != &that) {
+	    if (size_ > BITS_PER_WORD)
+		  free_words_(abits_ptr_, (size_ + BITS_PER_WORD - 1) / BITS_PER_WORD);
+	    take_from_(that);
+      }
+      return *this;
+}
+#endif
+
+inline void vvp_vector4_t::swap(vvp_vector4_t&that)
+{
+      vvp_vector4_t tmp;
+      tmp.take_from_(*this);
+      take_from_(that);
+      that.take_from_(tmp);
+}
+
 inline vvp_bit4_t vvp_vector4_t::value(unsigned idx) const
 {
       if (idx >= size_)
@@ -657,6 +741,7 @@ class vvp_vector2_t {
       friend bool operator <  (const vvp_vector2_t&, const vvp_vector2_t&);
       friend bool operator <= (const vvp_vector2_t&, const vvp_vector2_t&);
       friend bool operator == (const vvp_vector2_t&, const vvp_vector2_t&);
+      friend vvp_vector4_t vector2_to_vector4(const vvp_vector2_t&, unsigned);
 
     public:
       vvp_vector2_t();
@@ -1152,6 +1237,24 @@ class vvp_net_t {
     public: // Method to support $countdrivers
       void count_drivers(unsigned idx, unsigned counts[4]);
 
+    public: // Methods to support passes over the whole netlist.
+	// Get the first input driven by this net. The rest of the
+	// fan-out is found by following the port[] links of the
+	// driven inputs.
+      vvp_net_ptr_t fanout() const { return out_; }
+
+	// Call the function for every vvp_net_t that was allocated
+	// with the vvp_net_t new operator, in allocation order.
+      static void for_each(void (*fun)(vvp_net_t*net, void*cd), void*cd);
+
+	// Divide the netlist into the partitions of the parallel
+	// evaluation (see parallel.h), and get the partition of this
+	// net. Nets that the parallel evaluation does not run, and
+	// nets that are made later, have no partition and get
+	// ULONG_MAX.
+      static void make_partitions(void);
+      unsigned long partition(void);
+
     private:
       vvp_net_ptr_t out_;
 
@@ -1230,6 +1333,13 @@ class vvp_net_fun_t {
 	// do something about it.
       virtual void force_flag(bool run_now);
 
+	// Return true if the recv_vec4 methods of this functor only
+	// change the state of the functor itself, and then either
+	// send the result to the output or schedule_functor()
+	// themselves. Such functors may be run by the worker threads
+	// of the parallel evaluation (see parallel.h).
+      virtual bool parallel_safe(void) const;
+
    protected:
       void recv_vec4_pv_(vvp_net_ptr_t p, const vvp_vector4_t&bit,
 			 unsigned base, unsigned wid, unsigned vwid,
@@ -1382,12 +1492,17 @@ class vvp_fun_concat  : public vvp_net_fun_t {
 		     unsigned w2, unsigned w3);
       ~vvp_fun_concat();
 
+      unsigned port_width(unsigned idx) const { return wid_[idx]; }
+
       void recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
                      vvp_context_t context);
 
       void recv_vec4_pv(vvp_net_ptr_t port, const vvp_vector4_t&bit,
 			unsigned base, unsigned wid, unsigned vwid,
                         vvp_context_t);
+
+      bool parallel_safe(void) const;
+
     private:
       unsigned wid_[4];
       vvp_vector4_t val_;
@@ -1451,6 +1566,8 @@ class vvp_fun_repeat  : public vvp_net_fun_t {
       void recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
                      vvp_context_t context);
 
+      bool parallel_safe(void) const;
+
     private:
       unsigned wid_;
       unsigned rep_;
@@ -1503,6 +1620,9 @@ class vvp_fun_extend_signed  : public vvp_net_fun_t {
       void recv_vec4_pv(vvp_net_ptr_t port, const vvp_vector4_t&bit,
 			unsigned base, unsigned wid, unsigned vwid,
                         vvp_context_t);
+
+      bool parallel_safe(void) const;
+
     private:
       unsigned width_;
 };
@@ -1683,6 +1803,14 @@ inline void vvp_send_vec8_pv(vvp_net_ptr_t ptr, const vvp_vector8_t&val,
       }
 }
 
+/*
+ * The profiler (see profile.h) counts the values that the filter of a
+ * net lets through. The filter is only present on signals, so this
+ * adds nothing to the propagation through plain functors.
+ */
+extern bool profile_flag;
+extern void profile_net_change(vvp_net_t*net);
+
 inline void vvp_net_t::send_vec4(const vvp_vector4_t&val, vvp_context_t context)
 {
       if (fil == 0) {
@@ -1695,9 +1823,11 @@ inline void vvp_net_t::send_vec4(const vvp_vector4_t&val, vvp_context_t context)
 	  case vvp_net_fil_t::STOP:
 	    break;
 	  case vvp_net_fil_t::PROP:
+	    if (profile_flag) profile_net_change(this);
 	    vvp_send_vec4(out_, val, context);
 	    break;
 	  case vvp_net_fil_t::REPL:
+	    if (profile_flag) profile_net_change(this);
 	    vvp_send_vec4(out_, rep, context);
 	    break;
       }
@@ -1718,9 +1848,11 @@ inline void vvp_net_t::send_vec4_pv(const vvp_vector4_t&val,
 	  case vvp_net_fil_t::STOP:
 	    break;
 	  case vvp_net_fil_t::PROP:
+	    if (profile_flag) profile_net_change(this);
 	    vvp_send_vec4_pv(out_, val, base, wid, vwid, context);
 	    break;
 	  case vvp_net_fil_t::REPL:
+	    if (profile_flag) profile_net_change(this);
 	    vvp_send_vec4_pv(out_, rep, base, wid, vwid, context);
 	    break;
       }
@@ -1738,9 +1870,11 @@ inline void vvp_net_t::send_vec8(const vvp_vector8_t&val)
 	  case vvp_net_fil_t::STOP:
 	    break;
 	  case vvp_net_fil_t::PROP:
+	    if (profile_flag) profile_net_change(this);
 	    vvp_send_vec8(out_, val);
 	    break;
 	  case vvp_net_fil_t::REPL:
+	    if (profile_flag) profile_net_change(this);
 	    vvp_send_vec8(out_, rep);
 	    break;
       }
@@ -1760,9 +1894,11 @@ inline void vvp_net_t::send_vec8_pv(const vvp_vector8_t&val,
 	  case vvp_net_fil_t::STOP:
 	    break;
 	  case vvp_net_fil_t::PROP:
+	    if (profile_flag) profile_net_change(this);
 	    vvp_send_vec8_pv(out_, val, base, wid, vwid);
 	    break;
 	  case vvp_net_fil_t::REPL:
+	    if (profile_flag) profile_net_change(this);
 	    vvp_send_vec8_pv(out_, rep, base, wid, vwid);
 	    break;
       }
@@ -1770,8 +1906,11 @@ inline void vvp_net_t::send_vec8_pv(const vvp_vector8_t&val,
 
 inline void vvp_net_t::send_real(double val, vvp_context_t context)
 {
-      if (fil && ! fil->filter_real(val))
-	    return;
+      if (fil) {
+	    if (! fil->filter_real(val))
+		  return;
+	    if (profile_flag) profile_net_change(this);
+      }
 
       vvp_send_real(out_, val, context);
 }
@@ -1779,8 +1918,11 @@ inline void vvp_net_t::send_real(double val, vvp_context_t context)
 
 inline void vvp_net_t::send_string(const std::string&val, vvp_context_t context)
 {
-      if (fil && !fil->filter_string(val))
-	    return;
+      if (fil) {
+	    if (! fil->filter_string(val))
+		  return;
+	    if (profile_flag) profile_net_change(this);
+      }
 
       vvp_send_string(out_, val, context);
 }
@@ -1788,8 +1930,11 @@ inline void vvp_net_t::send_string(const std::string&val, vvp_context_t context)
 
 inline void vvp_net_t::send_object(vvp_object_t val, vvp_context_t context)
 {
-      if (fil && ! fil->filter_object(val))
-	    return;
+      if (fil) {
+	    if (! fil->filter_object(val))
+		  return;
+	    if (profile_flag) profile_net_change(this);
+      }
 
       vvp_send_object(out_, val, context);
 }
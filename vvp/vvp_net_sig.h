@@ -451,6 +451,9 @@ class vvp_wire_vec4 : public vvp_wire_base {
       vvp_bit4_t driven_value(unsigned idx) const;
       bool is_forced(unsigned idx) const;
 
+	// Support for vpip_vector_view
+      const vvp_vector4_t& driven_vec4() const { return bits4_; }
+
     private:
       vvp_bit4_t filtered_value_(unsigned idx) const;
 
@@ -50,12 +50,17 @@ class vvp_vpi_callback {
 	// vpi to get at the vvp value of the object.
       virtual void get_value(struct t_vpi_value*value) =0;
 
+	// The generation counts the value changes of the object. A
+	// VPI client may poll it through vpip_vector_view.
+      const unsigned long*generation() const { return &generation_; }
+
     protected:
 	// Derived classes call this method to indicate that it is
 	// time to call the callback.
       void run_vpi_callbacks();
 
     private:
+      unsigned long generation_;
       value_callback*vpi_callbacks_;
       struct __vpiArray* array_;
       unsigned long array_word_;
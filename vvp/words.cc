@@ -189,6 +189,7 @@ void compile_variable(char*label, char*name,
       } else if (vpi_type_code == vpiIntVar) {
 	    net->fil = new vvp_wire_vec4(wid, BIT4_0);
             net->fun = new vvp_fun_signal4_sa(wid);
+	    compile_two_state_source(net);
       } else {
 	    net->fil = new vvp_wire_vec4(wid, BIT4_X);
             net->fun = new vvp_fun_signal4_sa(wid);
@@ -335,6 +336,7 @@ static void do_compile_net(vvp_net_t*node, vvp_array_t array,
 	    switch (vpi_type_code) {
 		case vpiIntVar:
 		  vsig = new vvp_wire_vec4(wid,BIT4_0);
+		  compile_two_state_source(node);
 		  break;
 		case vpiLogicVar:
 		  vsig = new vvp_wire_vec4(wid,BIT4_Z);